@@ -37,7 +37,10 @@
 #include "../game/game.h"
 #include "../ldp-out/ldp.h"	// to call pre_think
 #include "../timer/timer.h"
+#include "../timer/perfstats.h"
+#include "../timer/tracer.h"
 #include "../io/input.h"
+#include "../io/replay.h"
 #include "../io/conout.h"
 #include "../sound/sound.h"
 #include "6809infc.h"
@@ -121,6 +124,12 @@ void add (struct def *candidate)
 	cur->id = g_count;
 	g_count++;
 
+	// a cpu whose game didn't say otherwise has memory for its whole address bus
+	if (cur->mem_size == 0)
+	{
+		cur->mem_size = get_addressable(cur->type);
+	}
+
 	// DEFAULT VALUES
 	cur->ascii_info_callback = generic_ascii_info_stub;
 	cur->elapsedcycles_callback = generic_elapsedcycles_stub;
@@ -213,7 +222,9 @@ void add (struct def *candidate)
 		cur->reset_callback = i86_reset;
 		cur->ascii_info_callback = i86_info;
 		cur->dasm_callback = i86_dasm;
-		set_amask(0xFFFFF);	// 20-bit address space
+		// 20-bit address space, unless the board only decodes part of it in
+		// which case the rest mirrors what is there
+		set_amask(cur->mem_size - 1);
 		break;
 	default:
 		printline("FATAL ERROR : unknown cpu added");
@@ -383,6 +394,7 @@ void execute()
 	// loop until the quit flag is set which means the user wants to quit the program
 	while (!get_quitflag())
 	{
+		TRACE_SCOPE("cpu ms");
 		unsigned int actual_elapsed_ms = 0;
 		bool nmi_asserted = false;
 		Uint32 elapsed_cycles = 0;
@@ -620,6 +632,12 @@ void execute()
 
 		// 1 ms has elapsed, so notify the LDP to keep it in sync (we must do this after every ms)
 		g_ldp->pre_think();
+
+		// feed in any recorded input that is due
+		replay::think(g_ldp->get_elapsed_ms_since_start());
+
+		// and any live input that arrived during this ms
+		SDL_deliver_input();
  
 		// Update the sound buffers for the sound chips
         sound::update_buffer();
@@ -637,6 +655,7 @@ void execute()
 		if (actual_elapsed_ms > g_expected_elapsed_ms)
 		{
 			g_uCPUMsBehind = actual_elapsed_ms - g_expected_elapsed_ms;
+			perfstats::raise_value(perfstats::VALUE_CPU_MS_BEHIND_MAX, g_uCPUMsBehind);
 		}
 		// else we're caught up or ahead
 		else
@@ -644,12 +663,20 @@ void execute()
 			g_uCPUMsBehind = 0;
 
 			// if not enough time has elapsed, slow down
-			while (g_expected_elapsed_ms > actual_elapsed_ms)
+			// (unless we're supposed to run as fast as we can)
+			if ((g_expected_elapsed_ms > actual_elapsed_ms) && !get_unthrottled())
 			{
-				SDL_Delay(1);
-				actual_elapsed_ms = elapsed_ms_time(g_timer);
+				TRACE_SCOPE("pacing sleep");
+				Uint64 u64SleepNs = perfstats::get_ns();
+				do
+				{
+					SDL_Delay(1);
+					actual_elapsed_ms = elapsed_ms_time(g_timer);
+				} while (g_expected_elapsed_ms > actual_elapsed_ms);
+				perfstats::add_timing(perfstats::TIMING_PACING, perfstats::get_ns() - u64SleepNs);
 			}
 		}
+		perfstats::set_value(perfstats::VALUE_CPU_MS_BEHIND, g_uCPUMsBehind);
 
 #ifdef CPU_DIAG
 		// track ms that we slept
@@ -668,13 +695,25 @@ void execute()
 
 		do
 		{
-			// limit checks for input events to every 16 ms
+			// limit checks for input events to every INPUT_POLL_MS ms
 			//(this is really expensive in Windows for some reason)
+			// The events are queued and handed to the game at the emulated ms
+			//  they arrived on, so they don't all land on the same cycle.
 			actual_elapsed_ms = elapsed_ms_time(last_inputcheck);
-			if (actual_elapsed_ms > 16)
+			if (actual_elapsed_ms >= INPUT_POLL_MS)
 			{
 				last_inputcheck = refresh_ms_time();
-				SDL_check_input();	// check for input events (keyboard, joystick, etc)
+
+				// while paused, emulated time stands still, so nothing queued
+				//  would ever become due
+				if (g_paused)
+				{
+					SDL_check_input();
+				}
+				else
+				{
+					SDL_queue_input();	// check for input events (keyboard, joystick, etc)
+				}
 			}
 
 			// be nice to cpu if we're looping here ...
@@ -856,6 +895,40 @@ Uint8 *get_mem(Uint8 id)
 	return result;
 }
 
+// returns how big the memory for the indicated cpu is, or 0 if the cpu does not exist
+Uint32 get_mem_size(Uint8 id)
+{
+	Uint32 result = 0;
+	struct def *cpustruct = get_struct(id);
+
+	if (cpustruct)
+	{
+		result = cpustruct->mem_size;
+	}
+
+	return result;
+}
+
+Uint32 get_addressable(int type)
+{
+	Uint32 result = MEM_SIZE_16BIT;	// most of them
+
+	switch (type)
+	{
+	case type::X86:
+	case type::I88:
+		result = MEM_SIZE;
+		break;
+	case type::COP421:
+		result = 0x400;	// 10-bit program counter
+		break;
+	default:
+		break;
+	}
+
+	return result;
+}
+
 // returns the Hz of the CPU indicated, or 0 if the cpu does not exist
 Uint32 get_hz(Uint8 id)
 {
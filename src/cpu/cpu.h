@@ -34,6 +34,8 @@ namespace type
 
 // 1 meg for I86
 static const int MEM_SIZE =	0x100000;
+// 64k for the cpu's with a 16-bit address bus
+static const int MEM_SIZE_16BIT = 0x10000;
 /* max # of bytes that a cpu context can have */
 static const int MAX_CONTEXT_SIZE = 128;
 /* how many IRQs we will support per CPU */
@@ -52,6 +54,7 @@ struct def
 	double nmi_period;	// how often the NMI ticks (in milliseconds, not seconds)
 	double irq_period[MAX_IRQS];	// how often the IRQs tick (in milliseconds, not seconds)
 	Uint8 *mem;	// where the cpu's memory begins
+	Uint32 mem_size;	// how big 'mem' is, a power of 2 (0 means all the cpu type can address)
 
 	// these should not be modified externally
 	Uint8 id;	// which we are adding
@@ -105,6 +108,10 @@ Uint64 get_total_cycles_executed(Uint8 id);
 struct def * get_struct(Uint8 id);
 unsigned char get_active();
 Uint8 *get_mem(Uint8 id);
+Uint32 get_mem_size(Uint8 id);
+
+// how much memory a cpu of type 'type' can address
+Uint32 get_addressable(int type);
 Uint32 get_hz(Uint8 id);
 
 void change_nmi(Uint8 id, double new_period);
@@ -1444,7 +1444,7 @@ unsigned DasmI86(char* buffer, unsigned pc)
 	/* kludge to avoid crashes with e.g. qbert */
 	for (c = 0;c < 20;c++)
 	{
-		int pc_masked = (pc+c)&0xfffff;
+		int pc_masked = (pc+c)&memory_amask;
 		change_pc20(pc_masked);
 		map[c] = OP_ROM[pc_masked];
 	}
@@ -25,7 +25,7 @@
 
 // basically just starts playing the disc :)
 // Used to test VLDP efficiency
-// VLDP must be recompiled to enable framerate reporting
+// Run it with -benchmark to get a framerate report
 
 #include "config.h"
 
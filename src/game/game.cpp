@@ -35,6 +35,7 @@
 #include "../io/unzip.h"
 #include "../io/mpo_fileio.h"
 #include "../io/mpo_mem.h" // for better malloc
+#include "../io/rom_cache.h"
 #include "../io/numstr.h"
 #include "../ldp-out/ldp.h"
 #include "../cpu/cpu-debug.h" // for set_cpu_trace
@@ -78,7 +79,7 @@ void g_cpu_break(char *s)
 ///////////////////////////////////////////////////////////
 
 game::game()
-    : m_game_paused(false),
+    : m_game_paused(false), m_cpumem(NULL), m_cpumem_size(0),
       m_game_uses_video_overlay(true), // since most games do use video overlay,
                                        // we'll default this to true
       m_overlay_size_is_dynamic(false), // the overlay size is usually static
@@ -101,6 +102,9 @@ game::game()
                                           // overlay
       m_bMouseEnabled(false)              // mouse is disabled for most games
 {
+    // enough for a 16-bit address bus, the 8088 games ask for more
+    set_cpumem_size(cpu::MEM_SIZE_16BIT);
+
     memset(m_video_overlay, 0, sizeof(m_video_overlay)); // clear this structure
                                                          // so we can easily
                                                          // detect whether we
@@ -160,6 +164,15 @@ game::game()
 
 game::~game()
 {
+    MPO_FREE(m_cpumem);
+}
+
+void game::set_cpumem_size(Uint32 size)
+{
+    MPO_FREE(m_cpumem);
+    m_cpumem      = MPO_MALLOC(size);
+    m_cpumem_size = size;
+    memset(m_cpumem, 0, size);
 }
 
 // call this instead of init() directly to ensure that some universal stuff gets
@@ -265,14 +278,19 @@ void game::do_nmi()
 // reads a byte from a 16-bit address space
 Uint8 game::cpu_mem_read(Uint16 addr) { return m_cpumem[addr]; }
 
-// reads a byte from a 32-bit address space
-Uint8 game::cpu_mem_read(Uint32 addr) { return m_cpumem[addr]; }
+// reads a byte from a 32-bit address space (anything past the end of m_cpumem
+// mirrors what is in it, like it does on a board that doesn't decode every
+// address line)
+Uint8 game::cpu_mem_read(Uint32 addr) { return m_cpumem[addr & (m_cpumem_size - 1)]; }
 
 // writes a byte to a 16-bit addresss space
 void game::cpu_mem_write(Uint16 addr, Uint8 value) { m_cpumem[addr] = value; }
 
 // writes a byte to a 32-bit address space
-void game::cpu_mem_write(Uint32 addr, Uint8 value) { m_cpumem[addr] = value; }
+void game::cpu_mem_write(Uint32 addr, Uint8 value)
+{
+    m_cpumem[addr & (m_cpumem_size - 1)] = value;
+}
 
 // reads a byte from the cpu's port
 Uint8 game::port_read(Uint16 port)
@@ -701,11 +719,19 @@ bool game::load_roms()
                                         // open)
         unzFile zip_file = NULL; // pointer to open zip file (NULL if file is
                                  // closed)
+        bool zip_tried   = false; // whether we tried to open opened_zip_name
+
+        // the images already inflated out of the zip file on an earlier run
+        RomCache rom_cache(g_homedir.get_homedir() + "/romcache");
+        unsigned int cached_count = 0;
+        Uint32 start_ms           = SDL_GetTicks();
 
         // go until we get an error or we run out of roms to load
         do {
             string path, zip_path = "";
             unsigned int crc      = crc32(0L, Z_NULL, 0);
+            bool cached           = false;
+            bool from_zip         = false;
 
             // if this game explicitely specifies a subdirectory
             if (rom->dir) {
@@ -722,34 +748,31 @@ bool game::load_roms()
             // Use homedir to locate the compressed rom
             zip_path = g_homedir.get_romfile(zip_path);
 
-            // if we have not opened a ZIP file, or if we need to open a new zip
-            // file ...
-            if ((!zip_file) || (zip_path.compare(opened_zip_name) != 0)) {
-                // if we need to open a zip file ...
-                if (!zip_file) {
-                    zip_file = unzOpen(zip_path.c_str());
-                }
-
-                // we need to open a different zip file ...
-                else {
-                    //					string s = "Closing " + opened_zip_name + " and
-                    //attempting to open " + zip_path;	// just for debugging to
-                    //make sure this is behaving properly
+            // if we need to move on to a different zip file ...
+            if (zip_path.compare(opened_zip_name) != 0) {
+                if (zip_file) {
                     unzClose(zip_file);
-                    zip_file = unzOpen(zip_path.c_str());
+                    zip_file = NULL;
                 }
+                rom_cache.Open(zip_path);
+                opened_zip_name = zip_path;
+                zip_tried       = false;
+            }
 
-                // if we successfully opened the file ...
-                if (zip_file) {
-                    opened_zip_name = zip_path;
-                }
+            // the cache is only good if the zip file hasn't changed since, so
+            // there's no need to open it at all unless something is missing
+            result = cached = rom_cache.Load(rom->filename, rom->buf, rom->size, crc);
+
+            if (!result && !zip_tried) {
+                zip_file  = unzOpen(zip_path.c_str());
+                zip_tried = true;
             }
 
-            result = false;
             // if we have a zip file open, try to load the ROM from this file
             // first ...
-            if (zip_file) {
-                result = load_compressed_rom(rom->filename, zip_file, rom->buf, rom->size);
+            if (!result && zip_file) {
+                result = from_zip =
+                    load_compressed_rom(rom->filename, zip_file, rom->buf, rom->size);
             }
 
             // if we were unable to open the rom from a zip file, try to open it
@@ -760,9 +783,18 @@ bool game::load_roms()
 
             // if file was loaded and was proper length, check CRC
             if (result) {
+                if (cached) {
+                    cached_count++;
+                } else if (from_zip) {
+                    // the cache needs the CRC whether it gets checked or not
+                    crc = crc32(crc, rom->buf, rom->size);
+                    rom_cache.Add(rom->filename, rom->buf, rom->size, crc);
+                } else if (!m_crc_disabled) {
+                    crc = crc32(crc, rom->buf, rom->size);
+                }
+
                 if (!m_crc_disabled) // skip if user doesn't care
                 {
-                    crc = crc32(crc, rom->buf, rom->size);
                     if (rom->crc32 == 0) // skip if crc is set to 0 (game driver
                                          // doesn't care)
                     {
@@ -813,6 +845,10 @@ bool game::load_roms()
             unzClose(zip_file);
             zip_file = NULL;
         }
+        rom_cache.Close();
+
+        LOGI << fmt("ROMs loaded in %u ms (%u from the ROM cache)",
+                    SDL_GetTicks() - start_ms, cached_count);
 
         patch_roms();
     }
@@ -81,7 +81,7 @@ enum {
 
 #include <SDL.h>
 #include "../sound/sound.h"
-#include "../cpu/cpu.h"  // for cpu::MEM_SIZE
+#include "../cpu/cpu.h"  // for cpu::MEM_SIZE_16BIT
 #include "../io/input.h" // for SWITCH definitions, most/all games need them
 
 typedef void *unzFile; // because including the unzip header file gives some
@@ -323,8 +323,14 @@ class game
                                  // "ace" "dle", etc)
     const struct rom_def *m_rom_list; // pointer to a null-terminated array of
                                       // roms to be loaded
-    Uint8 m_cpumem[cpu::MEM_SIZE]; // generic buffer that most 16-bit addressing
-                                   // cpu's can use
+    Uint8 *m_cpumem; // generic buffer that most 16-bit addressing cpu's can use
+    Uint32 m_cpumem_size; // how big m_cpumem is (MEM_SIZE_16BIT unless the game
+                          // changes it)
+
+    // Re-allocates m_cpumem (zeroed) for a cpu with a bigger address bus.
+    // Must be called at the start of the constructor, before anything points
+    // into m_cpumem.
+    void set_cpumem_size(Uint32 size);
     unsigned int m_uDiscFPKS; // frames per kilosecond of the game's laserdisc
                               // (to avoid using gp2x-unfriendly float)
     double m_disc_fps; // frames per second of the game's laserdisc; (only used
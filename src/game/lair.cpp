@@ -59,7 +59,6 @@ bool g_bBootLog = true;
 lair::lair() : m_bUseAnnunciator(false), m_pScoreboard(NULL)
 {
     m_shortgamename = "lair";
-    memset(m_cpumem, 0, cpu::MEM_SIZE);
     m_switchA      = 0x22;
     m_switchB      = 0xD8;
     m_joyskill_val = 0xFF; // all input cleared
@@ -210,8 +210,8 @@ lair2::lair2()
       // serial hack isn't proper emulation, so it is disabled by default
       m_bSerialHack(false)
 {
+    set_cpumem_size(cpu::get_addressable(cpu::type::I88));
     m_shortgamename = "lair2";
-    memset(m_cpumem, 0, cpu::MEM_SIZE);
     memset(EEPROM_9536, 0, sizeof(EEPROM_9536));
     m_uCoinCount[0] = m_uCoinCount[1] = 0;
     banks[0] = 0xff; // bank 0 is active low
@@ -77,7 +77,6 @@
 mach3::mach3()
 {
     m_shortgamename = "mach3";
-    memset(m_cpumem, 0, sizeof(m_cpumem));
     memset(m_cpumem2, 0, sizeof(m_cpumem2));
     memset(m_cpumem3, 0, sizeof(m_cpumem3));
 
@@ -95,6 +94,9 @@ mach3::mach3()
     // but we'll just access it from here
     cpu.must_copy_context = false;
     cpu.mem = m_cpumem;
+    cpu.mem_size = cpu::MEM_SIZE_16BIT; // the board only decodes 16 address
+                                        // lines, the rest of the 8088's 1 meg
+                                        // mirrors these 64k
     cpu::add(&cpu); // add this cpu to the list (it will be our only one)
 
     cpu.type              = cpu::type::M6502;
@@ -105,6 +107,7 @@ mach3::mach3()
     cpu.must_copy_context = true; // set this to true when you add multiple
                                   // 6502's
     cpu.mem = m_cpumem2;
+    cpu.mem_size = 0;
     cpu::add(&cpu); // add first sound 6502 cpu
 
     cpu.type          = cpu::type::M6502;
@@ -269,14 +272,8 @@ uvt::uvt()
          {"usvsdrom.1", NULL, &m_cpumem2[0xE000], 0x2000, 0xc0b5cab0},
          {"usvsyrom.1", NULL, &m_cpumem3[0xE000], 0x2000, 0xc3d245ca},
 
-         // sometimes UVT accesses the same memory from the E000:xxxx segment
-         // (the mirrored segment code in cpu_mem_read should eliminate the need
-         // for these copies, but it isn't doing so...)
-         {"usvs.rm4", NULL, &m_cpumem[0x000E6000], 0x2000, 0x0d7a4072},
-         {"usvs.rm3", NULL, &m_cpumem[0x000E8000], 0x2000, 0x6f32a671},
-         {"usvs.rm2", NULL, &m_cpumem[0x000EA000], 0x2000, 0x36770716},
-         {"usvs.rm1", NULL, &m_cpumem[0x000EC000], 0x2000, 0x697bc989},
-         {"usvs.rm0", NULL, &m_cpumem[0x000EE000], 0x2000, 0x30cf6bd9},
+         // UVT sometimes runs code from the E000:xxxx segment, which the 8088's
+         // address mask folds back onto the copies above
 
          {"usvs.fg3", NULL, &sprite[0x0000], 0x4000, 0x98703015},
          {"usvs.fg2", NULL, &sprite[0x4000], 0x4000, 0xd3990707},
@@ -137,6 +137,7 @@ bool singe::init()
         g_SingeIn.samples_is_playing = samples::is_playing;
         g_SingeIn.samples_end_early = samples::end_early;
         g_SingeIn.samples_flush_queue = samples::flush_queue;
+        g_SingeIn.samples_convert = samples::convert;
 
         // These functions allow the DLL side of SINGE
         // call the functions set_keyboard_mode and get_keyboard_mode inside
@@ -213,6 +214,8 @@ void singe::start()
     printline(s1);
     g_pSingeOut->sep_set_surface(m_video_overlay_width, m_video_overlay_height);
     g_pSingeOut->sep_set_static_pointers(&m_disc_fps, &m_uDiscFPKS);
+    if (!m_strProfilePath.empty())
+        g_pSingeOut->sep_set_profile_path(m_strProfilePath.c_str());
     g_pSingeOut->sep_startup(m_strGameScript.c_str());
     bool blanking = g_local_info.blank_during_searches | g_local_info.blank_during_skips;
     int delay = g_ldp->get_min_seek_delay() >> 6;
@@ -229,7 +232,7 @@ void singe::start()
     if (!get_quitflag()) {
 
         while (!get_quitflag()) {
-            g_pSingeOut->sep_call_lua("onOverlayUpdate", ">i", &intReturn);
+            intReturn = g_pSingeOut->sep_on_overlay_update();
             if (intReturn == 1) {
                 m_video_overlay_needs_update = true;
             }
@@ -289,7 +292,7 @@ void singe::input_enable(Uint8 input, Sint8 mouseID)
     }
 
     if (g_pSingeOut) // by RDG2010
-        g_pSingeOut->sep_call_lua("onInputPressed", "ii", input, mouseID);
+        g_pSingeOut->sep_on_input(input, mouseID, true);
 }
 
 void singe::input_disable(Uint8 input, Sint8 mouseID)
@@ -310,7 +313,7 @@ void singe::input_disable(Uint8 input, Sint8 mouseID)
     }
 
     if (g_pSingeOut) // by RDG2010
-        g_pSingeOut->sep_call_lua("onInputReleased", "ii", input, mouseID);
+        g_pSingeOut->sep_on_input(input, mouseID, false);
 }
 
 void singe::OnMouseMotion(Uint16 x, Uint16 y, Sint16 xrel, Sint16 yrel, Sint8 mouseID)
@@ -487,6 +490,16 @@ bool singe::handle_cmdline_arg(const char *arg)
         } else
             printerror("SINGE: ratio should be a float");
     }
+    else if (strcasecmp(arg, "-profile_lua") == 0) {
+        get_next_word(s, sizeof(s));
+
+        if (s[0] != 0) {
+            m_strProfilePath = s;
+            bResult = true;
+        } else {
+            printerror("SINGE: -profile_lua expects a file name");
+        }
+    }
     else if (strcasecmp(arg, "-js_range") == 0) {
         get_next_word(s, sizeof(s));
         i = atoi(s);
@@ -96,6 +96,11 @@ class singe : public game
     }
     static uint32_t get_current_frame()
     {
+        // while a search finishes in the background, scripts should already
+        // see the frame they asked for
+        if (g_ldp->is_search_pending())
+            return g_ldp->get_search_target_frame();
+
         return g_ldp->get_current_frame();
     }
     static void pre_play() { g_ldp->pre_play(); }
@@ -103,6 +108,10 @@ class singe : public game
     static void pre_stop() { g_ldp->pre_stop(); }
     static bool pre_search(const char *cpszFrame, bool block_until_search_finished)
     {
+        // -blocking brings back the old behaviour
+        if (!g_ldp->get_use_nonblocking_searching())
+            block_until_search_finished = true;
+
         return g_ldp->pre_search(cpszFrame, block_until_search_finished);
     }
     static void framenum_to_frame(Uint32 u32Frame, char *pszFrame)
@@ -191,6 +200,7 @@ class singe : public game
 
     string m_strName;       // name of the game
     string m_strGameScript; // script name for the game
+    string m_strProfilePath; // where to write the Lua profile (-profile_lua)
 
     DLL_INSTANCE m_dll_instance; // pointer to DLL we load (if we aren't
                                  // statically linked)
@@ -2,7 +2,7 @@
 #define SINGE_INTERFACE_H
 
 // increase this number every time you change something in this file!!!
-#define SINGE_INTERFACE_API_VERSION 6
+#define SINGE_INTERFACE_API_VERSION 9
 
 #define SINGE_ERROR_INIT      0xA0
 #define SINGE_ERROR_RUNTIME   0xA1
@@ -36,6 +36,7 @@ struct singe_in_info
 	bool (*samples_is_playing) (unsigned int);
 	bool (*samples_end_early) (unsigned int);
 	void (*samples_flush_queue)();
+	bool (*samples_convert)(const SDL_AudioSpec *pSpec, Uint8 **ppu8Buf, Uint32 *puLength);
 
 	// Laserdisc Control Functions
 	void (*enable_audio1)();
@@ -103,6 +104,11 @@ struct singe_out_info
 	void (*sep_no_crosshair)(void);
 	void (*sep_upgrade_overlay)(void);
 	void (*sep_overlay_resize)(void);
+	void (*sep_set_profile_path)(const char *path);
+
+	// faster equivalents of sep_call_lua() for the per-frame and input callbacks
+	int (*sep_on_overlay_update)(void);
+	void (*sep_on_input)(int input, int mouseID, bool pressed);
 	
 	////////////////////////////////////////////////////////////
 };
@@ -0,0 +1,327 @@
+/*
+ * singeprofiler.cpp
+ *
+ * Copyright (C) 2026 Hypseus Singe contributors
+ *
+ * This file is part of HYPSEUS, a laserdisc arcade game emulator
+ *
+ * HYPSEUS is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * HYPSEUS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "singeprofiler.h"
+#include "singeproxy.h"
+
+#include <SDL.h>
+#include <stdio.h>
+#include <string.h>
+#include <algorithm>
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+////////////////////////////////////////////////////////////////////////////////
+
+// how many Lua VM instructions between samples
+#define SEP_PROF_SAMPLE_COUNT 1000
+
+// latency histogram buckets: bucket i counts calls that took less than 2^i
+// microseconds (the last one counts everything slower)
+#define SEP_PROF_BUCKETS 21
+
+typedef struct g_profStatsType {
+	Uint64 calls;
+	Uint64 totalNs;
+	Uint64 maxNs;
+	Uint64 buckets[SEP_PROF_BUCKETS];
+} g_profStatsT;
+
+typedef struct g_profFuncType {
+	string        name;
+	lua_CFunction fn;
+	g_profStatsT  stats;
+} g_profFuncT;
+
+typedef struct g_profCallbackType {
+	string name;
+	Uint64 startNs;
+} g_profCallbackT;
+
+bool                     g_profEnabled = false;
+lua_State               *g_profLua     = NULL;
+string                   g_profReportPath;
+set<string>              g_profBuiltins;   // Lua's own functions (not wrapped)
+vector<g_profFuncT>      g_profFuncs;      // every wrapped API function
+map<string, g_profStatsT> g_profCallbacks;
+vector<g_profCallbackT>  g_profCallStack;  // callbacks currently running
+map<string, Uint64>      g_profFolded;     // stack -> nanoseconds
+Uint64                   g_profLastNs  = 0; // when time was last attributed
+Uint64                   g_profStartNs = 0;
+
+////////////////////////////////////////////////////////////////////////////////
+
+static Uint64 sep_prof_ns()
+{
+	static const double dNsPerTick = 1000000000.0 / (double)SDL_GetPerformanceFrequency();
+	return (Uint64)((double)SDL_GetPerformanceCounter() * dNsPerTick);
+}
+
+static void sep_prof_add(g_profStatsT &stats, Uint64 ns)
+{
+	Uint64 us = ns / 1000;
+	int bucket = 0;
+
+	while ((bucket < SEP_PROF_BUCKETS - 1) && (((Uint64)1 << bucket) <= us))
+		bucket++;
+
+	stats.calls++;
+	stats.totalNs += ns;
+	if (ns > stats.maxNs) stats.maxNs = ns;
+	stats.buckets[bucket]++;
+}
+
+// the Lua call stack, outermost first, in folded stack format
+static string sep_prof_stack(lua_State *L)
+{
+	vector<string> frames;
+	lua_Debug ar;
+	char s[256];
+
+	for (int level = 0; lua_getstack(L, level, &ar); level++) {
+		lua_getinfo(L, "Sn", &ar);
+
+		// C functions are added by their wrapper, if we care about them
+		if (strcmp(ar.what, "C") == 0) continue;
+
+		if (ar.name) {
+			snprintf(s, sizeof(s), "%s", ar.name);
+		} else if (strcmp(ar.what, "main") == 0) {
+			snprintf(s, sizeof(s), "(main chunk)");
+		} else {
+			snprintf(s, sizeof(s), "%s:%d", ar.short_src, ar.linedefined);
+		}
+
+		// ';' separates the frames
+		for (char *p = s; *p; p++)
+			if (*p == ';') *p = ',';
+
+		frames.push_back(s);
+	}
+
+	string result = g_profCallStack.empty() ? "(no callback)" : g_profCallStack.back().name;
+	for (vector<string>::reverse_iterator i = frames.rbegin(); i != frames.rend(); ++i) {
+		result += ";";
+		result += *i;
+	}
+
+	return result;
+}
+
+// gives the time since the last attribution to whatever Lua is running now
+static void sep_prof_attribute(lua_State *L)
+{
+	Uint64 now = sep_prof_ns();
+	g_profFolded[sep_prof_stack(L)] += now - g_profLastNs;
+	g_profLastNs = now;
+}
+
+static void sep_prof_hook(lua_State *L, lua_Debug *)
+{
+	sep_prof_attribute(L);
+}
+
+// stands in for every API function while profiling
+static int sep_prof_call(lua_State *L)
+{
+	size_t idx = (size_t)lua_tointeger(L, lua_upvalueindex(1));
+
+	// whatever Lua did up to here is Lua's
+	sep_prof_attribute(L);
+
+	Uint64 start  = g_profLastNs;
+	int    result = g_profFuncs[idx].fn(L);
+	Uint64 now    = sep_prof_ns();
+
+	sep_prof_add(g_profFuncs[idx].stats, now - start);
+	g_profFolded[sep_prof_stack(L) + ";" + g_profFuncs[idx].name] += now - start;
+	g_profLastNs = now;
+
+	return result;
+}
+
+static bool sep_prof_by_time(const pair<string, const g_profStatsT *> &a,
+                             const pair<string, const g_profStatsT *> &b)
+{
+	return a.second->totalNs > b.second->totalNs;
+}
+
+static void sep_prof_write_histograms(FILE *F)
+{
+	vector< pair<string, const g_profStatsT *> > all;
+
+	for (size_t x = 0; x < g_profFuncs.size(); x++)
+		if (g_profFuncs[x].stats.calls)
+			all.push_back(make_pair(g_profFuncs[x].name, &g_profFuncs[x].stats));
+
+	for (map<string, g_profStatsT>::const_iterator i = g_profCallbacks.begin(); i != g_profCallbacks.end(); ++i)
+		all.push_back(make_pair(i->first + " (callback)", &i->second));
+
+	sort(all.begin(), all.end(), sep_prof_by_time);
+
+	fprintf(F, "Singe profile, %.1f ms of wall time\n\n", (sep_prof_ns() - g_profStartNs) / 1000000.0);
+	fprintf(F, "%-32s %10s %12s %10s %10s\n", "function", "calls", "total ms", "avg us", "max us");
+
+	for (size_t x = 0; x < all.size(); x++) {
+		const g_profStatsT &stats = *all[x].second;
+
+		fprintf(F, "%-32s %10llu %12.3f %10.1f %10.1f\n", all[x].first.c_str(),
+			(unsigned long long)stats.calls, stats.totalNs / 1000000.0,
+			(stats.totalNs / 1000.0) / stats.calls, stats.maxNs / 1000.0);
+
+		// only the buckets that got used
+		fprintf(F, "   ");
+		for (int b = 0; b < SEP_PROF_BUCKETS; b++) {
+			if (!stats.buckets[b]) continue;
+			if (b < SEP_PROF_BUCKETS - 1)
+				fprintf(F, " <%uus:%llu", 1u << b, (unsigned long long)stats.buckets[b]);
+			else
+				fprintf(F, " slower:%llu", (unsigned long long)stats.buckets[b]);
+		}
+		fprintf(F, "\n");
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void sep_profiler_start(lua_State *L, const char *pszReportPath)
+{
+	g_profLua        = L;
+	g_profReportPath = pszReportPath;
+	g_profEnabled    = true;
+
+	// Lua's own functions stay as they are; wrapping pcall and friends would
+	// count the Lua code they run twice
+	g_profBuiltins.clear();
+	lua_pushnil(L);
+	while (lua_next(L, LUA_GLOBALSINDEX) != 0) {
+		if (lua_type(L, -2) == LUA_TSTRING)
+			g_profBuiltins.insert(lua_tostring(L, -2));
+		lua_pop(L, 1);
+	}
+
+	g_profStartNs = g_profLastNs = sep_prof_ns();
+	lua_sethook(L, sep_prof_hook, LUA_MASKCOUNT, SEP_PROF_SAMPLE_COUNT);
+}
+
+void sep_profiler_wrap_api(lua_State *L)
+{
+	if (!g_profEnabled) return;
+
+	// collect them first, the globals table can't change while we walk it
+	vector<string> names;
+	lua_pushnil(L);
+	while (lua_next(L, LUA_GLOBALSINDEX) != 0) {
+		if ((lua_type(L, -2) == LUA_TSTRING) && lua_iscfunction(L, -1) &&
+			(g_profBuiltins.find(lua_tostring(L, -2)) == g_profBuiltins.end()))
+			names.push_back(lua_tostring(L, -2));
+		lua_pop(L, 1);
+	}
+
+	for (size_t x = 0; x < names.size(); x++) {
+		g_profFuncT func;
+
+		lua_getglobal(L, names[x].c_str());
+		func.name = names[x];
+		func.fn   = lua_tocfunction(L, -1);
+		memset(&func.stats, 0, sizeof(func.stats));
+		lua_pop(L, 1);
+
+		g_profFuncs.push_back(func);
+
+		lua_pushinteger(L, (lua_Integer)(g_profFuncs.size() - 1));
+		lua_pushcclosure(L, sep_prof_call, 1);
+		lua_setglobal(L, names[x].c_str());
+	}
+}
+
+bool sep_profiler_enabled()
+{
+	return g_profEnabled;
+}
+
+void sep_profiler_callback_begin(const char *pszName)
+{
+	if (!g_profEnabled) return;
+
+	g_profCallbackT callback;
+	callback.name    = pszName;
+	callback.startNs = sep_prof_ns();
+
+	// time spent outside of Lua isn't the script's fault
+	g_profLastNs = callback.startNs;
+	g_profCallStack.push_back(callback);
+}
+
+void sep_profiler_callback_end()
+{
+	if (!g_profEnabled || g_profCallStack.empty()) return;
+
+	Uint64 now = sep_prof_ns();
+	const g_profCallbackT &callback = g_profCallStack.back();
+
+	// whatever ran since the last sample
+	g_profFolded[callback.name] += now - g_profLastNs;
+
+	g_profStatsT &stats = g_profCallbacks[callback.name];
+	if (stats.calls == 0) memset(&stats, 0, sizeof(stats));
+	sep_prof_add(stats, now - callback.startNs);
+
+	g_profCallStack.pop_back();
+	g_profLastNs = now;
+}
+
+void sep_profiler_stop()
+{
+	if (!g_profEnabled) return;
+
+	lua_sethook(g_profLua, NULL, 0, 0);
+	g_profEnabled = false;
+
+	FILE *F = fopen(g_profReportPath.c_str(), "w");
+	if (F) {
+		for (map<string, Uint64>::const_iterator i = g_profFolded.begin(); i != g_profFolded.end(); ++i) {
+			Uint64 us = i->second / 1000;
+			if (us) fprintf(F, "%s %llu\n", i->first.c_str(), (unsigned long long)us);
+		}
+		fclose(F);
+	}
+
+	string strHistograms = g_profReportPath + ".txt";
+	FILE *H = fopen(strHistograms.c_str(), "w");
+	if (H) {
+		sep_prof_write_histograms(H);
+		fclose(H);
+	}
+
+	if (!F || !H)
+		sep_print("could not write the profile to %s", g_profReportPath.c_str());
+
+	g_profFuncs.clear();
+	g_profCallbacks.clear();
+	g_profCallStack.clear();
+	g_profFolded.clear();
+}
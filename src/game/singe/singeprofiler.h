@@ -0,0 +1,61 @@
+/*
+ * singeprofiler.h
+ *
+ * Copyright (C) 2026 Hypseus Singe contributors
+ *
+ * This file is part of HYPSEUS, a laserdisc arcade game emulator
+ *
+ * HYPSEUS is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * HYPSEUS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef SINGEPROFILER_H
+#define SINGEPROFILER_H
+
+// Opt-in profiler for Singe scripts (-profile_lua <file>).
+//
+// Time is attributed to Lua call stacks, each one starting with the callback
+// Hypseus called into (onOverlayUpdate, onInputPressed, ...).  Lua code is
+// sampled with a count hook, and every C function the script can call is
+// wrapped so that time spent in it (drawing sprites, searching the disc, ...)
+// shows up as a frame of its own.
+//
+// At shutdown two reports are written:
+//  <file>       folded stacks weighted by microseconds (feed it to
+//               flamegraph.pl or speedscope)
+//  <file>.txt   call counts and latency histograms for every API function and
+//               callback
+
+extern "C" {
+#include "lua.h"
+}
+
+// Starts profiling 'L'.  Call it right after luaL_openlibs() so that Lua's own
+// functions can be told apart from the Singe API.
+void sep_profiler_start(lua_State *L, const char *pszReportPath);
+
+// Wraps every C function registered since sep_profiler_start().  Call it after
+// the API has been registered but before the script runs.
+void sep_profiler_wrap_api(lua_State *L);
+
+bool sep_profiler_enabled();
+
+// bracket every call from Hypseus into the script
+void sep_profiler_callback_begin(const char *pszName);
+void sep_profiler_callback_end();
+
+// writes the reports and stops profiling
+void sep_profiler_stop();
+
+#endif // SINGEPROFILER_H
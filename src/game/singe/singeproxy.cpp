@@ -22,10 +22,12 @@
 
 #include "singeproxy.h"
 #include "singe_interface.h"
+#include "singeprofiler.h"
 
 #include "../../video/video.h"
 #include "../../sound/sound.h"
 
+#include <string>
 #include <vector>
 
 using namespace std;
@@ -49,6 +51,30 @@ unsigned int *g_se_uDiscFPKS;
 
 // used to know whether try to shutdown lua would crash
 bool g_bLuaInitialized = false;
+string g_strProfilePath;   // where -profile_lua wants its reports
+
+// The callbacks Hypseus calls all the time are kept as registry references
+// instead of being looked up by name on every call.  The globals table is
+// left alone; once a frame each reference is checked against what the script
+// has under that name now, so redefining a callback takes effect by the next
+// frame.
+enum
+{
+	SEP_CB_OVERLAY_UPDATE = 0,
+	SEP_CB_INPUT_PRESSED,
+	SEP_CB_INPUT_RELEASED,
+	SEP_CB_MOUSE_MOVED,
+	SEP_CB_SOUND_COMPLETED,
+	SEP_CB_COUNT
+};
+
+const char *g_callbackNames[SEP_CB_COUNT] = {
+	"onOverlayUpdate", "onInputPressed", "onInputReleased", "onMouseMoved", "onSoundCompleted"
+};
+int  g_callbackRef[SEP_CB_COUNT];
+bool g_callbacksResolved = false;
+
+unsigned char g_luaErrors = 0;  // consecutive script errors
 
 bool g_se_saveme = true;
 
@@ -73,6 +99,38 @@ bool                  g_fullsize_overlay    = false;
 bool                  g_show_crosshair      = true;
 bool                  g_not_cursor          = true;
 
+// Strings rendered by fontPrint.  HUD text is redrawn every frame but hardly
+// ever changes, so it only has to be rasterized once.
+#define SEP_TEXT_CACHE_SIZE 32
+typedef struct g_textCacheType {
+	TTF_Font     *font;
+	int           quality;
+	SDL_Color     fg;
+	SDL_Color     bg;
+	string        text;
+	SDL_Surface  *surface;
+	Uint32        lastUsed;
+} g_textCacheT;
+vector<g_textCacheT>  g_textCache;
+Uint32                g_textCacheUseCount   = 0;
+
+// Glyphs rendered by fontPrint, one set per font, quality and colours.  A
+// string that isn't in the text cache (a score that just went up, say) is put
+// together from these rather than being rasterized again by SDL_ttf.
+#define SEP_GLYPH_CACHE_SIZE 8
+typedef struct g_glyphCacheType {
+	TTF_Font     *font;
+	int           quality;
+	SDL_Color     fg;
+	SDL_Color     bg;
+	SDL_Surface  *glyph[256];
+	int           minx[256];
+	int           advance[256];
+	bool          loaded[256];
+	Uint32        lastUsed;
+} g_glyphCacheT;
+vector<g_glyphCacheT> g_glyphCache;
+
 int (*g_original_prepare_frame)(uint8_t *Yplane, uint8_t *Uplane, uint8_t *Vplane,
                int Ypitch, int Upitch, int Vpitch);
 
@@ -102,6 +160,9 @@ SINGE_EXPORT const struct singe_out_info *singeproxy_init(const struct singe_in_
 	g_SingeOut.sep_no_crosshair        = sep_no_crosshair;
 	g_SingeOut.sep_upgrade_overlay     = sep_upgrade_overlay;
 	g_SingeOut.sep_overlay_resize      = sep_overlay_resize;
+	g_SingeOut.sep_set_profile_path    = sep_set_profile_path;
+	g_SingeOut.sep_on_overlay_update   = sep_on_overlay_update;
+	g_SingeOut.sep_on_input            = sep_on_input;
 	
 	result = &g_SingeOut;
 	
@@ -133,7 +194,6 @@ void sep_call_lua(const char *func, const char *sig, ...)
 	int narg, nres;  /* number of arguments and results */
 	int popCount;
 	const int top = lua_gettop(g_se_lua_context);
-	static unsigned char e;
 	
 	va_start(vl, sig);
 	
@@ -174,12 +234,15 @@ void sep_call_lua(const char *func, const char *sig, ...)
     
 	/* do the call */
 	popCount = nres = strlen(sig);  /* number of expected results */
+	sep_profiler_callback_begin(func);
 	if (lua_pcall(g_se_lua_context, narg, nres, 0) != 0) { /* do the call */
+		sep_profiler_callback_end();
 		sep_print("error running function '%s': %s", func, lua_tostring(g_se_lua_context, -1));
-		if (e) { sep_die("Multiple errors, cannot continue..."); exit(SINGE_ERROR_RUNTIME); }
-		e++;
+		if (g_luaErrors) { sep_die("Multiple errors, cannot continue..."); exit(SINGE_ERROR_RUNTIME); }
+		g_luaErrors++;
 		return;
 	}
+	sep_profiler_callback_end();
 	
 	/* retrieve results */
 	nres = -nres;  /* stack index of first result */
@@ -210,12 +273,114 @@ void sep_call_lua(const char *func, const char *sig, ...)
 		nres++;
 	}
 	va_end(vl);
-	e = 0;
+	g_luaErrors = 0;
 	
 	if (popCount > 0)
 		lua_pop(g_se_lua_context, popCount);
 }
 
+// Takes references to the callbacks the script has defined (raw lookups, so a
+// metatable on the globals table never gets involved).
+static void sep_resolve_callbacks(lua_State *L)
+{
+	for (int cb = 0; cb < SEP_CB_COUNT; cb++) {
+		lua_pushstring(L, g_callbackNames[cb]);
+		lua_rawget(L, LUA_GLOBALSINDEX);
+		if (lua_isfunction(L, -1)) {
+			g_callbackRef[cb] = luaL_ref(L, LUA_REGISTRYINDEX);
+		} else {
+			lua_pop(L, 1);
+			g_callbackRef[cb] = LUA_NOREF;
+		}
+	}
+
+	g_callbacksResolved = true;
+}
+
+// Picks up any callback the script has redefined (or removed) since the last
+// check.  Called once a frame.
+static void sep_refresh_callbacks(lua_State *L)
+{
+	for (int cb = 0; cb < SEP_CB_COUNT; cb++) {
+		lua_pushstring(L, g_callbackNames[cb]);
+		lua_rawget(L, LUA_GLOBALSINDEX);
+		lua_rawgeti(L, LUA_REGISTRYINDEX, g_callbackRef[cb]);	// nil for LUA_NOREF
+
+		if (lua_rawequal(L, -1, -2)) {
+			lua_pop(L, 2);
+			continue;
+		}
+
+		lua_pop(L, 1);
+		luaL_unref(L, LUA_REGISTRYINDEX, g_callbackRef[cb]);
+		if (lua_isfunction(L, -1)) {
+			g_callbackRef[cb] = luaL_ref(L, LUA_REGISTRYINDEX);
+		} else {
+			lua_pop(L, 1);
+			g_callbackRef[cb] = LUA_NOREF;
+		}
+	}
+}
+
+// sep_call_lua() for the resolved callbacks: integer arguments, at most one
+// integer result and no string lookups or signature parsing.  Returns false if
+// the script had no such function when last checked (it may still provide
+// one some other way, so the caller looks it up by name).
+static bool sep_call_ref(int cb, const int *args, int nargs, int *result)
+{
+	lua_State *L = g_se_lua_context;
+
+	if (!g_callbacksResolved || g_callbackRef[cb] == LUA_NOREF) return false;
+
+	lua_rawgeti(L, LUA_REGISTRYINDEX, g_callbackRef[cb]);
+
+	for (int i = 0; i < nargs; i++)
+		lua_pushnumber(L, args[i]);
+
+	sep_profiler_callback_begin(g_callbackNames[cb]);
+	if (lua_pcall(L, nargs, result ? 1 : 0, 0) != 0) {
+		sep_profiler_callback_end();
+		sep_print("error running function '%s': %s", g_callbackNames[cb], lua_tostring(L, -1));
+		lua_pop(L, 1);
+		if (g_luaErrors) { sep_die("Multiple errors, cannot continue..."); exit(SINGE_ERROR_RUNTIME); }
+		g_luaErrors++;
+		return true;
+	}
+	sep_profiler_callback_end();
+
+	if (result) {
+		if (!lua_isnumber(L, -1))
+			sep_error("wrong result type");
+		*result = (int)lua_tonumber(L, -1);
+		lua_pop(L, 1);
+	}
+	g_luaErrors = 0;
+
+	return true;
+}
+
+int sep_on_overlay_update(void)
+{
+	int result = 0;
+
+	if (g_callbacksResolved)
+		sep_refresh_callbacks(g_se_lua_context);
+
+	if (!sep_call_ref(SEP_CB_OVERLAY_UPDATE, NULL, 0, &result))
+		sep_call_lua(g_callbackNames[SEP_CB_OVERLAY_UPDATE], ">i", &result);
+
+	return result;
+}
+
+void sep_on_input(int input, int mouseID, bool pressed)
+{
+	int cb = pressed ? SEP_CB_INPUT_PRESSED : SEP_CB_INPUT_RELEASED;
+	int args[2] = { input, mouseID };
+
+	if (!sep_call_ref(cb, args, 2, NULL))
+		sep_call_lua(g_callbackNames[cb], "ii", input, mouseID);
+}
+
 void sep_capture_vldp()
 {
 	// Intercept VLDP callback
@@ -278,7 +443,9 @@ void sep_do_mouse_move(Uint16 x, Uint16 y, Sint16 xrel, Sint16 yrel, Sint8 mouse
 	xr *= g_sep_overlay_scale_x;
 	yr *= g_sep_overlay_scale_y;
 	
-	sep_call_lua("onMouseMoved", "iiiii", x1, y1, xr, yr, mID);
+	int args[5] = { x1, y1, xr, yr, mID };
+	if (!sep_call_ref(SEP_CB_MOUSE_MOVED, args, 5, NULL))
+		sep_call_lua("onMouseMoved", "iiiii", x1, y1, xr, yr, mID);
 }
 
 void sep_error(const char *fmt, ...)
@@ -288,6 +455,8 @@ void sep_error(const char *fmt, ...)
 	va_list argp;
 	va_start(argp, fmt);
 	vsnprintf(message, sizeof(message), fmt, argp);
+	sep_profiler_stop();
+	g_callbacksResolved = false;
 	lua_close(g_se_lua_context);
 	sep_die(message);
 }
@@ -352,6 +521,11 @@ void sep_set_static_pointers(double *m_disc_fps, unsigned int *m_uDiscFPKS)
   g_se_uDiscFPKS = m_uDiscFPKS;
 }
 
+void sep_set_profile_path(const char *path)
+{
+	g_strProfilePath = path ? path : "";
+}
+
 void sep_set_surface(int width, int height)
 {
 	bool createSurface = false;
@@ -388,6 +562,8 @@ void sep_shutdown(void)
 
   if (g_bLuaInitialized)
   {
+	sep_profiler_stop();
+	g_callbacksResolved = false;
 	lua_close(g_se_lua_context);
 	g_bLuaInitialized = false;
   }
@@ -408,7 +584,9 @@ void sep_sound_ended(Uint8 *buffer, unsigned int slot)
 	///////////////////////////
 	*/
 
-	sep_call_lua("onSoundCompleted", "i", slot);
+	int args[1] = { (int)slot };
+	if (!sep_call_ref(SEP_CB_SOUND_COMPLETED, args, 1, NULL))
+		sep_call_lua("onSoundCompleted", "i", slot);
 	
 }
 
@@ -565,6 +743,9 @@ void sep_startup(const char *script)
   luaL_openlibs(g_se_lua_context);
   lua_atpanic(g_se_lua_context, sep_lua_error);
 
+  if (!g_strProfilePath.empty())
+    sep_profiler_start(g_se_lua_context, g_strProfilePath.c_str());
+
   lua_register(g_se_lua_context, "colorBackground",    sep_color_set_backcolor);
   lua_register(g_se_lua_context, "colorForeground",    sep_color_set_forecolor);
 
@@ -616,6 +797,8 @@ void sep_startup(const char *script)
 
   lua_register(g_se_lua_context, "vldpGetHeight",      sep_mpeg_get_height);
   lua_register(g_se_lua_context, "vldpGetPixel",       sep_mpeg_get_pixel);
+  lua_register(g_se_lua_context, "vldpGetPixels",      sep_mpeg_get_pixels);
+  lua_register(g_se_lua_context, "vldpGetRegionAverage", sep_mpeg_get_region_average);
   lua_register(g_se_lua_context, "vldpGetWidth",       sep_mpeg_get_width);
   lua_register(g_se_lua_context, "vldpSetVerbose",     sep_ldp_verbose);  
 
@@ -649,19 +832,251 @@ void sep_startup(const char *script)
 
   if (g_pSingeIn->get_retro_path()) sep_set_retropath();
 
-  if (luaL_dofile(g_se_lua_context, script) != 0)
+  sep_profiler_wrap_api(g_se_lua_context);
+
+  sep_profiler_callback_begin("(script load)");
+  int iResult = luaL_dofile(g_se_lua_context, script);
+  sep_profiler_callback_end();
+
+  if (iResult != 0)
   {
 	sep_error("error compiling script: %s", lua_tostring(g_se_lua_context, -1));
 	sep_die("Cannot continue, quitting...");
 	g_bLuaInitialized = false;
   }
+  else
+  {
+	sep_resolve_callbacks(g_se_lua_context);
+  }
 }
 
 
+static bool sep_same_color(const SDL_Color &a, const SDL_Color &b)
+{
+	return (a.r == b.r) && (a.g == b.g) && (a.b == b.b) && (a.a == b.a);
+}
+
+// Returns the glyph set for 'font' in the current quality and colours.
+static g_glyphCacheT *sep_get_glyph_set(TTF_Font *font)
+{
+	g_glyphCacheT *oldest = NULL;
+
+	for (size_t x = 0; x < g_glyphCache.size(); x++) {
+		g_glyphCacheT &set = g_glyphCache[x];
+		if ((set.font == font) && (set.quality == g_fontQuality) &&
+			sep_same_color(set.fg, g_colorForeground) &&
+			((g_fontQuality != 2) || sep_same_color(set.bg, g_colorBackground))) {
+			set.lastUsed = ++g_textCacheUseCount;
+			return &set;
+		}
+		if (!oldest || (set.lastUsed < oldest->lastUsed))
+			oldest = &set;
+	}
+
+	if (g_glyphCache.size() < SEP_GLYPH_CACHE_SIZE) {
+		g_glyphCache.push_back(g_glyphCacheT());
+		oldest = &g_glyphCache.back();
+	} else {
+		for (int c = 0; c < 256; c++)
+			if (oldest->glyph[c]) SDL_FreeSurface(oldest->glyph[c]);
+	}
+
+	memset(oldest->glyph, 0, sizeof(oldest->glyph));
+	memset(oldest->loaded, 0, sizeof(oldest->loaded));
+	oldest->font     = font;
+	oldest->quality  = g_fontQuality;
+	oldest->fg       = g_colorForeground;
+	oldest->bg       = g_colorBackground;
+	oldest->lastUsed = ++g_textCacheUseCount;
+	return oldest;
+}
+
+// Glyph 'c' of 'set', rendered the first time it is asked for.
+static SDL_Surface *sep_get_glyph(g_glyphCacheT *set, Uint16 c)
+{
+	if (!set->loaded[c]) {
+		set->loaded[c] = true;
+
+		switch (set->quality) {
+			case 1:
+				set->glyph[c] = TTF_RenderGlyph_Solid(set->font, c, set->fg);
+				break;
+
+			case 2:
+				set->glyph[c] = TTF_RenderGlyph_Shaded(set->font, c, set->fg, set->bg);
+				break;
+
+			case 3:
+				set->glyph[c] = TTF_RenderGlyph_Blended(set->font, c, set->fg);
+				break;
+		}
+
+		if (TTF_GlyphMetrics(set->font, c, &set->minx[c], NULL, NULL, NULL, &set->advance[c]) < 0) {
+			set->minx[c] = 0;
+			set->advance[c] = set->glyph[c] ? set->glyph[c]->w : 0;
+		}
+	}
+
+	return set->glyph[c];
+}
+
+// Puts 'message' together from cached glyphs, laid out the way SDL_ttf lays out
+// a string: the pen moves on by each advance plus the font's kerning for the
+// pair, and everything is shifted right if a glyph hangs off to the left.  The
+// size comes from TTF_SizeText, so scripts see the same dimensions as before.
+// Pixels are OR'ed together like SDL_ttf does where glyphs overlap.
+// Returns NULL if SDL_ttf has to render it after all.
+static SDL_Surface *sep_compose_text(TTF_Font *font, const char *message)
+{
+	const unsigned char *text = (const unsigned char *)message;
+	bool kerning = (TTF_GetFontKerning(font) != 0);
+	int w = 0, h = 0, pen = 0, left = 0;
+	unsigned char c, prev = 0;
+	size_t i, len = strlen(message);
+
+	if ((TTF_SizeText(font, message, &w, &h) < 0) || (w <= 0) || (h <= 0))
+		return NULL;
+
+	g_glyphCacheT *set = sep_get_glyph_set(font);
+	SDL_Surface *first = NULL;
+	vector<int> vPen(len);
+
+	for (i = 0; i < len; prev = c, i++) {
+		c = text[i];
+		SDL_Surface *glyph = sep_get_glyph(set, c);
+		if (!glyph && (c != ' ')) return NULL;
+		if (!first) first = glyph;
+
+		if (kerning && prev) pen += TTF_GetFontKerningSizeGlyphs(font, prev, c);
+		if (pen + set->minx[c] < left) left = pen + set->minx[c];
+		vPen[i] = pen;
+		pen += set->advance[c];
+	}
+
+	if (!first) return NULL;
+
+	SDL_Surface *result = SDL_CreateRGBSurfaceWithFormat(0, w, h,
+		first->format->BitsPerPixel, first->format->format);
+	if (!result) return NULL;
+
+	if (first->format->palette) {
+		SDL_SetSurfacePalette(result, first->format->palette);
+		SDL_FillRect(result, NULL, 0);
+	} else {
+		// SDL_ttf leaves the background in the text colour, only transparent
+		SDL_FillRect(result, NULL, SDL_MapRGBA(result->format,
+			set->fg.r, set->fg.g, set->fg.b, 0));
+	}
+
+	int bpp = result->format->BytesPerPixel;
+
+	for (i = 0; i < len; i++) {
+		c = text[i];
+		SDL_Surface *glyph = set->glyph[c];
+		if (!glyph || (glyph->format->format != result->format->format)) continue;
+
+		// a single glyph surface already starts at the overhang, if any
+		int x0 = vPen[i] - left + ((set->minx[c] < 0) ? set->minx[c] : 0);
+		int sx = (x0 < 0) ? -x0 : 0;
+		int cols = glyph->w;
+		if (x0 + cols > w) cols = w - x0;
+		int rows = (glyph->h < h) ? glyph->h : h;
+		if (cols <= sx) continue;
+
+		for (int y = 0; y < rows; y++) {
+			const Uint8 *src = (const Uint8 *)glyph->pixels + (y * glyph->pitch) + (sx * bpp);
+			Uint8 *dst = (Uint8 *)result->pixels + (y * result->pitch) + ((x0 + sx) * bpp);
+			for (int b = 0; b < (cols - sx) * bpp; b++)
+				dst[b] |= src[b];
+		}
+	}
+
+	return result;
+}
+
+// Returns 'message' rendered in the current font, quality and colours.
+// The surface belongs to the text cache, so don't free it.
+SDL_Surface *sep_render_text(const char *message)
+{
+	TTF_Font *font = g_fontList[g_fontCurrent];
+	g_textCacheT *oldest = NULL;
+
+	for (size_t x = 0; x < g_textCache.size(); x++) {
+		g_textCacheT &entry = g_textCache[x];
+		if ((entry.font == font) && (entry.quality == g_fontQuality) &&
+			sep_same_color(entry.fg, g_colorForeground) &&
+			// the background only matters for shaded text
+			((g_fontQuality != 2) || sep_same_color(entry.bg, g_colorBackground)) &&
+			(entry.text == message)) {
+			entry.lastUsed = ++g_textCacheUseCount;
+			return entry.surface;
+		}
+		if (!oldest || (entry.lastUsed < oldest->lastUsed))
+			oldest = &entry;
+	}
+
+	SDL_Surface *textsurface = sep_compose_text(font, message);
+
+	if (!textsurface) {
+		switch (g_fontQuality) {
+			case 1:
+				textsurface = TTF_RenderText_Solid(font, message, g_colorForeground);
+				break;
+
+			case 2:
+				textsurface = TTF_RenderText_Shaded(font, message, g_colorForeground, g_colorBackground);
+				break;
+
+			case 3:
+				textsurface = TTF_RenderText_Blended(font, message, g_colorForeground);
+				break;
+		}
+	}
+
+	if (textsurface) {
+		SDL_SetSurfaceRLE(textsurface, SDL_TRUE);
+		SDL_SetColorKey(textsurface, SDL_TRUE, 0x0);
+		if (!video::get_singe_blend_sprite())
+			SDL_SetSurfaceBlendMode(textsurface, SDL_BLENDMODE_NONE);
+
+		if (g_textCache.size() < SEP_TEXT_CACHE_SIZE) {
+			g_textCache.push_back(g_textCacheT());
+			oldest = &g_textCache.back();
+		} else {
+			SDL_FreeSurface(oldest->surface);
+		}
+
+		oldest->font     = font;
+		oldest->quality  = g_fontQuality;
+		oldest->fg       = g_colorForeground;
+		oldest->bg       = g_colorBackground;
+		oldest->text     = message;
+		oldest->surface  = textsurface;
+		oldest->lastUsed = ++g_textCacheUseCount;
+	}
+
+	return textsurface;
+}
+
+void sep_flush_text_cache(void)
+{
+	for (size_t x = 0; x < g_textCache.size(); x++)
+		SDL_FreeSurface(g_textCache[x].surface);
+	g_textCache.clear();
+
+	for (size_t x = 0; x < g_glyphCache.size(); x++)
+		for (int c = 0; c < 256; c++)
+			if (g_glyphCache[x].glyph[c]) SDL_FreeSurface(g_glyphCache[x].glyph[c]);
+	g_glyphCache.clear();
+}
+
 void sep_unload_fonts(void)
 {
   int x;
 
+  // the cache refers to the fonts
+  sep_flush_text_cache();
+
   if (g_fontList.size() > 0)
 	{
     for (x=0; x<(int)g_fontList.size(); x++)
@@ -971,62 +1386,50 @@ static int sep_mpeg_get_height(lua_State *L)
   return 1;
 }
 
+// BT.601 studio swing, which is what laserdisc MPEGs use
+static void sep_yuv_to_rgb(const uint8_t *yuv, unsigned char *R, unsigned char *G, unsigned char *B)
+{
+	int Y = yuv[0] - 16;
+	int U = yuv[1] - 128;
+	int V = yuv[2] - 128;
+
+	*R = sep_byte_clip(( 298 * Y           + 409 * V + 128) >> 8);
+	*G = sep_byte_clip(( 298 * Y - 100 * U - 208 * V + 128) >> 8);
+	*B = sep_byte_clip(( 298 * Y + 516 * U           + 128) >> 8);
+}
+
+// converts overlay coordinates into video coordinates
+static int sep_video_x(double x)
+{
+	return (int)(x * ((double)g_pSingeIn->g_vldp_info->w / (double)g_se_overlay_width));
+}
+
+static int sep_video_y(double y)
+{
+	return (int)(y * ((double)g_pSingeIn->g_vldp_info->h / (double)g_se_overlay_height));
+}
+
+// The pixels come from VLDP's copy of the last decoded frame rather than from
+// the YUV texture, because reading back from the GPU stalls the whole render
+// pipeline and lightgun games call this many times per frame.
 static int sep_mpeg_get_pixel(lua_State *L)
 {
-        Uint32 format;
-        int32_t  n                   = lua_gettop(L);
-        bool     result              = false;
-        static bool ex               = false;
-        SDL_Renderer *g_renderer     = video::get_renderer();
-        SDL_Texture  *g_texture      = video::get_yuv_screen();
-        SDL_QueryTexture(g_texture, &format, NULL, NULL, NULL);
-        unsigned char pixel[SDL_BYTESPERPIXEL(format)];
-        unsigned char R;
-        unsigned char G;
-        unsigned char B;
-        SDL_Rect rect;
-        int Y;
-        int U;
-        int V;
-
-        if (n == 2) {
-                if (lua_isnumber(L, 1)) {
-                        if (lua_isnumber(L, 2)) {
-
-				rect.h = 1;
-				rect.w = 1;
-				if (!ex) sep_print("sep_mpeg_get_pixel()");
-				rect.x = (int)((double)lua_tonumber(L, 1) * ((double)g_pSingeIn->g_vldp_info->w
-                                              / (double)g_se_overlay_width));
-				rect.y = (int)((double)lua_tonumber(L, 2) * ((double)g_pSingeIn->g_vldp_info->h
-                                              / (double)g_se_overlay_height));
-				if (g_renderer && g_texture) {
-					if (SDL_SetRenderTarget(g_renderer, g_texture) < 0) {
-                                            if (!ex) {
-						sep_print("get_pixel unsupported texture: Targets disabled");
-						sep_print("Could not RenderTarget in get_pixel: %s", SDL_GetError());
-                                            }
-                                            lua_State* X = luaL_newstate();
-                                            lua_pushinteger(X, 70);
-                                            lua_pushinteger(X, 10);
-                                            lua_pushstring(X, "Targets disabled");
-                                            sep_say_font(X);
-					} else {
-                                            if (SDL_RenderReadPixels(g_renderer, &rect, format,
-                                                              pixel, SDL_BYTESPERPIXEL(format)) < 0)
-						  sep_die("Could not ReadPixel in get_pixel: %s", SDL_GetError());
-					}
-					SDL_SetRenderTarget(g_renderer, NULL);
-				} else {
-					sep_die("Could not initialize get_pixel");
+	int n = lua_gettop(L);
+	bool result = false;
+	unsigned char R, G, B;
+
+	if (n == 2) {
+		if (lua_isnumber(L, 1)) {
+			if (lua_isnumber(L, 2)) {
+				SDL_Point point;
+				uint8_t yuv[3];
+
+				point.x = sep_video_x(lua_tonumber(L, 1));
+				point.y = sep_video_y(lua_tonumber(L, 2));
+				if (video::vid_get_yuv_pixels(&point, 1, yuv)) {
+					sep_yuv_to_rgb(yuv, &R, &G, &B);
+					result = true;
 				}
-				Y = pixel[0] - 16;
-				U = (int)rand()% 6 + (-3);
-				V = (int)rand()% 6 + (-3);
-				R = sep_byte_clip(( 298 * Y           + 409 * V + 128) >> 8);
-				G = sep_byte_clip(( 298 * Y - 100 * U - 208 * V + 128) >> 8);
-				B = sep_byte_clip(( 298 * Y + 516 * U           + 128) >> 8);
-				result = true;
 			}
 		}
 	}
@@ -1040,10 +1443,81 @@ static int sep_mpeg_get_pixel(lua_State *L)
 		lua_pushnumber(L, -1);
 		lua_pushnumber(L, -1);
 	}
-	ex = true;
 	return 3;
 }
 
+// vldpGetPixels({x1, y1, x2, y2, ...}) returns {r1, g1, b1, r2, g2, b2, ...}
+// (or nil if there's no video), sampling every point from the same frame.
+static int sep_mpeg_get_pixels(lua_State *L)
+{
+	int n = lua_gettop(L);
+
+	if ((n == 1) && lua_istable(L, 1)) {
+		int count = (int)(lua_objlen(L, 1) / 2);
+		vector<SDL_Point> points(count);
+		vector<uint8_t> yuv(count * 3);
+
+		for (int i = 0; i < count; i++) {
+			lua_rawgeti(L, 1, i * 2 + 1);
+			lua_rawgeti(L, 1, i * 2 + 2);
+			points[i].x = sep_video_x(lua_tonumber(L, -2));
+			points[i].y = sep_video_y(lua_tonumber(L, -1));
+			lua_pop(L, 2);
+		}
+
+		if ((count > 0) && video::vid_get_yuv_pixels(&points[0], count, &yuv[0])) {
+			lua_createtable(L, count * 3, 0);
+			for (int i = 0; i < count; i++) {
+				unsigned char rgb[3];
+				sep_yuv_to_rgb(&yuv[i * 3], &rgb[0], &rgb[1], &rgb[2]);
+				for (int j = 0; j < 3; j++) {
+					lua_pushnumber(L, rgb[j]);
+					lua_rawseti(L, -2, i * 3 + j + 1);
+				}
+			}
+			return 1;
+		}
+	}
+
+	lua_pushnil(L);
+	return 1;
+}
+
+// vldpGetRegionAverage(x, y, w, h) returns the average R, G, B of a rectangle
+// of the video (in overlay coordinates), or -1, -1, -1 on error.
+static int sep_mpeg_get_region_average(lua_State *L)
+{
+	int n = lua_gettop(L);
+	bool result = false;
+	unsigned char R, G, B;
+
+	if ((n == 4) && lua_isnumber(L, 1) && lua_isnumber(L, 2) &&
+		lua_isnumber(L, 3) && lua_isnumber(L, 4)) {
+		SDL_Rect rect;
+		uint8_t yuv[3];
+
+		rect.x = sep_video_x(lua_tonumber(L, 1));
+		rect.y = sep_video_y(lua_tonumber(L, 2));
+		// never let a small rectangle shrink to nothing
+		rect.w = SDL_max(1, sep_video_x(lua_tonumber(L, 3)));
+		rect.h = SDL_max(1, sep_video_y(lua_tonumber(L, 4)));
+		if (video::vid_get_yuv_average(&rect, yuv)) {
+			sep_yuv_to_rgb(yuv, &R, &G, &B);
+			result = true;
+		}
+	}
+
+	if (result) {
+		lua_pushnumber(L, (int)R);
+		lua_pushnumber(L, (int)G);
+		lua_pushnumber(L, (int)B);
+	} else {
+		lua_pushnumber(L, -1);
+		lua_pushnumber(L, -1);
+		lua_pushnumber(L, -1);
+	}
+	return 3;
+}
 
 static int sep_singe_two_pseudo_call_true(lua_State *L)
 {
@@ -1119,25 +1593,8 @@ static int sep_say_font(lua_State *L)
       if (lua_isnumber(L, 2))
         if (lua_isstring(L, 3))
 					if (g_fontCurrent >= 0) {
-						SDL_Surface *textsurface = NULL;
-						textsurface = SDL_ConvertSurface(textsurface, g_se_surface->format, 0);
-						const char *message = lua_tostring(L, 3);
-						TTF_Font *font = g_fontList[g_fontCurrent];
-						
-						switch (g_fontQuality) {
-							case 1:
-								textsurface = TTF_RenderText_Solid(font, message, g_colorForeground);
-								break;
-							
-							case 2:
-								textsurface = TTF_RenderText_Shaded(font, message, g_colorForeground, g_colorBackground);
-								break;
-							
-							case 3:
-								textsurface = TTF_RenderText_Blended(font, message, g_colorForeground);
-								break;
-						}
-						
+						SDL_Surface *textsurface = sep_render_text(lua_tostring(L, 3));
+
 						if (!(textsurface)) {
 							sep_die("Font surface is null!");
 						} else {
@@ -1170,13 +1627,7 @@ static int sep_say_font(lua_State *L)
 							    }
 							}
 
-							SDL_SetSurfaceRLE(textsurface, SDL_TRUE);
-							SDL_SetColorKey(textsurface, SDL_TRUE, 0x0);
-							if (!video::get_singe_blend_sprite())
-								SDL_SetSurfaceBlendMode(textsurface, SDL_BLENDMODE_NONE);
-
 							SDL_BlitSurface(textsurface, NULL, g_se_surface, &dest);
-							SDL_FreeSurface(textsurface);
 						}
           }
 
@@ -1205,7 +1656,7 @@ static int sep_search(lua_State *L)
     if (lua_isnumber(L, 1))
     {
       g_pSingeIn->framenum_to_frame(lua_tonumber(L, 1), s);
-      g_pSingeIn->pre_search(s, true);
+      g_pSingeIn->pre_search(s, false); // finishes in the background
 
       if (g_pSingeIn->g_local_info->blank_during_searches)
           if (debounced)
@@ -1318,8 +1769,8 @@ static int sep_skip_to_frame(lua_State *L)
 			        video::set_video_timer_blank(true);
 
 			g_pSingeIn->framenum_to_frame(lua_tonumber(L, 1), s);
-			g_pSingeIn->pre_search(s, true);
-			g_pSingeIn->pre_play();
+			g_pSingeIn->pre_search(s, false);
+			g_pSingeIn->pre_play();	// starts once the search has finished
 			g_pause_state = false; // BY RDG2010
 			debounced = true;
 		}
@@ -1351,7 +1802,14 @@ static int sep_sound_load(lua_State *L)
 			if (SDL_LoadWAV(filepath, &temp.audioSpec, &temp.buffer, &temp.length) == NULL)
 			{
 				sep_die("Could not open %s: %s", filepath, SDL_GetError());
+			} else if (!g_pSingeIn->samples_convert(&temp.audioSpec, &temp.buffer, &temp.length)) {
+				SDL_FreeWAV(temp.buffer);
+				sep_die("Could not convert %s", filepath);
 			} else {
+				// the buffer is now in the mixer's own format
+				temp.audioSpec.channels = sound::CHANNELS;
+				temp.audioSpec.freq     = sound::FREQ;
+				temp.audioSpec.format   = sound::FORMAT;
 				g_soundList.push_back(temp);
 				result = g_soundList.size() - 1;
 			}
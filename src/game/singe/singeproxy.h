@@ -54,11 +54,16 @@ void          sep_die(const char *fmt, ...);
 void          sep_do_blit(SDL_Surface *srfDest);
 void          sep_do_mouse_move(Uint16 x, Uint16 y, Sint16 xrel, Sint16 yrel, Sint8 mouseID);
 void          sep_error(const char *fmt, ...);
+void          sep_flush_text_cache(void);
 int           sep_lua_error(lua_State *L);
 int           sep_prepare_frame_callback(uint8_t *Yplane, uint8_t *Uplane, uint8_t *Vplane,
                            int Ypitch, int Upitch, int Vpitch);
 void          sep_print(const char *fmt, ...);
 void          sep_release_vldp();
+SDL_Surface  *sep_render_text(const char *message);
+int           sep_on_overlay_update(void);
+void          sep_on_input(int input, int mouseID, bool pressed);
+void          sep_set_profile_path(const char *path);
 void          sep_set_static_pointers(double *m_disc_fps, unsigned int *m_uDiscFPKS);
 void          sep_set_surface(int width, int height);
 void          sep_shutdown(void);
@@ -96,6 +101,8 @@ static int sep_get_overlay_height(lua_State *L);
 static int sep_get_overlay_width(lua_State *L);
 static int sep_mpeg_get_height(lua_State *L);
 static int sep_mpeg_get_pixel(lua_State *L);
+static int sep_mpeg_get_pixels(lua_State *L);
+static int sep_mpeg_get_region_average(lua_State *L);
 static int sep_mpeg_get_width(lua_State *L);
 static int sep_overlay_clear(lua_State *L);
 static int sep_pause(lua_State *L);
@@ -35,8 +35,8 @@
 
 timetrav::timetrav()
 {
+    set_cpumem_size(cpu::get_addressable(cpu::type::I88));
     m_shortgamename = "timetrav";
-    memset(m_cpumem, 0, cpu::MEM_SIZE);
 
     struct cpu::def cpu;
     memset(&cpu, 0, sizeof(struct cpu::def));
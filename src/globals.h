@@ -55,4 +55,6 @@ unsigned int scoreboard_usb_baud = 300;
 
 bool log_was_disabled = false; // added by MAC for -nolog
 
+bool unthrottled = false; // run as fast as possible (-unthrottled, -benchmark)
+
 #endif
@@ -70,13 +70,17 @@ using namespace std;
 #include "io/input.h"
 #include "hypseus.h"
 #include "timer/timer.h"
+#include "timer/perfstats.h"
+#include "timer/tracer.h"
 #include "sound/sound.h"
 #include "io/conout.h"
 #include "io/cmdline.h"
 #include "io/network.h"
 #include "video/video.h"
 #include "video/led.h"
+#include "video/golden.h"
 #include "ldp-out/ldp.h"
+#include "ldp-out/ldp-vldp.h"
 #include "io/error.h"
 #include "manymouse/manymouse.h"
 #include "cpu/cpu-debug.h"
@@ -149,6 +153,79 @@ void set_cur_dir(const char *exe_loc)
     }
 }
 
+// writes the results of a -benchmark run out as JSON, so that a build server
+// can keep track of them
+static void write_benchmark_report()
+{
+    static const char *cpu_names[cpu::type::COUNT] = {
+        "undefined", "z80", "x86", "m6809", "m6502", "cop421", "i88"
+    };
+
+    const char *pszPath = perfstats::get_report_path();
+    FILE *F = fopen(pszPath, "wt");
+
+    if (!F) {
+        LOGW << fmt("Could not write benchmark report to %s", pszPath);
+        return;
+    }
+
+    double dWallSecs = perfstats::get_wall_ns() * 0.000000001;
+    unsigned int uEmulatedMs = perfstats::get_emulated_ms();
+
+    fprintf(F, "{\n");
+    fprintf(F, "  \"game\": \"%s\",\n", g_game->get_shortgamename());
+    fprintf(F, "  \"emulated_ms\": %u,\n", uEmulatedMs);
+    fprintf(F, "  \"wall_ms\": %.3f,\n", dWallSecs * 1000.0);
+    fprintf(F, "  \"speed\": %.3f,\n",
+            (dWallSecs > 0.0) ? ((uEmulatedMs * 0.001) / dWallSecs) : 0.0);
+
+    // emulated MHz for each cpu (how fast it really ran, not how fast it
+    // is supposed to run)
+    fprintf(F, "  \"cpus\": [");
+    struct cpu::def *pCpu = NULL;
+    Uint8 id = 0;
+    for (id = 0; (pCpu = cpu::get_struct(id)) != NULL; id++) {
+        double dMhz = (dWallSecs > 0.0) ?
+            ((pCpu->total_cycles_executed * 0.000001) / dWallSecs) : 0.0;
+
+        fprintf(F, "%s\n    { \"id\": %u, \"type\": \"%s\", \"hz\": %u, "
+                "\"cycles\": %llu, \"emulated_mhz\": %.3f, \"mem_bytes\": %u }",
+                (id != 0) ? "," : "", id,
+                (pCpu->type < cpu::type::COUNT) ? cpu_names[pCpu->type] : "unknown",
+                pCpu->hz, (unsigned long long) pCpu->total_cycles_executed, dMhz,
+                pCpu->mem_size);
+    }
+    fprintf(F, "%s],\n", (id != 0) ? "\n  " : "");
+
+    unsigned int uDecoded = 0, uDropped = 0;
+    ldp_vldp *pVldp = dynamic_cast<ldp_vldp *>(g_ldp);
+    if (pVldp && pVldp->get_frame_counts(uDecoded, uDropped)) {
+        fprintf(F, "  \"vldp\": { \"frames_decoded\": %u, \"frames_dropped\": %u, "
+                "\"decode_fps\": %.3f },\n", uDecoded, uDropped,
+                (dWallSecs > 0.0) ? (uDecoded / dWallSecs) : 0.0);
+    }
+
+    for (unsigned int u = 0; u < perfstats::TIMING_COUNT; u++) {
+        perfstats::timing_s timing;
+        perfstats::get_timing(u, &timing);
+        fprintf(F, "  \"%s\": { \"count\": %llu, \"avg_ns\": %llu, \"max_ns\": %llu },\n",
+                perfstats::get_timing_name(u), (unsigned long long) timing.u64Count,
+                (unsigned long long) (timing.u64Count ? (timing.u64TotalNs / timing.u64Count) : 0),
+                (unsigned long long) timing.u64MaxNs);
+    }
+
+    Uint64 u64CacheMisses = 0;
+    if (perfstats::get_cache_misses(u64CacheMisses)) {
+        fprintf(F, "  \"cache_misses\": %llu,\n", (unsigned long long) u64CacheMisses);
+    }
+
+    fprintf(F, "  \"peak_rss_kb\": %llu\n", (unsigned long long) perfstats::get_peak_rss_kb());
+    fprintf(F, "}\n");
+    fclose(F);
+
+    LOGI << fmt("Benchmark report written to %s", pszPath);
+}
+
 /////////////////////// MAIN /////////////////////
 
 // the main function for both Windows and Linux <grin>
@@ -159,6 +236,8 @@ int main(int argc, char **argv)
 
     set_cur_dir(argv[0]); // set active directory
 
+    TRACE_THREAD_NAME("main");
+
     // initialize SDL without any subsystems but with the no parachute option so
     // 1 - we can initialize either audio or video first
     // 2 - we can trace segfaults using a debugger
@@ -223,8 +302,23 @@ int main(int argc, char **argv)
                                 if (g_game->pre_init()) // initialize all cpu's
                                 {
                                     LOGD << "Booting ROM ...";
+                                    perfstats::begin();
                                     g_game->start(); // HERE IS THE MAIN LOOP
                                                      // RIGHT HERE
+                                    perfstats::end();
+#ifdef TRACE
+                                    tracer::stop();
+#endif
+
+                                    if (perfstats::is_enabled()) {
+                                        write_benchmark_report();
+                                    }
+
+                                    bool bGoldenPassed = true;
+                                    if (golden::is_enabled()) {
+                                        bGoldenPassed = golden::write_report(g_game->get_shortgamename());
+                                    }
+
                                     g_game->pre_shutdown();
 
                                     // Send our game/ldp type to server to
@@ -242,6 +336,11 @@ int main(int argc, char **argv)
                                     result_code = g_game->get_game_errors();
                                                           // hypseus will exit with
                                                           // error codes
+
+                                    // so that a build server notices
+                                    if (!result_code && !bGoldenPassed) {
+                                        result_code = GOLDEN_ERROR_MISMATCH;
+                                    }
                                 } else {
                                     // exit if returns an error but don't print
                                     // error message to avoid repetition
@@ -388,3 +487,7 @@ unsigned char get_startsilent() { return (startsilent); }
 // added by MAC for -nolog
 void set_log_was_disabled (bool value) { log_was_disabled = value; }
 // end edit
+
+void set_unthrottled(bool value) { unthrottled = value; }
+
+bool get_unthrottled() { return unthrottled; }
@@ -31,6 +31,7 @@
 #define SDL_ERROR_SCORERENDERER  0x99
 #define SDL_ERROR_FONT           0x9A
 #define SDL_ERROR_SCREENSHOT     0x9B
+#define GOLDEN_ERROR_MISMATCH    0x9C
 
 // global definitions ...
 
@@ -80,5 +81,10 @@ unsigned int get_usb_baud();
 void set_log_was_disabled(bool value);
 // end edit
 
+// When unthrottled, emulation is driven by the emulated clock only and never
+// waits for real time to catch up.
+void set_unthrottled(bool value);
+bool get_unthrottled();
+
 #endif // DAPHNE_H
 
@@ -33,9 +33,12 @@
 #include "network.h"
 #include "numstr.h"
 #include "homedir.h"
+#include "replay.h"
 #include "input.h" // to disable joystick use
 #include "../io/numstr.h"
 #include "../video/video.h"
+#include "../video/capture.h"
+#include "../video/golden.h"
 #include "../video/led.h"
 #include "../hypseus.h"
 #include "../cpu/cpu-debug.h" // for set_cpu_trace
@@ -74,6 +77,8 @@
 #include "../ldp-out/ldp.h"
 #include "../ldp-out/ldp-vldp.h"
 #include "../ldp-out/framemod.h"
+#include "../timer/perfstats.h"
+#include "../timer/tracer.h"
 
 #ifdef UNIX
 #include <unistd.h> // for unlink
@@ -528,6 +533,23 @@ bool parse_cmd_line(int argc, char **argv)
                     result = false;
                 }
             }
+            // how many threads VLDP should decode the video on
+            else if (strcasecmp(s, "-vldp_threads") == 0) {
+                ldp_vldp *cur_ldp = dynamic_cast<ldp_vldp *>(g_ldp);
+                get_next_word(s, sizeof(s));
+                i = atoi(s);
+
+                if (!cur_ldp) {
+                    printerror("You can only set VLDP threads using VLDP as your "
+                              "laserdisc player!");
+                    result = false;
+                } else if ((i >= 1) && (i <= 16)) {
+                    cur_ldp->set_decode_threads((unsigned int)i);
+                } else {
+                    printerror("-vldp_threads must be between 1 and 16");
+                    result = false;
+                }
+            }
             // Ignore some deprecated arguments (Rather than error)
             else if (strcasecmp(s, "-noserversend") == 0) {
 
@@ -930,6 +952,17 @@ bool parse_cmd_line(int argc, char **argv)
                     result = false;
                 }
             }
+            else if (strcasecmp(s, "-scanline_mask") == 0) {
+                get_next_word(s, sizeof(s));
+                if (strcasecmp(s, "grille") == 0) {
+                    video::set_scanline_mask(video::SCANLINE_MASK_GRILLE);
+                } else if (strcasecmp(s, "slot") == 0) {
+                    video::set_scanline_mask(video::SCANLINE_MASK_SLOT);
+                } else {
+                    printerror("Scanline masks: grille, slot");
+                    result = false;
+                }
+            }
             // run hypseus in fullscreen mode
             else if (strcasecmp(s, "-fullscreen") == 0) {
                 video::set_fullscreen(true);
@@ -1088,6 +1121,114 @@ bool parse_cmd_line(int argc, char **argv)
             }
             // end edit
 
+            // runs headless for this many seconds of emulated time, as fast as
+            // possible, then writes a timing report
+            else if (strcasecmp(s, "-benchmark") == 0) {
+                get_next_word(s, sizeof(s));
+                i = atoi(s);
+                if (i > 0) {
+                    perfstats::enable(i * 1000);
+                    snprintf(s, sizeof(s), "Benchmarking for %d seconds", i);
+                    printline(s);
+                } else {
+                    printerror("-benchmark requires a number of seconds");
+                    result = false;
+                }
+            }
+            else if (strcasecmp(s, "-benchmark_report") == 0) {
+                get_next_word(s, sizeof(s));
+                perfstats::set_report_path(s);
+            }
+
+#ifdef TRACE
+            // records trace events from the start, Alt-ScrollLock stops and
+            // writes them (-trace is the cpu tracer)
+            else if (strcasecmp(s, "-trace_events") == 0) {
+                get_next_word(s, sizeof(s));
+                tracer::set_path(s);
+                tracer::start();
+            }
+#endif
+
+            // keeps a Prometheus text file of the runtime stats up to date,
+            // for node_exporter's textfile collector or anything else that
+            // wants to watch a cabinet
+            else if (strcasecmp(s, "-stats_file") == 0) {
+                char path[400];
+                get_next_word(path, sizeof(path));
+                get_next_word(s, sizeof(s));
+                i = atoi(s);
+                if (path[0] && (i > 0)) {
+                    perfstats::set_metrics_file(path, i);
+                } else {
+                    printerror("-stats_file requires a file name and a number of seconds");
+                    result = false;
+                }
+            }
+
+            // runs as fast as the host allows, only showing as many frames as
+            // the display can keep up with
+            else if (strcasecmp(s, "-unthrottled") == 0) {
+                set_unthrottled(true);
+                video::set_present_limit(true);
+            }
+
+            // saves every Nth presented frame as PNG (or raw pixels) for diffing
+            else if ((strcasecmp(s, "-capture_frames") == 0) ||
+                     (strcasecmp(s, "-capture_raw") == 0)) {
+                bool bRaw = (strcasecmp(s, "-capture_raw") == 0);
+                char dir[256];
+                get_next_word(dir, sizeof(dir));
+                get_next_word(s, sizeof(s));
+                i = atoi(s);
+                if ((dir[0] != 0) && (i > 0)) {
+                    if (!capture::set_sequence(dir, i, bRaw)) {
+                        snprintf(s, sizeof(s), "Can't write frame captures to %s", dir);
+                        printerror(s);
+                        result = false;
+                    }
+                } else {
+                    printerror("-capture_frames/-capture_raw expect a directory and a frame interval");
+                    result = false;
+                }
+            }
+
+            // compares the overlay and video against golden images at the
+            // emulated times listed in a file, headless
+            else if (strcasecmp(s, "-golden") == 0) {
+                char dir[256];
+                get_next_word(s, sizeof(s));
+                get_next_word(dir, sizeof(dir));
+                if ((dir[0] == 0) || !golden::start(s, dir)) {
+                    printerror("-golden expects a checkpoint file and a directory of golden images");
+                    result = false;
+                }
+            }
+            else if (strcasecmp(s, "-golden_report") == 0) {
+                get_next_word(s, sizeof(s));
+                golden::set_report_path(s);
+            }
+
+            // logs all input so it can be played back with -playback_input
+            else if (strcasecmp(s, "-record_input") == 0) {
+                get_next_word(s, sizeof(s));
+                if (replay::is_playing()) {
+                    printerror("-record_input can't be used with -playback_input");
+                    result = false;
+                } else if (!replay::start_recording(s, g_game->get_shortgamename())) {
+                    result = false;
+                }
+            }
+            else if (strcasecmp(s, "-playback_input") == 0) {
+                get_next_word(s, sizeof(s));
+                if (replay::is_recording()) {
+                    printerror("-playback_input can't be used with -record_input");
+                    result = false;
+                } else if (!replay::start_playback(s, g_game->get_shortgamename())) {
+                    result = false;
+                }
+            }
+
             // added by JFA for -startsilent
             else if (strcasecmp(s, "-startsilent") == 0) {
                 set_startsilent(1);
@@ -1198,6 +1339,27 @@ bool parse_cmd_line(int argc, char **argv)
                 result = false;
             }
         } // end for
+
+        // A benchmark doesn't need a window or a sound card (so it can run on a
+        // build server), and nothing like vsync may hold it back.  Neither do
+        // golden frame checks, which don't look at the window anyway.
+        // (SDL reads these when the subsystems get initialized)
+        if (perfstats::is_enabled() || golden::is_enabled()) {
+            set_unthrottled(true);
+            SDL_setenv("SDL_VIDEODRIVER", "dummy", 1);
+            SDL_setenv("SDL_AUDIODRIVER", "dummy", 1);
+            g_game->m_sdl_software_rendering = true;
+            video::set_fullscreen(false);
+            video::set_fakefullscreen(false);
+            video::set_opengl(false);
+            video::set_vulkan(false);
+            video::set_vsync(false);
+        }
+
+        // waiting on vsync would throttle us all over again
+        if (get_unthrottled()) {
+            video::set_vsync(false);
+        }
     }     // end if we know our game type
 
     // if game or ldp was unknown
@@ -55,6 +55,7 @@ void homedir::set_homedir(const string &s)
     make_dir(m_homedir);
     make_dir(m_homedir + "/ram");
     make_dir(m_homedir + "/roms");
+    make_dir(m_homedir + "/romcache");
     make_dir(m_homedir + "/logs");
     make_dir(m_homedir + "/fonts");
     make_dir(m_homedir + "/bezels");
@@ -33,11 +33,15 @@
 #include "../video/video.h"
 #include "../hypseus.h"
 #include "../timer/timer.h"
+#include "../timer/tracer.h"
 #include "../game/game.h"
 #include "../game/thayers.h"
 #include "../game/singe.h" // by RDG2010
 #include "../ldp-out/ldp.h"
 #include "fileparse.h"
+#include "replay.h"
+#include "input_queue.h"
+#include "../timer/perfstats.h"
 #include "../manymouse/manymouse.h"
 
 #ifdef UNIX
@@ -80,6 +84,9 @@ queue<struct coin_input> g_coin_queue; // keeps track of coin input to guarantee
 Uint64 g_last_coin_cycle_used = 0; // the cycle value that our last coin press
                                    // used
 
+// events polled by SDL_queue_input() wait here for SDL_deliver_input()
+TimedInputQueue g_input_queue(INPUT_POLL_MS);
+
 static int available_mice = 0;
 static ManyMouseEvent mm_event;
 
@@ -122,7 +129,7 @@ int g_key_defs[SWITCH_COUNT][2] = {
     {SDLK_F12, SDLK_F11},     // take screenshot
     {SDLK_ESCAPE, SDLK_q},    // Quit DAPHNE
     {SDLK_p, 0},              // pause game
-    {SDLK_BACKQUOTE, 0},      // toggle console (TODO)
+    {SDLK_BACKQUOTE, 0},      // toggle stats display
     {SDLK_t, 0}               // Tilt/Slam switch
 };
 
@@ -149,7 +156,7 @@ int joystick_buttons_map[SWITCH_COUNT][2] = {
     {0, 0}, // take screenshot
     {0, 0}, // Quit DAPHNE
     {0, 0}, // pause game
-    {0, 0}, // toggle console
+    {0, 0}, // toggle stats display
     {0, 0}  // Tilt/Slam switch
 };
 
@@ -455,6 +462,7 @@ int SDL_input_init()
     while (!g_coin_queue.empty()) {
         g_coin_queue.pop();
     }
+    g_input_queue.clear();
     g_sticky_coin_cycles =
         (Uint32)(STICKY_COIN_SECONDS * cpu::get_hz(0)); // only needs to be
                                                        // calculated once
@@ -579,6 +587,7 @@ void FilterMouseEvents(bool bFilteredOut)
 // 1 = success, 0 = failure
 int SDL_input_shutdown(void)
 {
+    replay::shutdown();
     if (g_use_gamepad) {
         if (g_gamepad_id)
             SDL_GameControllerClose(g_gamepad_id);
@@ -589,16 +598,20 @@ int SDL_input_shutdown(void)
     return (1);
 }
 
-// checks to see if there is incoming input, and acts on it
-void SDL_check_input()
+// hands an event to the game, noting how long it waited since the host got it
+static void deliver_event(SDL_Event *event)
 {
+    Uint32 uNow = SDL_GetTicks();
+    if (event->common.timestamp && ((Sint32) (uNow - event->common.timestamp) >= 0))
+        perfstats::add_timing(perfstats::TIMING_INPUT,
+            (Uint64) (uNow - event->common.timestamp) * 1000000);
 
-    SDL_Event event;
-
-    while ((SDL_PollEvent(&event)) && (!get_quitflag())) {
-        process_event(&event);
-    }
+    process_event(event);
+}
 
+// the things to do every time input is polled, no matter how
+static void check_input_common()
+{
     // added by JFA for -idleexit
     if (get_idleexit() > 0 && elapsed_ms_time(idle_timer) > get_idleexit())
         set_quitflag();
@@ -631,6 +644,54 @@ void SDL_check_input()
     // else the coin queue is empty, so we needn't do anything ...
 }
 
+// checks to see if there is incoming input, and acts on it
+void SDL_check_input()
+{
+
+    SDL_Event event;
+
+    // (cpu::execute also plays back recorded input every ms, but games without
+    // a cpu rely on this)
+    replay::think(g_ldp->get_elapsed_ms_since_start());
+
+    // anything cpu::execute queued up came first
+    while (!get_quitflag() && g_input_queue.pop(&event)) {
+        deliver_event(&event);
+    }
+
+    while ((SDL_PollEvent(&event)) && (!get_quitflag())) {
+        deliver_event(&event);
+    }
+
+    check_input_common();
+}
+
+void SDL_queue_input()
+{
+    SDL_Event event;
+    Uint32 uNow = SDL_GetTicks();
+    unsigned int uEmuMs = g_ldp->get_elapsed_ms_since_start();
+
+    while (SDL_PollEvent(&event)) {
+        g_input_queue.push(event, uNow, uEmuMs);
+    }
+
+    // the oldest ones may be due already
+    SDL_deliver_input();
+
+    check_input_common();
+}
+
+void SDL_deliver_input()
+{
+    SDL_Event event;
+    unsigned int uEmuMs = g_ldp->get_elapsed_ms_since_start();
+
+    while (!get_quitflag() && g_input_queue.pop_due(uEmuMs, &event)) {
+        deliver_event(&event);
+    }
+}
+
 // processes incoming input
 void process_event(SDL_Event *event)
 {
@@ -857,6 +918,9 @@ void process_keydown(SDL_Keycode key)
     if (g_alt_pressed) {
         if (key == SDLK_RETURN) video::vid_toggle_fullscreen();
         else if (key == SDLK_BACKSPACE) video::vid_toggle_scanlines();
+#ifdef TRACE
+        else if (key == SDLK_SCROLLLOCK) tracer::toggle();
+#endif
     }
     // end ALT-COMMAND checks
 }
@@ -1022,6 +1086,12 @@ void process_joystick_hat_motion(SDL_Event *event)
 // if user has pressed a key/moved the joystick/pressed a button
 void input_enable(Uint8 move, Sint8 mouseID)
 {
+    // while a recording is played back, it's the only input (apart from quit)
+    if (replay::is_playing() && !replay::is_injecting() && (move != SWITCH_QUIT)) {
+        return;
+    }
+    replay::record(move, mouseID, true);
+
     // first test universal input, then pass unknown input on to the game driver
 
     switch (move) {
@@ -1058,7 +1128,7 @@ void input_enable(Uint8 move, Sint8 mouseID)
         }
         break;
     case SWITCH_CONSOLE:
-        // TODO: implement for SDL2
+        video::vid_toggle_stats();
         break;
     }
 }
@@ -1067,6 +1137,11 @@ void input_enable(Uint8 move, Sint8 mouseID)
 // position
 void input_disable(Uint8 move, Sint8 mouseID)
 {
+    if (replay::is_playing() && !replay::is_injecting()) {
+        return;
+    }
+    replay::record(move, mouseID, false);
+
     // don't send reset or screenshots key-ups to the individual games because
     // they will return warnings that will alarm users
     if ((move != SWITCH_RESET) && (move != SWITCH_SCREENSHOT) &&
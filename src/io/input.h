@@ -95,8 +95,19 @@ int SDL_input_shutdown();
 //  events which can hurt performance.
 void FilterMouseEvents(bool bFilteredOut);
 
+// how often cpu::execute polls for input, in milliseconds
+#define INPUT_POLL_MS 4
+
+// Polls for input and acts on it right away.
 void SDL_check_input();
 
+// Polls for input, but leaves the events for SDL_deliver_input() to hand over
+//  at the emulated millisecond they arrived on (used by cpu::execute).
+void SDL_queue_input();
+
+// Acts on the queued events that are due.  Must be called every emulated ms.
+void SDL_deliver_input();
+
 void SDL_gamepad_init();
 
 void process_event(SDL_Event *event);
@@ -0,0 +1,86 @@
+/*
+ * ____ HYPSEUS COPYRIGHT NOTICE ____
+ *
+ * Copyright (C) 2026 Hypseus Singe contributors
+ *
+ * This file is part of HYPSEUS SINGE, a laserdisc arcade game emulator
+ *
+ * HYPSEUS SINGE is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * HYPSEUS SINGE is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "input_queue.h"
+
+TimedInputQueue::TimedInputQueue(unsigned int uDelayMs)
+    : m_uDelayMs(uDelayMs), m_uLastDueMs(0)
+{
+}
+
+void TimedInputQueue::push(const SDL_Event &event, Uint32 uHostMs,
+                           unsigned int uEmuMs)
+{
+    // how long ago the host got it (events without a timestamp are taken to be
+    //  brand new)
+    Uint32 uAgeMs = 0;
+    if (event.common.timestamp &&
+        ((Sint32)(uHostMs - event.common.timestamp) > 0)) {
+        uAgeMs = uHostMs - event.common.timestamp;
+    }
+
+    // anything older than the delay (because polling stalled) is already late,
+    //  so it goes out right away
+    if (uAgeMs > m_uDelayMs) uAgeMs = m_uDelayMs;
+
+    entry_s entry;
+    entry.event = event;
+    entry.uDueMs = uEmuMs + m_uDelayMs - uAgeMs;
+
+    // never ahead of an event that came in before it
+    if (!m_queue.empty() && ((int)(entry.uDueMs - m_uLastDueMs) < 0)) {
+        entry.uDueMs = m_uLastDueMs;
+    }
+
+    m_uLastDueMs = entry.uDueMs;
+    m_queue.push_back(entry);
+}
+
+bool TimedInputQueue::pop_due(unsigned int uEmuMs, SDL_Event *pEvent)
+{
+    if (m_queue.empty() || ((int)(uEmuMs - m_queue.front().uDueMs) < 0)) {
+        return false;
+    }
+
+    *pEvent = m_queue.front().event;
+    m_queue.pop_front();
+    return true;
+}
+
+bool TimedInputQueue::pop(SDL_Event *pEvent)
+{
+    if (m_queue.empty()) return false;
+
+    *pEvent = m_queue.front().event;
+    m_queue.pop_front();
+    return true;
+}
+
+bool TimedInputQueue::empty() const
+{
+    return m_queue.empty();
+}
+
+void TimedInputQueue::clear()
+{
+    m_queue.clear();
+}
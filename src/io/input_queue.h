@@ -0,0 +1,68 @@
+/*
+ * ____ HYPSEUS COPYRIGHT NOTICE ____
+ *
+ * Copyright (C) 2026 Hypseus Singe contributors
+ *
+ * This file is part of HYPSEUS SINGE, a laserdisc arcade game emulator
+ *
+ * HYPSEUS SINGE is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * HYPSEUS SINGE is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef INPUT_QUEUE_H
+#define INPUT_QUEUE_H
+
+// Holds SDL events between being polled and being handed to the game.
+// Events are only polled every few milliseconds, so each one gets scheduled
+//  for the emulated millisecond that matches when the host received it, plus
+//  a fixed delay of one poll interval.  That way a batch of events gets spread
+//  back out over the time it arrived in, and every event sees the same
+//  latency instead of anything between zero and a whole poll interval.
+
+#include <SDL.h>
+#include <deque>
+
+class TimedInputQueue
+{
+  public:
+    // 'uDelayMs' should be the interval the events are polled at
+    TimedInputQueue(unsigned int uDelayMs);
+
+    // Adds an event that was just polled.  'uHostMs' is SDL_GetTicks() now,
+    //  'uEmuMs' the current emulated millisecond.
+    void push(const SDL_Event &event, Uint32 uHostMs, unsigned int uEmuMs);
+
+    // Gets the next event that is due by emulated ms 'uEmuMs'.
+    // Returns false if there is none.
+    bool pop_due(unsigned int uEmuMs, SDL_Event *pEvent);
+
+    // gets the next event whether it's due or not
+    bool pop(SDL_Event *pEvent);
+
+    bool empty() const;
+
+    void clear();
+
+  private:
+    struct entry_s {
+        SDL_Event event;
+        unsigned int uDueMs;
+    };
+
+    unsigned int m_uDelayMs;
+    unsigned int m_uLastDueMs; // keeps the events in the order they came in
+    std::deque<entry_s> m_queue;
+};
+
+#endif // INPUT_QUEUE_H
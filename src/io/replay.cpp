@@ -0,0 +1,198 @@
+/*
+ * ____ HYPSEUS COPYRIGHT NOTICE ____
+ *
+ * Copyright (C) 2026 Hypseus Singe contributors
+ *
+ * This file is part of HYPSEUS SINGE, a laserdisc arcade game emulator
+ *
+ * HYPSEUS SINGE is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * HYPSEUS SINGE is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+// File format (all values little endian):
+//  header: "HYPI", Uint32 version, 16 bytes of game name (zero padded)
+//  then one 8 byte record per event:
+//   Uint32 emulated ms, Uint8 switch, Sint8 mouse ID, Uint8 enabled, Uint8 0
+
+#include "config.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <vector>
+#include <plog/Log.h>
+#include "conout.h"
+#include "input.h"
+#include "mpo_mem.h"
+#include "replay.h"
+#include "../ldp-out/ldp.h"
+
+using namespace std;
+
+namespace replay
+{
+
+static const Uint8 MAGIC[4]           = {'H', 'Y', 'P', 'I'};
+static const Uint32 VERSION           = 1;
+static const unsigned int NAME_SIZE   = 16;
+static const unsigned int HEADER_SIZE = 4 + 4 + NAME_SIZE;
+static const unsigned int RECORD_SIZE = 8;
+
+struct event_s {
+    Uint32 uMs;
+    Uint8 uMove;
+    Sint8 iMouseID;
+    bool bEnabled;
+};
+
+FILE *g_pRecordFile = NULL;
+
+vector<event_s> g_vEvents; // the recording being played back
+size_t g_uNextEvent = 0;   // the next event to be played back
+bool g_bPlaying = false;
+bool g_bInjecting = false;
+
+bool start_recording(const char *pszPath, const char *pszGameName)
+{
+    Uint8 header[HEADER_SIZE] = {0};
+
+    g_pRecordFile = fopen(pszPath, "wb");
+    if (!g_pRecordFile) {
+        LOGE << fmt("Could not create input recording %s", pszPath);
+        return false;
+    }
+
+    memcpy(header, MAGIC, sizeof(MAGIC));
+    STORE_LIL_UINT32(header + 4, VERSION);
+    strncpy((char *)header + 8, pszGameName, NAME_SIZE - 1);
+    fwrite(header, 1, sizeof(header), g_pRecordFile);
+
+    LOGI << fmt("Recording input to %s", pszPath);
+    return true;
+}
+
+bool start_playback(const char *pszPath, const char *pszGameName)
+{
+    bool bResult = false;
+    Uint8 header[HEADER_SIZE];
+    Uint8 record[RECORD_SIZE];
+    FILE *F = fopen(pszPath, "rb");
+
+    if (!F) {
+        LOGE << fmt("Could not open input recording %s", pszPath);
+        return false;
+    }
+
+    if ((fread(header, 1, sizeof(header), F) == sizeof(header)) &&
+        (memcmp(header, MAGIC, sizeof(MAGIC)) == 0) &&
+        (LOAD_LIL_UINT32(header + 4) == VERSION)) {
+        char szName[NAME_SIZE];
+        memcpy(szName, header + 8, NAME_SIZE);
+        szName[NAME_SIZE - 1] = 0;
+
+        // it will still play, but probably not do anything useful
+        if (strcmp(szName, pszGameName) != 0) {
+            LOGW << fmt("Input recording %s was made with %s, not %s",
+                        pszPath, szName, pszGameName);
+        }
+
+        g_vEvents.clear();
+        while (fread(record, 1, sizeof(record), F) == sizeof(record)) {
+            event_s event;
+            event.uMs      = LOAD_LIL_UINT32(record);
+            event.uMove    = record[4];
+            event.iMouseID = (Sint8)record[5];
+            event.bEnabled = (record[6] != 0);
+            g_vEvents.push_back(event);
+        }
+
+        g_uNextEvent = 0;
+        g_bPlaying   = true;
+        bResult      = true;
+        LOGI << fmt("Playing back %u input events from %s",
+                    (unsigned int)g_vEvents.size(), pszPath);
+    } else {
+        LOGE << fmt("%s is not an input recording", pszPath);
+    }
+
+    fclose(F);
+    return bResult;
+}
+
+void shutdown()
+{
+    if (g_pRecordFile) {
+        fclose(g_pRecordFile);
+        g_pRecordFile = NULL;
+    }
+
+    g_vEvents.clear();
+    g_bPlaying = false;
+}
+
+bool is_recording()
+{
+    return (g_pRecordFile != NULL);
+}
+
+bool is_playing()
+{
+    return g_bPlaying;
+}
+
+bool is_injecting()
+{
+    return g_bInjecting;
+}
+
+void record(Uint8 uMove, Sint8 iMouseID, bool bEnabled)
+{
+    if (g_pRecordFile) {
+        Uint8 record[RECORD_SIZE];
+        STORE_LIL_UINT32(record, g_ldp->get_elapsed_ms_since_start());
+        record[4] = uMove;
+        record[5] = (Uint8)iMouseID;
+        record[6] = bEnabled ? 1 : 0;
+        record[7] = 0;
+        fwrite(record, 1, sizeof(record), g_pRecordFile);
+    }
+}
+
+void think(unsigned int uMs)
+{
+    if (!g_bPlaying) {
+        return;
+    }
+
+    g_bInjecting = true;
+    while ((g_uNextEvent < g_vEvents.size()) &&
+           (g_vEvents[g_uNextEvent].uMs <= uMs)) {
+        // advance first in case the input ends up calling us again
+        event_s event = g_vEvents[g_uNextEvent++];
+
+        if (event.bEnabled) {
+            input_enable(event.uMove, event.iMouseID);
+        } else {
+            input_disable(event.uMove, event.iMouseID);
+        }
+    }
+    g_bInjecting = false;
+
+    // once it's over, hand control back to the player
+    if (g_uNextEvent == g_vEvents.size()) {
+        LOGI << "Input playback finished";
+        g_bPlaying = false;
+    }
+}
+
+}
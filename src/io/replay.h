@@ -0,0 +1,63 @@
+/*
+ * ____ HYPSEUS COPYRIGHT NOTICE ____
+ *
+ * Copyright (C) 2026 Hypseus Singe contributors
+ *
+ * This file is part of HYPSEUS SINGE, a laserdisc arcade game emulator
+ *
+ * HYPSEUS SINGE is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * HYPSEUS SINGE is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef REPLAY_H
+#define REPLAY_H
+
+// Records the input of a session (-record_input) so that it can be played back
+//  later (-playback_input) at exactly the same emulated time.
+// Every call to input_enable/input_disable is logged along with the emulated
+//  millisecond (as counted by ldp::pre_think) that it happened on.
+
+#include <SDL.h>
+
+namespace replay
+{
+
+// Starts logging all input to 'pszPath'.  Returns false if the file couldn't
+//  be created.
+bool start_recording(const char *pszPath, const char *pszGameName);
+
+// Loads a recording from 'pszPath' for playback.  While it is being played,
+//  live input (other than quitting) is ignored.
+// Returns false if the file can't be read or isn't a recording.
+bool start_playback(const char *pszPath, const char *pszGameName);
+
+// closes the recording, if any
+void shutdown();
+
+bool is_recording();
+bool is_playing();
+
+// true while a recorded event is being fed back into input_enable/disable
+bool is_injecting();
+
+// logs one input event (does nothing unless recording)
+void record(Uint8 uMove, Sint8 iMouseID, bool bEnabled);
+
+// Plays back every recorded event up to and including emulated ms 'uMs'.
+// Must be called at least once per emulated millisecond to be accurate.
+void think(unsigned int uMs);
+
+}
+
+#endif // REPLAY_H
@@ -0,0 +1,279 @@
+/*
+ * ____ HYPSEUS COPYRIGHT NOTICE ____
+ *
+ * Copyright (C) 2026 Hypseus Singe contributors
+ *
+ * This file is part of HYPSEUS SINGE, a laserdisc arcade game emulator
+ *
+ * HYPSEUS SINGE is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * HYPSEUS SINGE is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "config.h"
+
+#include "rom_cache.h"
+#include "mpo_fileio.h"
+#include <plog/Log.h>
+#include <new>
+#include <stdio.h>
+#include <string.h>
+
+#ifdef UNIX
+#include <strings.h>
+#include <sys/mman.h>
+#endif
+
+#ifdef WIN32
+#define strcasecmp stricmp
+#endif
+
+using namespace std;
+
+static const char ROM_CACHE_MAGIC[8] = {'H', 'Y', 'P', 'R', 'O', 'M', 'C', 'C'};
+static const Uint32 ROM_CACHE_VERSION = 1;
+
+// images start on this boundary in the file
+static const Uint32 ROM_CACHE_ALIGN = 16;
+
+RomCache::RomCache(const string &strDir)
+    : m_strDir(strDir), m_bKeyed(false), m_u64ZipSize(0), m_u64ZipTime(0),
+      m_pMap(NULL), m_uMapSize(0), m_pEntries(NULL), m_uEntries(0)
+{
+}
+
+RomCache::~RomCache() { Close(); }
+
+string RomCache::GetCachePath(const string &strZipPath) const
+{
+    size_t slash = strZipPath.find_last_of("/\\");
+    string strName = (slash == string::npos) ? strZipPath : strZipPath.substr(slash + 1);
+    return m_strDir + "/" + strName + ".cache";
+}
+
+void RomCache::Open(const string &strZipPath)
+{
+    Close();
+
+    m_strZipPath = strZipPath;
+
+    // the .zip's size and time are what make the cache good or not
+    mpo_io *pIO = mpo_open(strZipPath.c_str(), MPO_OPEN_READONLY);
+    if (!pIO) return;
+    m_u64ZipSize = pIO->size;
+    m_u64ZipTime = pIO->time_last_modified;
+    mpo_close(pIO);
+
+    // a path that long couldn't be checked
+    m_bKeyed = (strZipPath.size() < sizeof(((header_s *)0)->szZipPath));
+    if (!m_bKeyed) return;
+
+    if (!Map(GetCachePath(strZipPath))) return;
+
+    const header_s *pHeader = (const header_s *)m_pMap;
+    bool bGood = (m_uMapSize >= sizeof(header_s)) &&
+                 (memcmp(pHeader->magic, ROM_CACHE_MAGIC, sizeof(ROM_CACHE_MAGIC)) == 0) &&
+                 (pHeader->uVersion == ROM_CACHE_VERSION) &&
+                 (pHeader->u64ZipSize == m_u64ZipSize) &&
+                 (pHeader->u64ZipTime == m_u64ZipTime) &&
+                 (strncmp(pHeader->szZipPath, strZipPath.c_str(), sizeof(pHeader->szZipPath)) == 0) &&
+                 (pHeader->uEntries <= (m_uMapSize - sizeof(header_s)) / sizeof(entry_s));
+
+    if (bGood) {
+        m_pEntries = (const entry_s *)(m_pMap + sizeof(header_s));
+        m_uEntries = pHeader->uEntries;
+
+        for (Uint32 u = 0; u < m_uEntries; u++) {
+            const entry_s &entry = m_pEntries[u];
+            if ((entry.uOffset > m_uMapSize) || (entry.uSize > m_uMapSize - entry.uOffset) ||
+                (memchr(entry.szName, 0, sizeof(entry.szName)) == NULL)) {
+                bGood = false;
+            }
+        }
+    }
+
+    if (!bGood) {
+        LOGI << "ROM cache for " << strZipPath << " is out of date, it will be made again";
+        Unmap();
+    }
+}
+
+void RomCache::Close()
+{
+    if (!m_vAdded.empty() && !Write()) {
+        LOGW << "Could not write ROM cache " << GetCachePath(m_strZipPath);
+    }
+
+    Unmap();
+    m_vAdded.clear();
+    m_strZipPath.clear();
+    m_bKeyed     = false;
+    m_u64ZipSize = 0;
+    m_u64ZipTime = 0;
+}
+
+bool RomCache::Load(const char *name, Uint8 *buf, Uint32 size, Uint32 &uCRC)
+{
+    for (Uint32 u = 0; u < m_uEntries; u++) {
+        const entry_s &entry = m_pEntries[u];
+
+        // (the .zip is searched without regard to case, too)
+        if ((entry.uSize == size) && (strcasecmp(entry.szName, name) == 0)) {
+            memcpy(buf, m_pMap + entry.uOffset, size);
+            uCRC = entry.uCRC;
+            LOGI << "Loading ROM image " << name << " from the ROM cache ... " << size
+                 << " bytes read.";
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void RomCache::Add(const char *name, const Uint8 *buf, Uint32 size, Uint32 uCRC)
+{
+    if (!m_bKeyed || (strlen(name) >= sizeof(((entry_s *)0)->szName))) return;
+
+    added_s added;
+    memset(&added.entry, 0, sizeof(added.entry));
+    strcpy(added.entry.szName, name);
+    added.entry.uSize = size;
+    added.entry.uCRC  = uCRC;
+    added.vData.assign(buf, buf + size);
+    m_vAdded.push_back(added);
+}
+
+bool RomCache::Map(const string &strPath)
+{
+    mpo_io *pIO = mpo_open(strPath.c_str(), MPO_OPEN_READONLY);
+    if (!pIO) return false;
+
+    if ((pIO->size < sizeof(header_s)) || (pIO->size > 0xFFFFFFFF)) {
+        mpo_close(pIO);
+        return false;
+    }
+    m_uMapSize = (Uint32)pIO->size;
+
+#ifdef UNIX
+    // the mapping outlives the file being closed
+    m_pMap = (Uint8 *)mmap(NULL, m_uMapSize, PROT_READ, MAP_PRIVATE, fileno(pIO->handle), 0);
+    if (m_pMap == MAP_FAILED) m_pMap = NULL;
+#else
+    m_pMap = new (nothrow) Uint8[m_uMapSize];
+    if (m_pMap) {
+        MPO_BYTES_READ bytes_read = 0;
+        mpo_read(m_pMap, m_uMapSize, &bytes_read, pIO);
+        if (bytes_read != m_uMapSize) {
+            delete[] m_pMap;
+            m_pMap = NULL;
+        }
+    }
+#endif
+
+    mpo_close(pIO);
+
+    if (!m_pMap) m_uMapSize = 0;
+    return (m_pMap != NULL);
+}
+
+void RomCache::Unmap()
+{
+    if (m_pMap) {
+#ifdef UNIX
+        munmap(m_pMap, m_uMapSize);
+#else
+        delete[] m_pMap;
+#endif
+    }
+
+    m_pMap     = NULL;
+    m_uMapSize = 0;
+    m_pEntries = NULL;
+    m_uEntries = 0;
+}
+
+// Writes the images still in the mapped cache and the ones added since into a
+//  new cache file, then puts it in place of the old one.
+bool RomCache::Write()
+{
+    vector<entry_s> vEntries;
+    vector<const Uint8 *> vSources;
+
+    for (Uint32 u = 0; u < m_uEntries; u++) {
+        bool bReplaced = false;
+        for (size_t i = 0; i < m_vAdded.size(); i++) {
+            if (strcasecmp(m_vAdded[i].entry.szName, m_pEntries[u].szName) == 0) bReplaced = true;
+        }
+        if (!bReplaced) {
+            vEntries.push_back(m_pEntries[u]);
+            vSources.push_back(m_pMap + m_pEntries[u].uOffset);
+        }
+    }
+    for (size_t i = 0; i < m_vAdded.size(); i++) {
+        vEntries.push_back(m_vAdded[i].entry);
+        vSources.push_back(m_vAdded[i].vData.empty() ? NULL : &m_vAdded[i].vData[0]);
+    }
+
+    // lay the images out after the entries
+    uint64_t u64Offset = sizeof(header_s) + (vEntries.size() * sizeof(entry_s));
+    for (size_t i = 0; i < vEntries.size(); i++) {
+        u64Offset = (u64Offset + ROM_CACHE_ALIGN - 1) & ~(uint64_t)(ROM_CACHE_ALIGN - 1);
+        vEntries[i].uOffset = (Uint32)u64Offset;
+        u64Offset += vEntries[i].uSize;
+    }
+    if (u64Offset > 0xFFFFFFFF) return false;
+
+    header_s header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, ROM_CACHE_MAGIC, sizeof(ROM_CACHE_MAGIC));
+    header.uVersion   = ROM_CACHE_VERSION;
+    header.uEntries   = (Uint32)vEntries.size();
+    header.u64ZipSize = m_u64ZipSize;
+    header.u64ZipTime = m_u64ZipTime;
+    strncpy(header.szZipPath, m_strZipPath.c_str(), sizeof(header.szZipPath) - 1);
+
+    string strPath    = GetCachePath(m_strZipPath);
+    string strTmpPath = strPath + ".tmp";
+    mpo_io *pIO       = mpo_open(strTmpPath.c_str(), MPO_OPEN_CREATE);
+    if (!pIO) return false;
+
+    static const Uint8 padding[ROM_CACHE_ALIGN] = {0};
+    unsigned int bytes_written = 0;
+    uint64_t u64Pos = sizeof(header_s) + (vEntries.size() * sizeof(entry_s));
+    bool bOK = mpo_write(&header, sizeof(header), &bytes_written, pIO) &&
+               (vEntries.empty() ||
+                mpo_write(&vEntries[0], vEntries.size() * sizeof(entry_s), &bytes_written, pIO));
+
+    for (size_t i = 0; bOK && (i < vEntries.size()); i++) {
+        if (vEntries[i].uOffset != u64Pos) {
+            bOK = mpo_write(padding, (size_t)(vEntries[i].uOffset - u64Pos), &bytes_written, pIO);
+        }
+        if (bOK && vEntries[i].uSize) {
+            bOK = mpo_write(vSources[i], vEntries[i].uSize, &bytes_written, pIO);
+        }
+        u64Pos = (uint64_t)vEntries[i].uOffset + vEntries[i].uSize;
+    }
+
+    mpo_close(pIO);
+
+    // the old file may still be mapped, which is fine on UNIX but not on
+    // windows
+    Unmap();
+    remove(strPath.c_str());
+    if (!bOK || (rename(strTmpPath.c_str(), strPath.c_str()) != 0)) {
+        remove(strTmpPath.c_str());
+        return false;
+    }
+
+    return true;
+}
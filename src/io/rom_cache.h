@@ -0,0 +1,103 @@
+/*
+ * ____ HYPSEUS COPYRIGHT NOTICE ____
+ *
+ * Copyright (C) 2026 Hypseus Singe contributors
+ *
+ * This file is part of HYPSEUS SINGE, a laserdisc arcade game emulator
+ *
+ * HYPSEUS SINGE is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * HYPSEUS SINGE is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef ROM_CACHE_H
+#define ROM_CACHE_H
+
+// Keeps the ROM images of a .zip file inflated on disk, along with their CRCs,
+//  so the next launch can copy them straight out of a mapped file instead of
+//  inflating and checksumming them all over again.
+//
+// There is one cache file per .zip, which is only used if it was made from a
+//  .zip at the same path with the same size and modification time.  Anything
+//  else makes it get written again from scratch.
+
+#include <SDL.h>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+class RomCache
+{
+public:
+    // 'strDir' is where the cache files go
+    RomCache(const std::string &strDir);
+    ~RomCache();
+
+    // maps the cache of 'strZipPath', if there is one that is still good
+    void Open(const std::string &strZipPath);
+
+    // writes out anything that was added and unmaps the cache
+    void Close();
+
+    // Copies ROM image 'name' into 'buf' if the cache has it at 'size' bytes,
+    //  and gets the CRC it had when it came out of the .zip.
+    bool Load(const char *name, Uint8 *buf, Uint32 size, Uint32 &uCRC);
+
+    // adds a ROM image that was just inflated out of the .zip
+    void Add(const char *name, const Uint8 *buf, Uint32 size, Uint32 uCRC);
+
+    // the cache file for 'strZipPath'
+    std::string GetCachePath(const std::string &strZipPath) const;
+
+private:
+    struct header_s {
+        char magic[8];
+        Uint32 uVersion;
+        Uint32 uEntries;
+        uint64_t u64ZipSize;
+        uint64_t u64ZipTime;
+        char szZipPath[512];
+    };
+
+    struct entry_s {
+        char szName[64];
+        Uint32 uSize;
+        Uint32 uCRC;
+        Uint32 uOffset; // from the beginning of the file
+        Uint32 uReserved;
+    };
+
+    struct added_s {
+        entry_s entry;
+        std::vector<Uint8> vData;
+    };
+
+    bool Map(const std::string &strPath);
+    void Unmap();
+    bool Write();
+
+    std::string m_strDir;
+    std::string m_strZipPath;
+    bool m_bKeyed; // the .zip could be looked at (so a cache can be written)
+    uint64_t m_u64ZipSize;
+    uint64_t m_u64ZipTime;
+
+    Uint8 *m_pMap;    // the cache file (NULL if there isn't a good one)
+    Uint32 m_uMapSize;
+    const entry_s *m_pEntries;
+    Uint32 m_uEntries;
+
+    std::vector<added_s> m_vAdded;
+};
+
+#endif // ROM_CACHE_H
@@ -33,14 +33,21 @@
 #include "ldp-vldp.h"
 #include "../io/conout.h"
 #include "../io/mpo_fileio.h"
+#include "../io/mpo_mem.h"
 #include "../sound/sound.h"
 #include "../timer/timer.h"
+#include "../timer/perfstats.h"
+#include "../timer/tracer.h"
 #include <plog/Log.h>
 
 #ifdef DEBUG
 #include <assert.h> // this may include an extra .DLL in windows that I don't want to rely on
 #endif
 
+#include <algorithm>
+#include <list>
+#include <new>
+#include <vector>
 #include <stdlib.h>
 #include <string.h>
 #include <sys/stat.h>
@@ -59,7 +66,8 @@
 // Macros to lock and unlock the mutex for the audio to make sure we aren't
 // playing audio while
 // we are loading or seeking
-#define OGG_LOCK SDL_mutexP(g_ogg_mutex)
+// (waiting for the lock shows up in traces, it's what stalls seeking)
+#define OGG_LOCK { TRACE_SCOPE("OGG_LOCK wait"); SDL_mutexP(g_ogg_mutex); }
 #define OGG_UNLOCK SDL_mutexV(g_ogg_mutex)
 
 /////////////////////////////////////////
@@ -69,12 +77,42 @@ audiocopyproc paudiocopy = memcpy; // pointer to the audio copy procedure
                                    // (defaults to memcpy)
 
 SDL_mutex *g_ogg_mutex   = NULL;
-mpo_io *g_pIOAudioHandle = NULL;
-OggVorbis_File s_ogg;
 
-Uint32 g_audio_filesize = 0;     // total size of the audio stream
-Uint32 g_audio_filepos  = 0;     // the position in the file of our audio stream
-Uint8 *g_big_buf        = NULL;  // holds entire Ogg stream in RAM :)
+// Where an Ogg page starts in the file, and the first sample it finishes
+// decoding.  A sorted list of these lets us seek without vorbisfile's bisection.
+struct ogg_page_s {
+    Uint32 uOffset;      // byte offset of the page
+    Uint32 uStartSample; // sample position at the start of the page
+};
+
+// One .ogg file, read entirely into RAM and opened by vorbisfile.
+struct ogg_segment_s {
+    string strPath;    // full path of the .ogg (identifies the segment)
+    mpo_io *pIO;
+    Uint8 *pBuf;       // holds entire Ogg stream in RAM :)
+    Uint32 uSize;      // total size of the audio stream
+    Uint32 uPos;       // the position in the file of our audio stream
+    Uint32 uLastUsed;  // for picking which segment to throw out of the pool
+    vector<ogg_page_s> vPages; // seek index (empty if we couldn't make one)
+    OggVorbis_File ogg;
+};
+
+// Framefiles with lots of short segments switch files on nearly every search,
+// and loading a whole .ogg then re-opening it with vorbisfile each time
+// stutters.  So the most recently used segments are kept open in a pool, and
+// the segments on either side of the current one are loaded into it in the
+// background before they are needed.
+#define AUDIO_POOL_SIZE 4
+
+SDL_mutex *g_pool_mutex   = NULL; // guards everything below
+ogg_segment_s *g_audio_pool[AUDIO_POOL_SIZE] = {NULL};
+Uint32 g_pool_use_count   = 0;    // bumped every time a segment is used
+ogg_segment_s *g_cur_seg  = NULL; // the segment being played (never evicted)
+list<string> g_lstPrefetch;       // paths the loader thread should load
+SDL_cond *g_loader_cond   = NULL; // signalled when g_lstPrefetch changes
+SDL_Thread *g_loader_thread = NULL;
+bool g_loader_quit        = false;
+
 bool g_audio_ready      = false; // whether audio is ready to be parsed
 bool g_audio_playing    = false; // whether the audio is to be playing or not
 Uint32 g_playing_timer  = 0;     // the time at which we began playing audio
@@ -91,32 +129,24 @@ unsigned int g_uCallbackDbgTimer   = 0;
 
 ///////////////////////////////////////////////////////////////////////////////////
 
-// resets mm states
-void mmreset()
-{
-    g_audio_filepos = 0; // rewind back to position #0
-}
-
 // replaces fread
 size_t mmread(void *ptr, size_t size, size_t nmemb, void *datasource)
 {
+    ogg_segment_s *pSeg  = (ogg_segment_s *)datasource;
     size_t bytes_to_read = size * nmemb; // how many bytes to be read
     // where to get the data from
-    Uint8 *src = ((Uint8 *)datasource) + g_audio_filepos;
-
-    //	printf("mmread being called.. size is %d, nmemb is %d, bytes_to_read is
-    //%d\n", size, nmemb, bytes_to_read);
+    Uint8 *src = pSeg->pBuf + pSeg->uPos;
 
-    if (g_audio_filepos + bytes_to_read > g_audio_filesize) {
+    if (pSeg->uPos + bytes_to_read > pSeg->uSize) {
         bytes_to_read = 0;
-        if (g_audio_filepos < g_audio_filesize) {
-            bytes_to_read = g_audio_filesize - g_audio_filepos;
+        if (pSeg->uPos < pSeg->uSize) {
+            bytes_to_read = pSeg->uSize - pSeg->uPos;
         }
     }
 
     if (bytes_to_read != 0) {
         memcpy(ptr, src, bytes_to_read); // copy the memory
-        g_audio_filepos += bytes_to_read;
+        pSeg->uPos += bytes_to_read;
     }
 
     return (bytes_to_read);
@@ -128,21 +158,16 @@ size_t mmread(void *ptr, size_t size, size_t nmemb, void *datasource)
 
 int mmseek(void *datasource, int64_t offset, int whence)
 {
-    int result = -1;
-
-    //	printf("mmseek being called, whence is %d\n", whence);
-
-    // just to get rid of warnings
-    if (datasource) {
-    }
+    ogg_segment_s *pSeg = (ogg_segment_s *)datasource;
+    int result          = -1;
 
     switch (whence) {
     case SEEK_SET:
         // bug fix by Arnaud Gibert
-        if (offset <= g_audio_filesize) {
+        if (offset <= pSeg->uSize) {
             // make sure offset is positive so we don't get into trouble
             if (offset >= 0) {
-                g_audio_filepos = (Uint32)offset;
+                pSeg->uPos = (Uint32)offset;
             } else {
                 LOGW << "SEEK_SET used with a negative offset!";
             }
@@ -150,17 +175,15 @@ int mmseek(void *datasource, int64_t offset, int whence)
         }
         break;
     case SEEK_CUR:
-        if (offset + g_audio_filepos <= g_audio_filesize) {
-            g_audio_filepos = (unsigned int)(g_audio_filepos + offset);
-            result          = 0;
+        if (offset + pSeg->uPos <= pSeg->uSize) {
+            pSeg->uPos = (unsigned int)(pSeg->uPos + offset);
+            result     = 0;
         }
         break;
     case SEEK_END:
-        //		printf("SEEK_END being called, offset is %x, whence is %d!\n",
-        //(Uint32) offset, whence);
-        if (g_audio_filesize + offset <= g_audio_filesize) {
-            g_audio_filepos = (unsigned int)(g_audio_filesize + offset);
-            result          = 0;
+        if (pSeg->uSize + offset <= pSeg->uSize) {
+            pSeg->uPos = (unsigned int)(pSeg->uSize + offset);
+            result     = 0;
         }
         break;
     }
@@ -170,37 +193,383 @@ int mmseek(void *datasource, int64_t offset, int whence)
 
 int mmclose(void *datasource)
 {
-    // safety check
-    if (datasource != g_big_buf) {
-        LOGE << "datasource != g_bigbuf, this should never happen!";
-    }
+    ogg_segment_s *pSeg = (ogg_segment_s *)datasource;
 
 #ifdef TRY_MMAP
-    LOGD << "Unmapping audio stream from memory ...";
-    munmap(g_big_buf, g_audio_filesize);
-    datasource = NULL;
+    munmap(pSeg->pBuf, pSeg->uSize);
 #else
-    LOGD << "Freeing memory used to store audio stream...";
-    // free(datasource);
-    delete[] g_big_buf;
-    g_big_buf = NULL;
+    delete[] pSeg->pBuf;
 #endif
+    pSeg->pBuf = NULL;
 
-    mpo_close(g_pIOAudioHandle);
-    g_pIOAudioHandle = NULL;
+    mpo_close(pSeg->pIO);
+    pSeg->pIO = NULL;
 
     return 0;
 }
 
 long mmtell(void *datasource)
 {
-    //	printf("mmtell being called, filepos is %x\n", (Uint32)
-    // g_audio_filepos);
+    return ((ogg_segment_s *)datasource)->uPos;
+}
+
+// The seek index of an .ogg is saved next to it in a .oix file so that it only
+// has to be built once.  All values are little endian:
+//  header: "OIDX", Uint32 version, Uint32 size of the .ogg, Uint64 its mtime
+//  then one ogg_page_s (Uint32 offset, Uint32 start sample) per audio page
+static const char OIX_MAGIC[4]   = {'O', 'I', 'D', 'X'};
+static const Uint32 OIX_VERSION  = 1;
+static const unsigned int OIX_HEADER_SIZE = 4 + 4 + 4 + 8;
+
+static string oix_path(const string &strOggPath)
+{
+    // the path always ends in .ogg (see oggize_path)
+    return strOggPath.substr(0, strOggPath.length() - 4) + ".oix";
+}
+
+// tries to load the seek index of 'pSeg' from its .oix file
+static bool seek_index_load(ogg_segment_s *pSeg, Uint64 u64Mtime)
+{
+    bool bResult = false;
+    Uint8 header[OIX_HEADER_SIZE];
+    Uint8 entry[8];
+    FILE *F = fopen(oix_path(pSeg->strPath).c_str(), "rb");
+
+    if (!F) {
+        return false;
+    }
+
+    // a stale index is no good, it will be rebuilt
+    if ((fread(header, 1, sizeof(header), F) == sizeof(header)) &&
+        (memcmp(header, OIX_MAGIC, sizeof(OIX_MAGIC)) == 0) &&
+        (LOAD_LIL_UINT32(header + 4) == OIX_VERSION) &&
+        (LOAD_LIL_UINT32(header + 8) == pSeg->uSize) &&
+        (LOAD_LIL_UINT32(header + 12) == (Uint32)u64Mtime) &&
+        (LOAD_LIL_UINT32(header + 16) == (Uint32)(u64Mtime >> 32))) {
+        pSeg->vPages.clear();
+        while (fread(entry, 1, sizeof(entry), F) == sizeof(entry)) {
+            ogg_page_s page;
+            page.uOffset      = LOAD_LIL_UINT32(entry);
+            page.uStartSample = LOAD_LIL_UINT32(entry + 4);
+            pSeg->vPages.push_back(page);
+        }
+        bResult = true;
+    }
+
+    fclose(F);
+    return bResult;
+}
+
+// saves the seek index of 'pSeg' (failing is harmless, the disc might just be
+// read-only)
+static void seek_index_save(const ogg_segment_s *pSeg, Uint64 u64Mtime)
+{
+    Uint8 header[OIX_HEADER_SIZE];
+    Uint8 entry[8];
+    string strPath = oix_path(pSeg->strPath);
+    FILE *F        = fopen(strPath.c_str(), "wb");
+
+    if (!F) {
+        LOGD << "Could not create audio seek index " << strPath;
+        return;
+    }
+
+    memcpy(header, OIX_MAGIC, sizeof(OIX_MAGIC));
+    STORE_LIL_UINT32(header + 4, OIX_VERSION);
+    STORE_LIL_UINT32(header + 8, pSeg->uSize);
+    STORE_LIL_UINT32(header + 12, (Uint32)u64Mtime);
+    STORE_LIL_UINT32(header + 16, (Uint32)(u64Mtime >> 32));
+    fwrite(header, 1, sizeof(header), F);
+
+    for (vector<ogg_page_s>::const_iterator i = pSeg->vPages.begin();
+         i != pSeg->vPages.end(); ++i) {
+        STORE_LIL_UINT32(entry, i->uOffset);
+        STORE_LIL_UINT32(entry + 4, i->uStartSample);
+        fwrite(entry, 1, sizeof(entry), F);
+    }
+
+    fclose(F);
+}
+
+// Walks the pages of the stream (which is already in RAM) to build its seek
+// index.  Only pages that follow a page with a known granule position get an
+// entry, which leaves out the header pages.
+static void seek_index_build(ogg_segment_s *pSeg)
+{
+    const Uint8 *pBuf = pSeg->pBuf;
+    Uint32 uPos       = 0;
+    Sint64 s64LastGranule = -1;
+
+    pSeg->vPages.clear();
+
+    while (uPos + 27 <= pSeg->uSize) {
+        // resync if the stream is damaged
+        if ((memcmp(pBuf + uPos, "OggS", 4) != 0) || (pBuf[uPos + 4] != 0)) {
+            uPos++;
+            continue;
+        }
+
+        unsigned int uSegments = pBuf[uPos + 26];
+        if (uPos + 27 + uSegments > pSeg->uSize) {
+            break;
+        }
+
+        Uint32 uBodySize = 0;
+        for (unsigned int i = 0; i < uSegments; i++) {
+            uBodySize += pBuf[uPos + 27 + i];
+        }
+
+        Sint64 s64Granule = (Sint64)(((Uint64)LOAD_LIL_UINT32(pBuf + uPos + 10) << 32) |
+                                     LOAD_LIL_UINT32(pBuf + uPos + 6));
+
+        if (s64LastGranule > 0) {
+            ogg_page_s page;
+            page.uOffset      = uPos;
+            page.uStartSample = (Uint32)s64LastGranule;
+            pSeg->vPages.push_back(page);
+        }
+
+        // -1 means that no packet finishes on this page
+        if (s64Granule != -1) {
+            s64LastGranule = s64Granule;
+        }
+
+        uPos += 27 + uSegments + uBodySize;
+    }
+}
+
+static bool page_before(const ogg_page_s &a, const ogg_page_s &b)
+{
+    return a.uStartSample < b.uStartSample;
+}
+
+// Seeks 'pSeg' to sample 'u64Sample' by jumping straight to the page that
+// contains it and decoding up to the sample.  Returns false if the index
+// couldn't be used (the caller should fall back to ov_pcm_seek).
+static bool seek_index_seek(ogg_segment_s *pSeg, Uint64 u64Sample)
+{
+    static char discard_buf[AUDIO_BUF_CHUNK];
+    ogg_page_s target;
+    target.uOffset      = 0;
+    target.uStartSample = (Uint32)u64Sample;
+
+    // find the last page that starts at or before the sample
+    vector<ogg_page_s>::const_iterator i =
+        upper_bound(pSeg->vPages.begin(), pSeg->vPages.end(), target, page_before);
+
+    if ((u64Sample > 0xFFFFFFFF) || (i == pSeg->vPages.begin())) {
+        return false;
+    }
+    --i;
+
+    // A page's start is taken from the granule of the page before it, but the
+    // first sample vorbisfile can decode from a page may come later than that
+    // (it needs the previous packet to overlap with).  If it lands past the
+    // sample, the sample is on an earlier page.
+    ogg_int64_t s64Pos;
+    for (;;) {
+        if (ov_raw_seek(&pSeg->ogg, i->uOffset) != 0) {
+            return false;
+        }
+
+        s64Pos = ov_pcm_tell(&pSeg->ogg);
+        if (s64Pos < 0) {
+            return false;
+        }
+        if ((Uint64)s64Pos <= u64Sample) {
+            break;
+        }
+
+        if (i == pSeg->vPages.begin()) {
+            return false;
+        }
+        --i;
+    }
+
+    // decode (and throw away) the rest of the way
+    Uint64 u64Bytes = (u64Sample - s64Pos) * sound::BYTES_PER_SAMPLE;
+    while (u64Bytes > 0) {
+        int nop;
+        int iWanted = (u64Bytes < sizeof(discard_buf)) ? (int)u64Bytes : (int)sizeof(discard_buf);
+        long lRead  = ov_read(&pSeg->ogg, discard_buf, iWanted, 0, 2, 1, &nop);
+        if (lRead <= 0) {
+            return false;
+        }
+        u64Bytes -= lRead;
+    }
+
+    return true;
+}
+
+// Loads the .ogg at 'strPath' into RAM and opens it.
+// Returns NULL if it doesn't exist or can't be used ('bVerbose' says whether
+// to explain why).
+static ogg_segment_s *ogg_segment_open(const string &strPath, bool bVerbose)
+{
+    ov_callbacks mycallbacks = {mmread, mmseek, mmclose, mmtell};
+    mpo_io *pIO              = mpo_open(strPath.c_str(), MPO_OPEN_READONLY);
+
+    if (!pIO) {
+        return NULL;
+    }
+
+    ogg_segment_s *pSeg = new ogg_segment_s;
+    pSeg->strPath   = strPath;
+    pSeg->pIO       = pIO;
+    pSeg->uSize     = static_cast<unsigned int>(pIO->size & 0xFFFFFFFF);
+    pSeg->uPos      = 0;
+    pSeg->uLastUsed = 0;
+#ifdef TRY_MMAP
+    pSeg->pBuf = (Uint8 *)mmap(NULL, pSeg->uSize, PROT_READ, MAP_PRIVATE,
+                               fileno(pIO->handle), 0);
+    if (pSeg->pBuf == MAP_FAILED) {
+        pSeg->pBuf = NULL;
+    }
+#else
+    pSeg->pBuf = new (nothrow) unsigned char[pSeg->uSize];
+    if (pSeg->pBuf) {
+        mpo_read(pSeg->pBuf, pSeg->uSize, NULL, pIO); // read entire stream into RAM
+    }
+#endif
+
+    bool bOK = false;
+
+    if (pSeg->pBuf) {
+        int open_result = ov_open_callbacks(pSeg, &pSeg->ogg, NULL, 0, mycallbacks);
+
+        // if we opening the .OGG succeeded
+        if (open_result == 0) {
+            // now check to make sure it's stereo and the proper sample rate
+            vorbis_info *info = ov_info(&pSeg->ogg, -1);
+
+            // if they meet the proper specification, let them proceed
+            if ((info->channels == 2) && (info->rate == 44100)) {
+                bOK = true;
+
+                if (!seek_index_load(pSeg, pIO->time_last_modified)) {
+                    seek_index_build(pSeg);
+                    seek_index_save(pSeg, pIO->time_last_modified);
+                }
+            } else {
+                if (bVerbose) {
+                    LOGE << ".ogg file must have 2 channels and 44100 Hz";
+                    LOGE << fmt(".ogg file has %u channel(s) and is %ld Hz",
+                                info->channels, info->rate);
+                    LOGE << ".ogg file ignored (you won't hear any audio)";
+                }
+                ov_clear(&pSeg->ogg); // this closes the buffer and the file
+            }
+        } else if (bVerbose) {
+            LOGE << fmt("ov_open_callbacks failed! Error code is %d",
+                        open_result);
+            LOGE << fmt("OV_EREAD=%d OV_ENOTVORBIS=%d OV_EVERSION=%d "
+                        "OV_EBADHEADER=%d OV_EFAULT=%d\n",
+                        OV_EREAD,
+                        OV_ENOTVORBIS,
+                        OV_EVERSION,
+                        OV_EBADHEADER,
+                        OV_EFAULT);
+        }
+    } else if (bVerbose) {
+        LOGE << "out of memory";
+    }
+
+    // if we got an error before vorbisfile took ownership of the buffer
+    if (!bOK) {
+        if (pSeg->pIO) mmclose(pSeg);
+        delete pSeg;
+        pSeg = NULL;
+    }
+
+    return pSeg;
+}
+
+static void ogg_segment_close(ogg_segment_s *pSeg)
+{
+    ov_clear(&pSeg->ogg); // this calls mmclose
+    delete pSeg;
+}
+
+// returns the pooled segment for 'strPath' or NULL if there isn't one
+// (g_pool_mutex must be held)
+static ogg_segment_s *pool_find(const string &strPath)
+{
+    for (unsigned int i = 0; i < AUDIO_POOL_SIZE; i++) {
+        if (g_audio_pool[i] && (g_audio_pool[i]->strPath == strPath)) {
+            g_audio_pool[i]->uLastUsed = ++g_pool_use_count;
+            return g_audio_pool[i];
+        }
+    }
+    return NULL;
+}
+
+// Puts 'pSeg' in the pool, returning the segment that it replaced (if any) so
+// that the caller can close it after releasing g_pool_mutex.
+// (g_pool_mutex must be held)
+static ogg_segment_s *pool_add(ogg_segment_s *pSeg)
+{
+    int iSlot = -1;
+
+    for (unsigned int i = 0; i < AUDIO_POOL_SIZE; i++) {
+        // an empty slot is always the best choice
+        if (!g_audio_pool[i]) {
+            iSlot = i;
+            break;
+        }
+        if ((g_audio_pool[i] != g_cur_seg) &&
+            ((iSlot < 0) || (g_audio_pool[i]->uLastUsed < g_audio_pool[iSlot]->uLastUsed))) {
+            iSlot = i;
+        }
+    }
+
+    ogg_segment_s *pEvicted = g_audio_pool[iSlot];
+    pSeg->uLastUsed         = ++g_pool_use_count;
+    g_audio_pool[iSlot]     = pSeg;
+    return pEvicted;
+}
+
+// loads the segments that ldp_vldp::prefetch_adjacent_audio asks for
+static int audio_loader_thread(void *)
+{
+    SDL_LockMutex(g_pool_mutex);
+    while (!g_loader_quit) {
+        if (g_lstPrefetch.empty()) {
+            SDL_CondWait(g_loader_cond, g_pool_mutex);
+            continue;
+        }
+
+        string strPath = g_lstPrefetch.front();
+        g_lstPrefetch.pop_front();
+
+        // already loaded?
+        if (pool_find(strPath)) {
+            continue;
+        }
 
-    if (datasource) {
+        // the slow part happens without holding any locks
+        SDL_UnlockMutex(g_pool_mutex);
+        ogg_segment_s *pSeg     = ogg_segment_open(strPath, false);
+        ogg_segment_s *pEvicted = NULL;
+        SDL_LockMutex(g_pool_mutex);
+
+        if (pSeg) {
+            // the emulation thread may have needed it in the meantime
+            if (pool_find(strPath)) {
+                pEvicted = pSeg;
+            } else {
+                pEvicted = pool_add(pSeg);
+            }
+        }
+
+        if (pEvicted) {
+            SDL_UnlockMutex(g_pool_mutex);
+            ogg_segment_close(pEvicted);
+            SDL_LockMutex(g_pool_mutex);
+        }
     }
+    SDL_UnlockMutex(g_pool_mutex);
 
-    return g_audio_filepos;
+    return 0;
 }
 
 /////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -330,8 +699,17 @@ bool ldp_vldp::audio_init()
 #endif
 
     // create a mutex to prevent threads from interfering
-    g_ogg_mutex = SDL_CreateMutex();
-    if (g_ogg_mutex) {
+    g_ogg_mutex   = SDL_CreateMutex();
+    g_pool_mutex  = SDL_CreateMutex();
+    g_loader_cond = SDL_CreateCond();
+    if (g_ogg_mutex && g_pool_mutex && g_loader_cond) {
+        g_loader_quit   = false;
+        g_loader_thread = SDL_CreateThread(audio_loader_thread, "VLDP audio loader", NULL);
+
+        // we can live without prefetching
+        if (!g_loader_thread) {
+            LOGW << "Could not create audio loader thread";
+        }
         result = true;
     }
 
@@ -341,11 +719,38 @@ bool ldp_vldp::audio_init()
 // shuts down VLDP audio
 void ldp_vldp::audio_shutdown()
 {
+    if (g_loader_thread) {
+        SDL_LockMutex(g_pool_mutex);
+        g_loader_quit = true;
+        SDL_CondSignal(g_loader_cond);
+        SDL_UnlockMutex(g_pool_mutex);
+        SDL_WaitThread(g_loader_thread, NULL);
+        g_loader_thread = NULL;
+    }
+    g_lstPrefetch.clear();
+
     // if we have an audio file still open, close it
-    if (g_pIOAudioHandle != 0) {
+    if (g_cur_seg) {
         close_audio_stream();
     }
 
+    for (unsigned int i = 0; i < AUDIO_POOL_SIZE; i++) {
+        if (g_audio_pool[i]) {
+            ogg_segment_close(g_audio_pool[i]);
+            g_audio_pool[i] = NULL;
+        }
+    }
+
+    if (g_loader_cond) {
+        SDL_DestroyCond(g_loader_cond);
+        g_loader_cond = NULL;
+    }
+
+    if (g_pool_mutex) {
+        SDL_DestroyMutex(g_pool_mutex);
+        g_pool_mutex = NULL;
+    }
+
     // if we successfully created a mutex previously, then destroy it now
     if (g_ogg_mutex) {
         SDL_DestroyMutex(g_ogg_mutex);
@@ -353,112 +758,104 @@ void ldp_vldp::audio_shutdown()
     }
 }
 
+// stops using the current audio stream (it stays in the pool in case we come
+// back to it)
 void ldp_vldp::close_audio_stream()
 {
     OGG_LOCK;
 
     g_audio_ready   = false;
     g_audio_playing = false;
-    ov_clear(&s_ogg);
+
+    SDL_LockMutex(g_pool_mutex);
+    g_cur_seg = NULL;
+    SDL_UnlockMutex(g_pool_mutex);
 
     OGG_UNLOCK;
 }
 
 bool ldp_vldp::open_audio_stream(const string &strFilename)
 {
-    bool result              = false;
-    ov_callbacks mycallbacks = {mmread, mmseek, mmclose, mmtell};
+    bool result             = false;
+    string strPath          = m_mpeg_path + strFilename;
+    ogg_segment_s *pSeg     = NULL;
+    ogg_segment_s *pEvicted = NULL;
 
     OGG_LOCK; // can't have audio callback running during this
 
     // if an audio stream is already open, close it first
-    if (g_pIOAudioHandle != 0) {
+    if (g_cur_seg) {
         close_audio_stream();
     }
 
-    mmreset(); // reset the mm wrappers for new use
-
-    g_pIOAudioHandle = mpo_open((m_mpeg_path + strFilename).c_str(), MPO_OPEN_READONLY);
-    // if audio file was opened successfully
-    if (g_pIOAudioHandle) {
-        g_audio_filesize = static_cast<unsigned int>(g_pIOAudioHandle->size & 0xFFFFFFFF);
-#ifdef TRY_MMAP
-        g_big_buf = (Uint8 *)mmap(NULL, g_audio_filesize, PROT_READ, MAP_PRIVATE,
-                                  fileno(g_pIOAudioHandle->handle), 0);
-        if (!g_big_buf) {
-            LOGE << "mmap failed";
-        }
-#else
-        g_big_buf = new unsigned char[g_audio_filesize];
-        if (g_big_buf) {
-            mpo_read(g_big_buf, g_audio_filesize, NULL,
-                     g_pIOAudioHandle); // read entire stream into RAM
-        } else {
-            LOGE << "out of memory";
-        }
-#endif
-        if (g_big_buf) {
-            int open_result = ov_open_callbacks(g_big_buf, &s_ogg, NULL, 0, mycallbacks);
-
-            // if we opening the .OGG succeeded
-            if (open_result == 0) {
-                // now check to make sure it's stereo and the proper sample rate
-                vorbis_info *info = ov_info(&s_ogg, -1);
-
-                // if they meet the proper specification, let them proceed
-                if ((info->channels == 2) && (info->rate == 44100)) {
-                    g_audio_ready = true;
-                    result        = true;
-                } else {
-                    LOGE << ".ogg file must have 2 channels and 44100 Hz";
-                    LOGE << fmt(".ogg file has %u channel(s) and is %ld Hz",
-                                info->channels, info->rate);
-                    LOGE << ".ogg file ignored (you won't hear any audio)";
-                }
-            } else {
-                LOGE << fmt("ov_open_callbacks failed! Error code is %d",
-                            open_result);
-                LOGE << fmt("OV_EREAD=%d OV_ENOTVORBIS=%d OV_EVERSION=%d "
-                            "OV_EBADHEADER=%d OV_EFAULT=%d\n",
-                            OV_EREAD,
-                            OV_ENOTVORBIS,
-                            OV_EVERSION,
-                            OV_EBADHEADER,
-                            OV_EFAULT);
-            }
-        }
-        // else we've already printed error messages, so we don't need to do
-        // anything else
-
-        // close file if we got an earlier error
-        if (!result) {
-            mpo_close(g_pIOAudioHandle);
-            g_pIOAudioHandle = NULL;
-
-            // if we have memory allocated, de-allocate it
-            if (g_big_buf) {
-#ifdef TRY_MMAP
-                munmap(g_big_buf, g_audio_filesize);
-#else
-                delete[] g_big_buf;
-#endif
-                g_big_buf = NULL;
-            }
+    // hopefully it's already been loaded
+    // (it has to become current right away so that the loader thread can't
+    // throw it out)
+    SDL_LockMutex(g_pool_mutex);
+    pSeg      = pool_find(strPath);
+    g_cur_seg = pSeg;
+    SDL_UnlockMutex(g_pool_mutex);
+
+    if (pSeg) {
+        // it may have been played before, so rewind it
+        ov_pcm_seek(&pSeg->ogg, 0);
+    } else {
+        pSeg = ogg_segment_open(strPath, true);
+        if (pSeg) {
+            SDL_LockMutex(g_pool_mutex);
+            pEvicted  = pool_add(pSeg);
+            g_cur_seg = pSeg;
+            SDL_UnlockMutex(g_pool_mutex);
         }
-
-    } // end if we could open file
-    else {
 // don't show this message to end-users, a surprising number of them report this
 // as a bug and it's really getting annoying :)
-        LOGD << "No audio file (" << strFilename <<
-            ") was found to go with the opened video file";
+        else {
+            LOGD << "No audio file (" << strFilename <<
+                ") was found to go with the opened video file";
+        }
+    }
+
+    if (pSeg) {
+        g_audio_ready = true;
+        result        = true;
     }
 
     OGG_UNLOCK;
 
+    if (pEvicted) {
+        ogg_segment_close(pEvicted);
+    }
+
     return result;
 }
 
+void ldp_vldp::prefetch_adjacent_audio()
+{
+    string oggname;
+
+    if (!g_loader_thread) {
+        return;
+    }
+
+    SDL_LockMutex(g_pool_mutex);
+
+    // whatever we guessed last time is no longer interesting
+    g_lstPrefetch.clear();
+
+    // playback usually carries on into the next file, so that one goes first
+    if (m_cur_mpeg_index + 1 < m_file_index) {
+        oggize_path(oggname, m_mpeginfo[m_cur_mpeg_index + 1].name);
+        g_lstPrefetch.push_back(m_mpeg_path + oggname);
+    }
+    if (m_cur_mpeg_index > 0) {
+        oggize_path(oggname, m_mpeginfo[m_cur_mpeg_index - 1].name);
+        g_lstPrefetch.push_back(m_mpeg_path + oggname);
+    }
+
+    SDL_CondSignal(g_loader_cond);
+    SDL_UnlockMutex(g_pool_mutex);
+}
+
 // seeks to a sample position in the audio stream
 // returns true if successful or false if failed
 bool ldp_vldp::seek_audio(Uint64 u64Samples)
@@ -467,8 +864,11 @@ bool ldp_vldp::seek_audio(Uint64 u64Samples)
 
     OGG_LOCK; // can't have audio callback running during this
 
-    if (ov_seekable(&s_ogg)) {
-        ov_pcm_seek(&s_ogg, u64Samples);
+    if (g_cur_seg && ov_seekable(&g_cur_seg->ogg)) {
+        // the seek index saves vorbisfile from bisecting the whole stream
+        if (!seek_index_seek(g_cur_seg, u64Samples)) {
+            ov_pcm_seek(&g_cur_seg->ogg, u64Samples);
+        }
         g_audio_playing = false; // audio should not be playing immediately
                                  // after a seek
         result = true;
@@ -508,6 +908,8 @@ int g_leftover_samples                = 0;
 // our audio callback
 void ldp_vldp_audio_callback(Uint8 *stream, int len, int unused)
 {
+    TRACE_SCOPE("ldp_vldp_audio_callback");
+
 #ifdef AUDIO_DEBUG
     g_u64CallbackByteCount += len;
     unsigned int uFloodTimer = (GET_TICKS() - g_uCallbackDbgTimer) / 1000;
@@ -556,7 +958,7 @@ void ldp_vldp_audio_callback(Uint8 *stream, int len, int unused)
 
             while (samples_copied < len) {
                 samples_read =
-                    ov_read(&s_ogg, &g_small_buf[0], AUDIO_BUF_CHUNK, 0, 2, 1, &nop);
+                    ov_read(&g_cur_seg->ogg, &g_small_buf[0], AUDIO_BUF_CHUNK, 0, 2, 1, &nop);
 
                 if (samples_read > 0) {
                     bytes_to_read = len - samples_copied; // how much space we
@@ -638,6 +1040,7 @@ void ldp_vldp_audio_callback(Uint8 *stream, int len, int unused)
                             correct_samples,
                             g_playing_timer,
                             g_ldp->get_elapsed_ms_since_play());
+                perfstats::add_value(perfstats::VALUE_DISC_AUDIO_BEHIND, 1);
                 audio_caught_up = false;
                 SDL_Delay(0); // don't starve other processes while trying to
                               // catch up
@@ -41,6 +41,7 @@
 #include "../io/network.h" // to query amount of RAM the system has (get_sys_mem)
 #include "../io/numstr.h"  // for debug
 #include "../timer/timer.h"
+#include "../timer/perfstats.h"
 #include "../video/palette.h"
 #include "../video/rgb2yuv.h"
 #include "../video/video.h"
@@ -122,15 +123,20 @@ ldp_vldp::ldp_vldp()
     m_bFramefileSet      = false;
     m_altaudio_suffix    = ""; // no alternate audio by default
     m_audio_file_opened  = false;
+    m_bOpenPending       = false;
+    m_uPendingSeekDelayMs = 0;
     m_cur_ldframe_offset = 0;
+    m_cur_mpeg_index     = 0;
     m_blank_on_searches  = false;
     m_blank_on_skips     = false;
     m_seek_frames_per_ms = 0;
     m_min_seek_delay     = 0;
+    m_uDecodeThreads     = 1;
 
     m_testing = false; // don't run tests by default
 
     m_bPreCache = m_bPreCacheForce = false;
+    m_u64SearchStartNs = 0;
     m_mPreCachedFiles.clear();
 
     m_uSoundChipID = 0;
@@ -167,6 +173,8 @@ bool ldp_vldp::init_player()
                 g_local_info.render_blank_frame    = blank_overlay;
                 g_local_info.blank_during_searches = m_blank_on_searches;
                 g_local_info.blank_during_skips    = m_blank_on_skips;
+                g_local_info.unthrottled           = get_unthrottled() ? 1 : 0;
+                g_local_info.decode_threads        = m_uDecodeThreads;
                 g_local_info.GetTicksFunc          = GetTicksFunc;
 
                 g_vldp_info = vldp_init(&g_local_info);
@@ -298,6 +306,18 @@ void ldp_vldp::shutdown_player()
     free_yuv_overlay(); // de-allocate overlay if we have one allocated ...
 }
 
+bool ldp_vldp::start_open(const string &strFilename)
+{
+    // see if this filename has been precached
+    map<string, unsigned int>::const_iterator mi = m_mPreCachedFiles.find(strFilename);
+
+    // if the file has not been precached and we are able to open it
+    return ((mi == m_mPreCachedFiles.end() &&
+         (g_vldp_info->open((m_mpeg_path + strFilename).c_str())))
+        // OR if the file has been precached and we are able to refer to it
+        || (g_vldp_info->open_precached(mi->second, (m_mpeg_path + strFilename).c_str())));
+}
+
 bool ldp_vldp::open_and_block(const string &strFilename)
 {
     bool bResult = false;
@@ -307,14 +327,7 @@ bool ldp_vldp::open_and_block(const string &strFilename)
     // command is called. Otherwise we'd put it inside wait_for_status ...
     blitting_allowed = true;
 
-    // see if this filename has been precached
-    map<string, unsigned int>::const_iterator mi = m_mPreCachedFiles.find(strFilename);
-
-    // if the file has not been precached and we are able to open it
-    if ((mi == m_mPreCachedFiles.end() &&
-         (g_vldp_info->open((m_mpeg_path + strFilename).c_str())))
-        // OR if the file has been precached and we are able to refer to it
-        || (g_vldp_info->open_precached(mi->second, (m_mpeg_path + strFilename).c_str()))) {
+    if (start_open(strFilename)) {
         bResult = wait_for_status(STAT_STOPPED, strFilename.c_str());
         if (bResult) {
             m_cur_mpeg_filename = strFilename;
@@ -347,20 +360,17 @@ bool ldp_vldp::precache_and_block(const string &strFilename)
 bool ldp_vldp::wait_for_status(unsigned int uStatus, const string &strFilename)
 {
     bool bResult = false;
+    unsigned int uPolls = 0;
 
     while (g_vldp_info->status == STAT_BUSY) {
-        // if we got a parse update, then show it ...
-        if (g_bGotParseUpdate) {
-            // redraw screen blitter before we display it
-            update_parse_meter(strFilename);
-            video::vid_blank();
-            // vid_blit(get_screen_blitter(), 0, 0);
-            // video::vid_flip();
-            g_bGotParseUpdate = false;
-        }
+        show_parse_update(strFilename);
 
         SDL_check_input(); // so that windows events are handled
-        make_delay(20);    // be nice to CPU
+
+        // Opening a file that VLDP has seen recently only takes a moment, so
+        // poll quickly at first so that switching between the files of a
+        // framefile doesn't stall us for a whole 20 ms each time.
+        make_delay((uPolls++ < 20) ? 1 : 20); // be nice to CPU
     }
 
     // if opening succeeded
@@ -371,17 +381,34 @@ bool ldp_vldp::wait_for_status(unsigned int uStatus, const string &strFilename)
     return bResult;
 }
 
+void ldp_vldp::show_parse_update(const string &strFilename)
+{
+    // if we got a parse update, then show it ...
+    // (VLDP waits for us to do so before it carries on)
+    if (g_bGotParseUpdate) {
+        // redraw screen blitter before we display it
+        update_parse_meter(strFilename);
+        video::vid_blank();
+        // vid_blit(get_screen_blitter(), 0, 0);
+        // video::vid_flip();
+        g_bGotParseUpdate = false;
+    }
+}
+
 bool ldp_vldp::nonblocking_search(char *frame)
 {
 
     bool result                = false;
     string filename            = "";
-    string oggname             = "";
     Uint32 target_ld_frame     = (Uint32)atoi(frame);
-    Uint64 u64AudioTargetPos   = 0; // position in audio to seek to (in samples)
     unsigned int seek_delay_ms = 0; // how many ms this seek must be delayed (to
                                     // simulate laserdisc lag)
 
+    m_u64SearchStartNs = perfstats::get_ns();
+
+    // a search to another file may still be waiting on its open
+    drop_pending_open();
+
     audio_pause(); // pause the audio before we seek so we don't have overrun
 
     // do we need to compute seek_delay_ms?
@@ -416,72 +443,31 @@ bool ldp_vldp::nonblocking_search(char *frame)
 
     // if we can convert target frame into a filename, do it!
     if (filename != "") {
-        result = true; // now we assume success unless we fail
-
         // if the file to be opened is different from the one we have opened
         // OR if we don't yet have a file open ...
         // THEN open the file! :)
+        // VLDP can take a while to open (or even parse) it, so we don't wait
+        // here; get_search_result() sends the search once the file is open.
         if (filename != m_cur_mpeg_filename) {
-            // if we were able to successfully open the video file
-            if (open_and_block(filename)) {
-                result = true;
-
-                // this is done inside open_and_block now ...
-                // m_cur_mpeg_filename = filename; // make video file our new
-                // current file
-
-                // if sound is enabled, try to open an audio stream to match the
-                // video stream
-                if (sound::is_enabled()) {
-                    // try to open an optional audio file to go along with video
-                    oggize_path(oggname, filename);
-                    m_audio_file_opened = open_audio_stream(oggname.c_str());
-                }
+            // the parse meter gets drawn if this is the first time VLDP has
+            // seen the file (same as open_and_block)
+            blitting_allowed = true;
+
+            if (start_open(filename)) {
+                m_bOpenPending        = true;
+                m_strPendingFilename  = filename;
+                m_uPendingSeekDelayMs = seek_delay_ms;
+                result                = true;
             } else {
+                blitting_allowed = false;
                 LOGW << fmt("LDP-VLDP: Could not open video file %s", filename.c_str());
-                result = false;
             }
         }
 
-        // if we're ok so far, try the search
-        if (result) {
-            // IMPORTANT : 'uFPKS' _must_ be queried AFTER a new mpeg has been
-            // opened, because sometimes a framefile can include mpegs that have
-            // different framerates from each other.
-            uint32_t uFPKS = g_vldp_info->uFpks;
-
-            m_discvideo_width  = g_vldp_info->w;
-            m_discvideo_height = g_vldp_info->h;
-
-            // IMPORTANT : this must come before the optional FPS adjustment
-            // takes place!!!
-            u64AudioTargetPos = get_audio_sample_position(m_target_mpegframe);
-
-            if (!need_frame_conversion()) {
-                // If the mpeg's FPS and the disc's FPS differ, we need to
-                // adjust the mpeg frame
-                // NOTE: AVOID this if you can because it makes seeking less
-                // accurate
-                if (g_game->get_disc_fpks() != uFPKS) {
-                    LOGI << fmt("NOTE: converting FPKS from %d to %d. This may "
-                                "be less accurate.",
-                                g_game->get_disc_fpks(), uFPKS);
-                    m_target_mpegframe =
-                        (m_target_mpegframe * uFPKS) / g_game->get_disc_fpks();
-                }
-            }
-
-            // try to search to the requested frame
-            if (g_vldp_info->search((Uint32)m_target_mpegframe, seek_delay_ms)) {
-                // if we have an audio file opened, do an audio seek also
-                if (m_audio_file_opened) {
-                    result = seek_audio(u64AudioTargetPos);
-                }
-            } else {
-                LOGW << "Search failed in video file";
-            }
+        // the file is already open, so search right away
+        else {
+            result = send_search(seek_delay_ms);
         }
-        // else opening the file failed
     }
     // else mpeg_info() wasn't able to provide a filename ...
     else {
@@ -494,14 +480,141 @@ bool ldp_vldp::nonblocking_search(char *frame)
     return (result);
 }
 
+// finishes opening the file a search was waiting on, once VLDP is done with it
+bool ldp_vldp::finish_open()
+{
+    string oggname = "";
+
+    m_bOpenPending   = false;
+    blitting_allowed = false;
+
+    if (g_vldp_info->status != STAT_STOPPED) {
+        LOGW << fmt("LDP-VLDP: Could not open video file %s", m_strPendingFilename.c_str());
+
+        // VLDP may have closed the old file, so be sure to reopen it next time
+        m_cur_mpeg_filename = "";
+        return false;
+    }
+
+    m_cur_mpeg_filename = m_strPendingFilename;
+
+    // if sound is enabled, try to open an audio stream to match the
+    // video stream
+    if (sound::is_enabled()) {
+        // try to open an optional audio file to go along with video
+        oggize_path(oggname, m_cur_mpeg_filename);
+        m_audio_file_opened = open_audio_stream(oggname.c_str());
+        prefetch_adjacent_audio();
+    }
+
+    return true;
+}
+
+void ldp_vldp::drop_pending_open()
+{
+    if (m_bOpenPending) {
+        // VLDP has to finish the open before it takes another command, and
+        // the file is then the one it has open, so use it
+        wait_for_status(STAT_STOPPED, m_strPendingFilename);
+        if (finish_open()) {
+            preopen_adjacent_video();
+        }
+    }
+}
+
+// asks VLDP to open the mpegs before and after m_cur_mpeg_index ahead of time
+void ldp_vldp::preopen_adjacent_video()
+{
+    // playback usually carries on into the next file, so that one goes first
+    if (m_cur_mpeg_index + 1 < m_file_index) {
+        preopen_video(m_mpeginfo[m_cur_mpeg_index + 1].name);
+    }
+    if (m_cur_mpeg_index > 0) {
+        preopen_video(m_mpeginfo[m_cur_mpeg_index - 1].name);
+    }
+}
+
+void ldp_vldp::preopen_video(const string &strFilename)
+{
+    // precached files are already in RAM, and a framefile can list the same
+    // file more than once
+    if ((strFilename != m_cur_mpeg_filename) &&
+        (m_mPreCachedFiles.find(strFilename) == m_mPreCachedFiles.end())) {
+        g_vldp_info->preopen((m_mpeg_path + strFilename).c_str());
+    }
+}
+
+// the part of a search that needs the right file open
+bool ldp_vldp::send_search(unsigned int seek_delay_ms)
+{
+    bool result              = false;
+    Uint64 u64AudioTargetPos = 0; // position in audio to seek to (in samples)
+
+    // IMPORTANT : 'uFPKS' _must_ be queried AFTER a new mpeg has been
+    // opened, because sometimes a framefile can include mpegs that have
+    // different framerates from each other.
+    uint32_t uFPKS = g_vldp_info->uFpks;
+
+    m_discvideo_width  = g_vldp_info->w;
+    m_discvideo_height = g_vldp_info->h;
+
+    // IMPORTANT : this must come before the optional FPS adjustment
+    // takes place!!!
+    u64AudioTargetPos = get_audio_sample_position(m_target_mpegframe);
+
+    if (!need_frame_conversion()) {
+        // If the mpeg's FPS and the disc's FPS differ, we need to
+        // adjust the mpeg frame
+        // NOTE: AVOID this if you can because it makes seeking less
+        // accurate
+        if (g_game->get_disc_fpks() != uFPKS) {
+            LOGI << fmt("NOTE: converting FPKS from %d to %d. This may "
+                        "be less accurate.",
+                        g_game->get_disc_fpks(), uFPKS);
+            m_target_mpegframe =
+                (m_target_mpegframe * uFPKS) / g_game->get_disc_fpks();
+        }
+    }
+
+    // try to search to the requested frame
+    if (g_vldp_info->search((Uint32)m_target_mpegframe, seek_delay_ms)) {
+        result = true;
+
+        // if we have an audio file opened, do an audio seek also
+        if (m_audio_file_opened) {
+            result = seek_audio(u64AudioTargetPos);
+        }
+    } else {
+        LOGW << "Search failed in video file";
+    }
+
+    return (result);
+}
+
 // it should be safe to assume that if this function is getting called, that we
 // have not yet got a result from the search
 int ldp_vldp::get_search_result()
 {
     int result = SEARCH_BUSY; // default to no change
 
+    // still waiting for VLDP to open the file the frame is in
+    if (m_bOpenPending) {
+        if (g_vldp_info->status == STAT_BUSY) {
+            show_parse_update(m_strPendingFilename);
+            return SEARCH_BUSY;
+        }
+
+        if (finish_open() && send_search(m_uPendingSeekDelayMs)) {
+            // (after the search, so that VLDP gets to it first)
+            preopen_adjacent_video();
+            return SEARCH_BUSY; // the search itself has only just started
+        }
+
+        result = SEARCH_FAIL;
+    }
+
     // if search is finished and has succeeded
-    if (g_vldp_info->status == STAT_PAUSED) {
+    else if (g_vldp_info->status == STAT_PAUSED) {
         result = SEARCH_SUCCESS;
     }
 
@@ -512,6 +625,10 @@ int ldp_vldp::get_search_result()
 
     // else it's busy so we just wait ...
 
+    if (result != SEARCH_BUSY) {
+        perfstats::add_timing(perfstats::TIMING_SEARCH, perfstats::get_ns() - m_u64SearchStartNs);
+    }
+
     return result;
 }
 
@@ -520,6 +637,7 @@ unsigned int ldp_vldp::play()
     unsigned int result = 0;
     string ogg_path     = "";
     bool bOK            = true; // whether it's ok to issue the play command
+    bool bOpened        = false; // whether we had to open the first mpeg
 
     // if we haven't opened any mpeg file yet, then do so now
     if (m_cur_mpeg_filename == "") {
@@ -528,6 +646,8 @@ unsigned int ldp_vldp::play()
         if (bOK) {
             // this is done inside open_and_block now ...
             // m_cur_mpeg_filename = m_mpeginfo[0].name;
+            m_cur_mpeg_index = 0;
+            bOpened          = true;
 
             // if sound is enabled, try to load an audio stream to go with video
             // stream ...
@@ -535,6 +655,7 @@ unsigned int ldp_vldp::play()
                 // try to open an optional audio file to go along with video
                 oggize_path(ogg_path, m_mpeginfo[0].name);
                 m_audio_file_opened = open_audio_stream(ogg_path.c_str());
+                prefetch_adjacent_audio();
             }
 
         } else {
@@ -552,6 +673,9 @@ unsigned int ldp_vldp::play()
         audio_play(0);
         if (g_vldp_info->play(0)) {
             result = GET_TICKS();
+
+            // (after the play, so that VLDP gets to it first)
+            if (bOpened) preopen_adjacent_video();
         }
     }
 
@@ -620,6 +744,9 @@ bool ldp_vldp::skip_forward(Uint32 frames_to_skip, Uint32 target_frame)
     return result;
 }
 
+// (ldp::pre_stop() forgets about any search in progress)
+void ldp_vldp::stop() { drop_pending_open(); }
+
 void ldp_vldp::pause()
 {
 #ifdef DEBUG
@@ -666,6 +793,11 @@ void ldp_vldp::think()
     // VLDP relies on this number
     // (m_uBlockedMsSincePlay is only non-zero when we've used blocking seeking)
     g_local_info.uMsTimer = m_uElapsedMsSincePlay + m_uBlockedMsSincePlay;
+
+    if (g_vldp_info) {
+        perfstats::set_value(perfstats::VALUE_FRAMES_DECODED, g_vldp_info->uFramesDecoded);
+        perfstats::set_value(perfstats::VALUE_FRAMES_DROPPED, g_vldp_info->uFramesDropped);
+    }
 }
 
 #ifdef DEBUG
@@ -755,11 +887,33 @@ void ldp_vldp::set_min_seek_delay(unsigned int value)
     m_min_seek_delay = value;
 }
 
+void ldp_vldp::set_decode_threads(unsigned int value)
+{
+    m_uDecodeThreads = value;
+}
+
 unsigned int ldp_vldp::get_min_seek_delay()
 {
     return m_min_seek_delay;
 }
 
+bool ldp_vldp::get_frame_counts(unsigned int &uDecoded, unsigned int &uDropped)
+{
+    if (!g_vldp_info) return false;
+
+    uDecoded = g_vldp_info->uFramesDecoded;
+    uDropped = g_vldp_info->uFramesDropped;
+    return true;
+}
+
+bool ldp_vldp::get_vldp_frame(unsigned int &uFrame)
+{
+    if (!g_vldp_info) return false;
+
+    uFrame = g_vldp_info->current_frame;
+    return true;
+}
+
 // sets the name of the frame file
 void ldp_vldp::set_framefile(const char *filename)
 {
@@ -1260,6 +1414,7 @@ Uint32 ldp_vldp::mpeg_info(string &filename, Sint32 ld_frame)
             filename             = m_mpeginfo[index].name;
             mpeg_frame           = (Uint32)(ld_frame - m_mpeginfo[index].frame);
             m_cur_ldframe_offset = m_mpeginfo[index].frame;
+            m_cur_mpeg_index     = index;
         } else {
             LOGW << "no filename found";
             mpeg_frame = 0;
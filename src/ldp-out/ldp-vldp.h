@@ -61,6 +61,9 @@ class ldp_vldp : public ldp
 
     // NOTE : open_and_block prepands m_mpeg_path to the filename
     bool open_and_block(const string &strFilename);
+
+    // sends the open command without waiting for it to finish
+    bool start_open(const string &strFilename);
     bool precache_and_block(const string &strFilename);
     bool wait_for_status(unsigned int uStatus, const string &strFilename);
     bool nonblocking_search(char *);
@@ -68,6 +71,7 @@ class ldp_vldp : public ldp
     unsigned int play();
     bool skip_forward(Uint32 frames_to_skip, Uint32 target_frame);
     void pause();
+    void stop();
     bool change_speed(unsigned int uNumerator, unsigned int uDenominator);
     void think();
 #ifdef DEBUG
@@ -79,6 +83,7 @@ class ldp_vldp : public ldp
     void set_seek_frames_per_ms(double value);
     void set_min_seek_delay(unsigned int);
     void set_framefile(const char *filename);
+    void set_decode_threads(unsigned int);
     void set_altaudio(const char *audio_suffix);
 
     void test_helper(unsigned uIterations);
@@ -93,6 +98,13 @@ class ldp_vldp : public ldp
 
     unsigned int get_min_seek_delay();
 
+    // how many frames VLDP has decoded, and how many of those were dropped
+    // because they were late (returns false if VLDP isn't running)
+    bool get_frame_counts(unsigned int &uDecoded, unsigned int &uDropped);
+
+    // the frame of the mpeg VLDP is on (returns false if VLDP isn't running)
+    bool get_vldp_frame(unsigned int &uFrame);
+
     // parses framefile (contained in pszInBuf) and returns the
     // absolute/relative path to the mpegs in 'sMpegPath',
     //  and populates 'pFrames' until it runs out of data, or hits the
@@ -131,9 +143,27 @@ class ldp_vldp : public ldp
     // NOTE : 'filename' does not include the prefix path
     Uint32 mpeg_info(string &filename, Sint32 ld_frame);
 
+    // the halves of nonblocking_search() that wait for the right file to
+    //  be open
+    bool finish_open();
+    bool send_search(unsigned int seek_delay_ms);
+
+    // waits for a file a search no longer wants to finish opening
+    void drop_pending_open();
+
+    // asks VLDP to have the mpegs before and after m_cur_mpeg_index open
+    //  before they are needed
+    void preopen_adjacent_video();
+    void preopen_video(const string &strFilename);
+
+    // shows how far along parsing is, if VLDP has told us
+    void show_parse_update(const string &strFilename);
+
     Sint32 m_target_mpegframe;   // mpeg frame # we are seeking to
     Sint32 m_cur_ldframe_offset; // which laserdisc frame corresponds to the
                                  // first frame in current mpeg file
+    unsigned int m_cur_mpeg_index; // index into m_mpeginfo of the mpeg file
+                                   // that mpeg_info() last returned
 
     // strings
     string m_cur_mpeg_filename; // name of the mpeg file we currently have open
@@ -158,6 +188,7 @@ class ldp_vldp : public ldp
                                      // millisecond (0 = no limit)
     unsigned int m_min_seek_delay;   // min # of milliseconds to force seek to
                                      // last
+    unsigned int m_uDecodeThreads;   // how many threads VLDP decodes on
     bool m_testing;   // should we do a few simple tests to make sure VLDP is
                       // functioning robustly?
     bool m_bPreCache; // should we precache all video?
@@ -170,6 +201,13 @@ class ldp_vldp : public ldp
     // holds a record of all precached files (and their associated indices)
     map<string, unsigned int> m_mPreCachedFiles;
 
+    Uint64 m_u64SearchStartNs; // when the search in progress was requested
+
+    // set while a search waits for VLDP to open the file its frame is in
+    bool m_bOpenPending;
+    string m_strPendingFilename;
+    unsigned int m_uPendingSeekDelayMs;
+
     //////////////////////////////////////////////////
 
     // stuff inside ldp-vldp-audio.cpp
@@ -186,6 +224,10 @@ class ldp_vldp : public ldp
     void audio_shutdown();
     void close_audio_stream();
     bool open_audio_stream(const string &strFilename);
+
+    // queues up the audio of the mpegs before and after m_cur_mpeg_index to
+    // be loaded in the background
+    void prefetch_adjacent_audio();
     bool seek_audio(Uint64 u64Samples);
     void audio_play(Uint32);
     void audio_pause();
@@ -38,9 +38,12 @@
 #include "../cpu/generic_z80.h"
 #include "../game/boardinfo.h"
 #include "../game/game.h"
+#include "../hypseus.h"
 #include "../io/conout.h"
 #include "../io/my_stdio.h"
 #include "../timer/timer.h"
+#include "../timer/perfstats.h"
+#include "../video/golden.h"
 #include "framemod.h"
 #include "ldp.h"
 #include <plog/Log.h>
@@ -61,7 +64,8 @@ ldp::ldp()
       m_status(LDP_STOPPED), search_latency(0), m_stop_on_quit(false),
       m_discvideo_width(640), m_discvideo_height(480),
       m_use_nonblocking_searching(true), m_dont_get_search_result(false),
-      m_sram_continuous_update(false), m_noldp_timer(0), m_uCurrentFrame(0),
+      m_sram_continuous_update(false), m_noldp_timer(0),
+      m_uSearchState(SEARCH_STATE_IDLE), m_uCurrentFrame(0),
       m_uCurrentOffsetFrame(0), m_uElapsedMsSincePlay(0), m_uBlockedMsSincePlay(0),
       m_bWaitingForVblankToPlay(false), m_iSkipOffsetSincePlay(0),
       m_uMsFrameBoundary(0), m_uElapsedMsSinceStart(0), m_uVblankCount(0),
@@ -142,6 +146,13 @@ bool ldp::pre_search(const char *pszFrame, bool block_until_search_finishes)
 
     if (strlen(pszFrame) == 6) fs = 6;
 
+    // a search that is still finishing in the background has to be done
+    // before the next one can start
+    if (m_uSearchState != SEARCH_STATE_IDLE) {
+        if (m_bVerbose) { LOGD << "waiting for the previous search to finish"; }
+        wait_for_search();
+    }
+
     // safety check, if they try to search without checking the search result
     // ...
     if (m_status == LDP_SEARCHING) {
@@ -245,59 +256,14 @@ bool ldp::pre_search(const char *pszFrame, bool block_until_search_finishes)
 
         // if search succeeded
         if (result) {
+            m_uSearchState = SEARCH_STATE_PENDING;
+
             // if we are to block until the search finishes, then wait here
             // (this is bad, don't do this!)
             // This is only here for backward compatibility!
             if (block_until_search_finishes) {
-                unsigned int cur_time  = refresh_ms_time();
-                unsigned int uLastTime = cur_time; // used to compute
-                                                   // m_uBlockedMsSincePlay
-                int ldp_stat = -1;
-
-                // we know we may be waiting for a while, so we pause the cpu
-                // timer to avoid getting a flood after the seek completes
-                cpu::pause();
-
-                // wait for player to change its status or for us to timeout
-                while (elapsed_ms_time(cur_time) < 7000) {
-                    ldp_stat = get_status(); // get_status does some stuff that
-                                             // needs to get done, so we don't
-                                             // just read m_status instead
-
-                    // if the search is finished
-                    if (ldp_stat != LDP_SEARCHING) {
-                        break;
-                    }
-
-                    // Since the cpu is paused, we should not use think_delay
-                    // Also, blocking seeking may be used for skipping in noldp
-                    // mode for cpu games like super don,
-                    //  so we cannot use think_delay here.
-                    MAKE_DELAY(1);
-
-                    // VLDP relies on our timers for its timing, so we need to
-                    // keep the time moving forward during
-                    //  this period where we're paused. (and we can't use
-                    //  think_delay or pre_think because it can
-                    //  cause vblank events which can cause irqs while the cpu
-                    //  is supposed to be paused)
-                    unsigned int uCurTimeTmp = refresh_ms_time();
-                    m_uBlockedMsSincePlay +=
-                        (uCurTimeTmp - uLastTime); // since we're blocked, the
-                                                   // blockmssinceplay must
-                                                   // increase
-                    uLastTime = uCurTimeTmp;
-                    think();
-                }
-
-                cpu::unpause(); // done with the delay, so we can unpause
-
-                // if we didn't succeed, then return an error
-                if (ldp_stat != LDP_PAUSED) {
-                    if (m_bVerbose) { LOGD << "blocking search didn't succeed"; }
-                    result = false;
-                }
-            } // end if we were doing a blocking styled search
+                result = wait_for_search();
+            }
         }     // if the initial search command was accepted
 
         // else if search failed immediately
@@ -311,6 +277,65 @@ bool ldp::pre_search(const char *pszFrame, bool block_until_search_finishes)
     return (result);
 }
 
+bool ldp::wait_for_search()
+{
+    unsigned int cur_time  = refresh_ms_time();
+    unsigned int uLastTime = cur_time; // used to compute
+                                       // m_uBlockedMsSincePlay
+    int ldp_stat = -1;
+
+    // we know we may be waiting for a while, so we pause the cpu
+    // timer to avoid getting a flood after the seek completes
+    cpu::pause();
+
+    // wait for player to change its status or for us to timeout
+    while (elapsed_ms_time(cur_time) < 7000) {
+        ldp_stat = get_status(); // get_status does some stuff that
+                                 // needs to get done, so we don't
+                                 // just read m_status instead
+
+        // if the search is finished
+        if (ldp_stat != LDP_SEARCHING) {
+            break;
+        }
+
+        // Since the cpu is paused, we should not use think_delay
+        // Also, blocking seeking may be used for skipping in noldp
+        // mode for cpu games like super don,
+        //  so we cannot use think_delay here.
+        MAKE_DELAY(1);
+
+        // VLDP relies on our timers for its timing, so we need to
+        // keep the time moving forward during
+        //  this period where we're paused. (and we can't use
+        //  think_delay or pre_think because it can
+        //  cause vblank events which can cause irqs while the cpu
+        //  is supposed to be paused)
+        unsigned int uCurTimeTmp = refresh_ms_time();
+        m_uBlockedMsSincePlay +=
+            (uCurTimeTmp - uLastTime); // since we're blocked, the
+                                       // blockmssinceplay must
+                                       // increase
+        uLastTime = uCurTimeTmp;
+        think();
+    }
+
+    cpu::unpause(); // done with the delay, so we can unpause
+
+    // if we didn't succeed, then return an error
+    // (a play that arrived while searching has already been started)
+    if ((ldp_stat != LDP_PAUSED) && (ldp_stat != LDP_PLAYING)) {
+        if (m_bVerbose) { LOGD << "blocking search didn't succeed"; }
+        return false;
+    }
+
+    return true;
+}
+
+bool ldp::is_search_pending() { return (m_uSearchState != SEARCH_STATE_IDLE); }
+
+Uint32 ldp::get_search_target_frame() { return m_last_try_frame; }
+
 // don't call this function directly, call pre_search instead
 bool ldp::nonblocking_search(char *new_frame)
 {
@@ -465,6 +490,13 @@ void ldp::pre_play()
 {
     //	Uint32 cpu_hz;	// used to calculate elapsed cycles
 
+    // if a search is still finishing, play as soon as it has
+    if ((m_status == LDP_SEARCHING) && (m_uSearchState != SEARCH_STATE_IDLE)) {
+        if (m_bVerbose) { LOGD << "will play once the search finishes"; }
+        m_uSearchState = SEARCH_STATE_PENDING_PLAY;
+        return;
+    }
+
     // safety check, if they try to play without checking the search result ...
     // THIS SAFETY CHECK CAN BE REMOVED ONCE ALL LDP DRIVERS HAVE BEEN CONVERTED
     // OVER TO NON-BLOCKING SEEKING
@@ -535,6 +567,11 @@ void ldp::pre_pause()
     // only send pause command if disc is playing
     // some games (Super Don) repeatedly flood with a pause command and this
     // doesn't work well with the Hitachi
+    // a search ends paused anyway, so just forget about playing after it
+    if (m_uSearchState == SEARCH_STATE_PENDING_PLAY) {
+        m_uSearchState = SEARCH_STATE_PENDING;
+    }
+
     if (m_status == LDP_PLAYING) {
 #ifdef DEBUG
         string s = "m_uMsFrameBoundary is " + numstr::ToStr(m_uMsFrameBoundary) +
@@ -564,6 +601,7 @@ void ldp::pre_stop()
     m_last_seeked_frame = m_uCurrentFrame = 0;
     stop();
     m_status = LDP_STOPPED;
+    m_uSearchState = SEARCH_STATE_IDLE; // whatever it was doing, it has stopped
     if (m_bVerbose) { LOGD << "Stop"; }
 }
 
@@ -670,11 +708,22 @@ void ldp::think_delay(unsigned int uMsDelay)
         unsigned int uElapsedMs = elapsed_ms_time(m_start_time);
 
         // if we're ahead of where we need to be, then it's ok to stall ...
-        if (uElapsedMs < m_uElapsedMsSinceStart) {
+        // (unless we're supposed to run as fast as we can)
+        if ((uElapsedMs < m_uElapsedMsSinceStart) && !get_unthrottled()) {
+            Uint64 u64SleepNs = perfstats::get_ns();
             MAKE_DELAY(1);
+            perfstats::add_timing(perfstats::TIMING_PACING, perfstats::get_ns() - u64SleepNs);
         }
 
-        if (g_game->get_game_type() == GAME_SINGE) {
+        // without a cpu, this is how far behind the emulation is
+        unsigned int uMsBehind = (uElapsedMs > m_uElapsedMsSinceStart) ?
+            (uElapsedMs - m_uElapsedMsSinceStart) : 0;
+        perfstats::set_value(perfstats::VALUE_CPU_MS_BEHIND, uMsBehind);
+        perfstats::raise_value(perfstats::VALUE_CPU_MS_BEHIND_MAX, uMsBehind);
+
+        // (unthrottled runs don't catch up, so that every run does the same
+        // work)
+        if ((g_game->get_game_type() == GAME_SINGE) && !get_unthrottled()) {
             if (uElapsedMs > m_uElapsedMsSinceStart)
                 pre_think();
         }
@@ -708,6 +757,14 @@ void ldp::pre_think()
 
     ++m_uElapsedMsSinceStart;
 
+    // a benchmark always runs for the same amount of emulated time
+    if (perfstats::is_enabled() && perfstats::tick_ms()) {
+        set_quitflag();
+    }
+
+    // compare the screen against golden images at the chosen times
+    golden::think(m_uElapsedMsSinceStart);
+
     // if it's time to increase the vblank count
     if (m_uElapsedMsSinceStart >= m_uMsVblankBoundary) {
         ++m_uVblankCount;
@@ -745,7 +802,8 @@ void ldp::pre_think()
     // If the disc is supposed to be playing then compute which frame # we're on
     // IMPORTANT:
     // ldp-vldp.cpp's nonblocking_seek() RELIES on this function NOT calling
-    // get_status()!!!
+    // get_status() before the search has been sent (see the vblank check
+    // below)!!!
     // Be very careful about changing this 'm_status' to a get_status()
     if (m_status == LDP_PLAYING) {
         uint32_t uDiscFPKS = g_game->get_disc_fpks();
@@ -782,8 +840,9 @@ void ldp::pre_think()
         // (this test is only meaningful if we are emulating a cpu, because
         // otherwise we may deliberately
         //  be calling this function slower than every 1 ms, such as ffr() or
-        //  vldp's internal tests )
-        if (cpu::get_hz(0)) {
+        //  vldp's internal tests, and when unthrottled emulated time is
+        //  supposed to run ahead of real time)
+        if (cpu::get_hz(0) && !get_unthrottled()) {
             // compute milliseconds
             unsigned int uElapsedMS = elapsed_ms_time(m_play_time);
             unsigned int time_result =
@@ -823,6 +882,14 @@ void ldp::pre_think()
 
     think(); // call implementation-specific function
 
+    // Check on an outstanding search once per vblank, so that it finishes
+    // (and a queued play starts) while the emulation keeps running, even if
+    // the game driver doesn't poll get_status() itself.
+    if (bVblankAsserted && (m_uSearchState != SEARCH_STATE_IDLE) &&
+        (m_status == LDP_SEARCHING)) {
+        get_status();
+    }
+
     // If vblank was asserted, let game know about it...
     // NOTE : this should probably come at the end of this function
     if (bVblankAsserted) {
@@ -915,6 +982,11 @@ int ldp::get_status()
         assert(!m_dont_get_search_result);
 #endif
         int stat = get_search_result();
+        bool bPlay = (m_uSearchState == SEARCH_STATE_PENDING_PLAY);
+
+        if (stat != SEARCH_BUSY) {
+            m_uSearchState = SEARCH_STATE_IDLE;
+        }
 
         // if the search was successful
         if (stat == SEARCH_SUCCESS) {
@@ -931,6 +1003,10 @@ int ldp::get_status()
                 g_game->save_sram();
             }
 
+            // a play command came in while we were searching
+            if (bPlay) {
+                pre_play();
+            }
         }
 
         // if the search failed
@@ -1061,6 +1137,8 @@ bool ldp::get_use_nonblocking_searching()
 
 unsigned int ldp::get_elapsed_ms_since_play() { return m_uElapsedMsSincePlay; }
 
+unsigned int ldp::get_elapsed_ms_since_start() { return m_uElapsedMsSinceStart; }
+
 // this is called by cmdline.cpp if it gets any cmdline parameters that it
 // doesn't recognize
 // returns true if this argument was recognized and processed,
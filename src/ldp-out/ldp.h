@@ -33,6 +33,13 @@ enum {
     SEARCH_BUSY     // search is still taking place, no change yet, my frenid
 };
 
+// where a search that has been sent to the player is at
+enum {
+    SEARCH_STATE_IDLE,        // no search outstanding
+    SEARCH_STATE_PENDING,     // waiting for the player to finish
+    SEARCH_STATE_PENDING_PLAY // same, and play once it has (pre_play arrived)
+};
+
 #include <SDL.h> // needed for datatypes
 
 // for bug logging
@@ -86,8 +93,16 @@ class ldp
     // MUST also call get_status() to determine when a seek has finished.
     // If you aren't prepared to do this, make 'block_until_search_finished'
     // true.
+    // (pre_think() also checks on an outstanding search every vblank, so a
+    // driver that only looks at get_status() now and then still gets told.)
     bool pre_search(const char *, bool block_until_search_finished);
 
+    // true while a search has been sent but its result hasn't been seen yet
+    bool is_search_pending();
+
+    // the frame the last search went (or is going) to
+    Uint32 get_search_target_frame();
+
     // does the actual search. This func returns once the search has begun and
     // you need to call get_search_result
     // until the search isn't busy anymore.
@@ -240,6 +255,10 @@ class ldp
 
     unsigned int get_elapsed_ms_since_play();
 
+    // how many times pre_think has been called (ie the emulated ms since
+    // pre_init)
+    unsigned int get_elapsed_ms_since_start();
+
     // handles LDP-specific command-line arguments
     virtual bool handle_cmdline_arg(const char *arg);
 
@@ -299,6 +318,13 @@ class ldp
     // debugging)
     Uint32 m_noldp_timer;
 
+    // one of the SEARCH_STATE_* enumerations
+    unsigned int m_uSearchState;
+
+    // waits (with the cpu paused) for the outstanding search to finish
+    // returns true if it succeeded
+    bool wait_for_search();
+
     // used by 'releasetest' to do automatic self-testing
     list<string> m_bug_log;
 
@@ -21,6 +21,7 @@
  */
 
 #include "usb_scoreboard.h"
+#include "usb_writer.h"
 #include <string.h>
 #include "../io/serialib.h"
 #include "../game/lair_util.h"
@@ -31,6 +32,19 @@
 serialib g_usb_serial;
 bool g_serial_rts = false, g_serial_saeboot = false;
 
+class SerialDevice : public USBWriter::IDevice
+{
+  public:
+    bool write(const void *pBuf, unsigned int uLen) {
+        return (g_usb_serial.writeBytes(pBuf, uLen) == 1);
+    }
+};
+
+SerialDevice g_serial_device;
+
+// keeps the emulation from waiting on the serial port
+USBWriter g_usb_writer;
+
 void USBScoreboard::DeleteInstance() { delete this; }
 
 IScoreboard *USBScoreboard::GetInstance() {
@@ -101,11 +115,16 @@ bool USBScoreboard::USBInit() {
   g_usb_serial.RTS(true);
   g_serial_rts = true;
 
+  g_usb_writer.Start(&g_serial_device);
+
   return true;
 }
 
 void USBScoreboard::USBShutdown() {
 
+  // sends anything still queued
+  g_usb_writer.Stop();
+
   if (g_serial_rts) {
       g_serial_rts = false;
       LOGI << "Shutting down serial";
@@ -220,5 +239,5 @@ bool USBScoreboard::ChangeVisibility(bool bDontCare) { return false; }
 bool USBUtil::usb_connected() { return g_serial_rts; }
 
 void USBUtil::write_usb(DigitStruct ds) {
-	g_usb_serial.writeBytes((uint8_t *)&ds, sizeof(ds));
+	g_usb_writer.Queue(ds);
 }
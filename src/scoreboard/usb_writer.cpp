@@ -0,0 +1,213 @@
+/*
+ * ____ HYPSEUS COPYRIGHT NOTICE ____
+ *
+ * Copyright (C) 2026 Hypseus Singe contributors
+ *
+ * This file is part of HYPSEUS SINGE, a laserdisc arcade game emulator
+ *
+ * HYPSEUS SINGE is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * HYPSEUS SINGE is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "usb_writer.h"
+#include <plog/Log.h>
+
+static unsigned int get_slot(const DigitStruct &ds)
+{
+	return (((Uint8) ds.unit & 1) << 7) | ((Uint8) ds.digit & 0x7F);
+}
+
+USBWriter::USBWriter() : m_pDevice(NULL), m_uBatchMs(BATCH_MS), m_thread(NULL),
+	m_mutex(NULL), m_cond(NULL), m_bQuit(false), m_uOrderCount(0),
+	m_uFirstQueuedMs(0), m_uWrites(0), m_uDropped(0)
+{
+	for (unsigned int u = 0; u < SLOTS; u++) {
+		m_iQueued[u] = -1;
+		m_iShown[u] = -1;
+	}
+}
+
+USBWriter::~USBWriter()
+{
+	Stop();
+}
+
+void USBWriter::Start(IDevice *pDevice, unsigned int uBatchMs)
+{
+	Stop();
+
+	m_pDevice = pDevice;
+	m_uBatchMs = uBatchMs;
+	m_bQuit = false;
+
+	for (unsigned int u = 0; u < SLOTS; u++) {
+		m_iQueued[u] = -1;
+		m_iShown[u] = -1;
+	}
+	m_uOrderCount = 0;
+
+	m_mutex = SDL_CreateMutex();
+	m_cond = SDL_CreateCond();
+
+	if (m_mutex && m_cond) {
+		m_thread = SDL_CreateThread(ThreadProc, "USB scoreboard", this);
+	}
+
+	if (!m_thread) {
+		LOGW << "Could not start the USB scoreboard thread, writing directly";
+	}
+}
+
+void USBWriter::Stop()
+{
+	if (m_thread) {
+		SDL_LockMutex(m_mutex);
+		m_bQuit = true;
+		SDL_CondSignal(m_cond);
+		SDL_UnlockMutex(m_mutex);
+
+		SDL_WaitThread(m_thread, NULL);
+		m_thread = NULL;
+	}
+
+	if (m_cond) {
+		SDL_DestroyCond(m_cond);
+		m_cond = NULL;
+	}
+
+	if (m_mutex) {
+		SDL_DestroyMutex(m_mutex);
+		m_mutex = NULL;
+	}
+
+	m_pDevice = NULL;
+}
+
+void USBWriter::Queue(const DigitStruct &ds)
+{
+	if (!m_pDevice) return;
+
+	// no thread, so the caller has to wait on the device after all
+	if (!m_thread) {
+		if (m_pDevice->write(&ds, sizeof(ds))) m_uWrites++;
+		return;
+	}
+
+	unsigned int uSlot = get_slot(ds);
+
+	SDL_LockMutex(m_mutex);
+
+	if (m_iQueued[uSlot] == -1) {
+		if (m_uOrderCount == 0) {
+			m_uFirstQueuedMs = SDL_GetTicks();
+			SDL_CondSignal(m_cond);
+		}
+		m_uOrder[m_uOrderCount++] = (Uint8) uSlot;
+	} else {
+		// the earlier value never made it to the device
+		m_uDropped++;
+	}
+
+	m_iQueued[uSlot] = (Uint8) ds.value;
+
+	SDL_UnlockMutex(m_mutex);
+}
+
+unsigned int USBWriter::TakeBatch()
+{
+	unsigned int uCount = 0;
+
+	for (unsigned int u = 0; u < m_uOrderCount; u++) {
+		unsigned int uSlot = m_uOrder[u];
+		int iValue = m_iQueued[uSlot];
+		m_iQueued[uSlot] = -1;
+
+		// the device is already showing it
+		if (iValue == m_iShown[uSlot]) {
+			m_uDropped++;
+			continue;
+		}
+
+		m_iShown[uSlot] = iValue;
+
+		DigitStruct &ds = m_batch[uCount++];
+		ds.unit = (char) (uSlot >> 7);
+		ds.digit = (char) (uSlot & 0x7F);
+		ds.value = (char) iValue;
+	}
+
+	m_uOrderCount = 0;
+	return uCount * sizeof(DigitStruct);
+}
+
+int USBWriter::ThreadProc(void *pThis)
+{
+	((USBWriter *) pThis)->Run();
+	return 0;
+}
+
+void USBWriter::Run()
+{
+	SDL_LockMutex(m_mutex);
+
+	for (;;) {
+		while (m_uOrderCount == 0 && !m_bQuit) {
+			SDL_CondWait(m_cond, m_mutex);
+		}
+
+		if (m_uOrderCount == 0) break;	// quitting with nothing left to send
+
+		// give the rest of the frame's digits a chance to come in
+		if (!m_bQuit) {
+			Uint32 uElapsed = SDL_GetTicks() - m_uFirstQueuedMs;
+			if (uElapsed < m_uBatchMs) {
+				SDL_CondWaitTimeout(m_cond, m_mutex, m_uBatchMs - uElapsed);
+				continue;
+			}
+		}
+
+		unsigned int uLen = TakeBatch();
+		if (uLen == 0) continue;
+
+		// the emulation can keep queueing while the device is busy
+		SDL_UnlockMutex(m_mutex);
+		bool bWritten = m_pDevice->write(m_batch, uLen);
+		SDL_LockMutex(m_mutex);
+
+		if (bWritten) {
+			m_uWrites++;
+		} else {
+			// we don't know what the device shows anymore
+			for (unsigned int u = 0; u < SLOTS; u++) m_iShown[u] = -1;
+		}
+	}
+
+	SDL_UnlockMutex(m_mutex);
+}
+
+unsigned int USBWriter::GetWriteCount()
+{
+	if (m_mutex) SDL_LockMutex(m_mutex);
+	unsigned int uWrites = m_uWrites;
+	if (m_mutex) SDL_UnlockMutex(m_mutex);
+	return uWrites;
+}
+
+unsigned int USBWriter::GetDroppedCount()
+{
+	if (m_mutex) SDL_LockMutex(m_mutex);
+	unsigned int uDropped = m_uDropped;
+	if (m_mutex) SDL_UnlockMutex(m_mutex);
+	return uDropped;
+}
@@ -0,0 +1,94 @@
+/*
+ * ____ HYPSEUS COPYRIGHT NOTICE ____
+ *
+ * Copyright (C) 2026 Hypseus Singe contributors
+ *
+ * This file is part of HYPSEUS SINGE, a laserdisc arcade game emulator
+ *
+ * HYPSEUS SINGE is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * HYPSEUS SINGE is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef USB_WRITER_H
+#define USB_WRITER_H
+
+#include <SDL.h>
+#include "usb_util.h"
+
+// Sends digits to the USB scoreboard from a thread of its own, so that the
+//  emulation never waits on the serial port.
+// Queue() only records the latest value of each digit.  The thread waits for
+//  a frame's worth of changes to pile up, then sends every digit whose value
+//  differs from what the device already shows in a single write.
+class USBWriter
+{
+public:
+	// where the bytes go (the serial port, or a stand-in for testing)
+	class IDevice
+	{
+	public:
+		virtual ~IDevice() { }
+		virtual bool write(const void *pBuf, unsigned int uLen) = 0;
+	};
+
+	// how long changes are collected before being sent (about one frame)
+	static const unsigned int BATCH_MS = 16;
+
+	USBWriter();
+	~USBWriter();
+
+	// Starts the thread.  If it can't be started, Queue() writes straight to
+	//  the device instead.
+	void Start(IDevice *pDevice, unsigned int uBatchMs = BATCH_MS);
+
+	// sends whatever is still queued, then stops the thread
+	void Stop();
+
+	void Queue(const DigitStruct &ds);
+
+	unsigned int GetWriteCount();	// device writes made
+	unsigned int GetDroppedCount();	// digit changes that never needed sending
+
+private:
+	// one slot for each digit of each unit
+	static const unsigned int SLOTS = 256;
+
+	static int ThreadProc(void *pThis);
+	void Run();
+
+	// collects the queued digits into m_batch, returns how many bytes
+	//  (m_mutex must be held)
+	unsigned int TakeBatch();
+
+	IDevice *m_pDevice;
+	unsigned int m_uBatchMs;
+
+	SDL_Thread *m_thread;
+	SDL_mutex *m_mutex;	// guards everything below
+	SDL_cond *m_cond;	// signalled when the first digit is queued and on Stop()
+	bool m_bQuit;
+
+	int m_iQueued[SLOTS];	// latest value of each queued digit, -1 if none
+	int m_iShown[SLOTS];	// what the device shows, -1 if unknown
+	Uint8 m_uOrder[SLOTS];	// queued slots, in the order they were first queued
+	unsigned int m_uOrderCount;
+	Uint32 m_uFirstQueuedMs;	// when the oldest queued digit came in
+
+	DigitStruct m_batch[SLOTS];	// only used by whoever writes
+
+	unsigned int m_uWrites;
+	unsigned int m_uDropped;
+};
+
+#endif // USB_WRITER_H
@@ -27,6 +27,7 @@
 #include "config.h"
 
 #include "../io/conout.h"
+#include "../io/mpo_mem.h"
 #include "gisound.h"
 #include "sound.h"
 #include <memory.h>
@@ -34,6 +35,9 @@
 
 #define MAX_GISOUND_CHIPS 4
 
+// the envelope settles into a 32 step loop well within this many steps
+#define ENVELOPE_SKIP_LIMIT 96
+
 namespace gisound
 {
 
@@ -259,124 +263,203 @@ void writedata(Uint32 address, Uint32 data, int index)
     }
 }
 
+// how many samples until a counter (measured in bytes) runs out
+static inline int samples_to_edge(int bytes_to_go)
+{
+    // a counter that a period change has pushed below zero still fires on the
+    // very next sample
+    return (bytes_to_go <= 4) ? 1 : ((bytes_to_go + 3) >> 2);
+}
+
+// the output level; constant between edges
+static inline Sint16 mix_sample(const gi_sound_chip &chip)
+{
+    return (g_volumetable[chip.chan_a_amplitude] *
+                ((chip.tone_a ? chip.chan_a_flip : 1) + (chip.noise_a ? chip.noise_flip : 1)) / 2 +
+            g_volumetable[chip.chan_b_amplitude] *
+                ((chip.tone_b ? chip.chan_b_flip : 1) + (chip.noise_b ? chip.noise_flip : 1)) / 2 +
+            g_volumetable[chip.chan_c_amplitude] *
+                ((chip.tone_c ? chip.chan_c_flip : 1) + (chip.noise_c ? chip.noise_flip : 1)) / 2) /
+           3;
+}
+
+// clocks the noise generator's shift register
+static inline void noise_edge(gi_sound_chip &chip)
+{
+    // the random number generator is a 17 bit shift register with the
+    // output as bit 0, and the input is
+    // not (bit 0 xor bit 3)
+    chip.random_seed = (chip.random_seed >> 1) |
+                       ((~(chip.random_seed ^ (chip.random_seed >> 3)) & 0x01) << 16);
+
+    if (chip.random_seed & 0x01) {
+        chip.noise_flip = -chip.noise_flip;
+    }
+}
+
+// steps the envelope generator
+static inline void envelope_edge(gi_sound_chip &chip)
+{
+    if (!chip.envelope_shape_cycle_cont && chip.envelope_cycle_complete) {
+        chip.envelope_amplitude = 0; // always hold it low after a cycle if !cont
+    } else if (chip.envelope_shape_cycle_hold && chip.envelope_cycle_complete) {
+        // don't do anything (hold it) if hold and the cycle is complete
+        if (chip.envelope_shape_cycle_alt) {
+            chip.envelope_amplitude = chip.envelope_shape_cycle_att ? 0 : 15;
+        }
+    } else if (chip.envelope_shape_cycle_alt && chip.envelope_cycle_complete) {
+        chip.envelope_amplitude =
+            (!chip.envelope_shape_cycle_att ? chip.envelope_step : 15 - chip.envelope_step);
+    } else {
+        chip.envelope_amplitude =
+            (chip.envelope_shape_cycle_att ? chip.envelope_step : 15 - chip.envelope_step);
+    }
+    // update the volumes
+    if (chip.chan_a_amplitude_mode) {
+        chip.chan_a_amplitude = chip.envelope_amplitude;
+    }
+    if (chip.chan_b_amplitude_mode) {
+        chip.chan_b_amplitude = chip.envelope_amplitude;
+    }
+    if (chip.chan_c_amplitude_mode) {
+        chip.chan_c_amplitude = chip.envelope_amplitude;
+    }
+    chip.envelope_step++;
+
+    if (chip.envelope_step > 15) {
+        chip.envelope_step = 0;
+        if (chip.envelope_cycle_complete && chip.envelope_shape_cycle_alt &&
+            chip.envelope_shape_cycle_cont && !chip.envelope_shape_cycle_hold) {
+            chip.envelope_cycle_complete = false;
+        } else {
+            chip.envelope_cycle_complete = true;
+        }
+    }
+}
+
+// Advances a counter whose edges can't be heard by 'samples' samples and
+// returns how many times it ran out along the way.
+static inline int skip_counter(int &bytes_to_go, int bytes_per_switch, int samples)
+{
+    int edges = 0;
+
+    // a counter that a period change has pushed below zero runs out on every
+    // sample until it climbs back above zero
+    while ((bytes_to_go <= 0) && (samples > 0)) {
+        bytes_to_go += bytes_per_switch - sound::BYTES_PER_SAMPLE;
+        samples--;
+        edges++;
+    }
+
+    int bytes = samples * sound::BYTES_PER_SAMPLE;
+    if ((samples > 0) && (bytes >= bytes_to_go)) {
+        int n = (bytes - bytes_to_go) / bytes_per_switch + 1;
+        bytes_to_go += n * bytes_per_switch;
+        edges += n;
+    }
+    bytes_to_go -= bytes;
+
+    return edges;
+}
+
 void stream(Uint8 *stream, int length, int index)
 {
-    for (int pos = 0; pos < length; pos += 4) {
-        // endian-independent! :)
-        // NOTE : assumes stream is in little endian format
-        Sint16 sample =
-            (g_volumetable[g_gi_chips[index]->chan_a_amplitude] *
-                 ((g_gi_chips[index]->tone_a ? g_gi_chips[index]->chan_a_flip : 1) +
-                  (g_gi_chips[index]->noise_a ? g_gi_chips[index]->noise_flip : 1)) /
-                 2 +
-             g_volumetable[g_gi_chips[index]->chan_b_amplitude] *
-                 ((g_gi_chips[index]->tone_b ? g_gi_chips[index]->chan_b_flip : 1) +
-                  (g_gi_chips[index]->noise_b ? g_gi_chips[index]->noise_flip : 1)) /
-                 2 +
-             g_volumetable[g_gi_chips[index]->chan_c_amplitude] *
-                 ((g_gi_chips[index]->tone_c ? g_gi_chips[index]->chan_c_flip : 1) +
-                  (g_gi_chips[index]->noise_c ? g_gi_chips[index]->noise_flip : 1)) /
-                 2) /
-            3;
-
-        stream[pos] = stream[pos + 2] = (Uint16)(sample)&0xff;
-        stream[pos + 1] = stream[pos + 3] = ((Uint16)(sample) >> 8) & 0xff;
-
-        g_gi_chips[index]->chan_a_bytes_to_go -= 4;
-        g_gi_chips[index]->chan_b_bytes_to_go -= 4;
-        g_gi_chips[index]->chan_c_bytes_to_go -= 4;
-        g_gi_chips[index]->noise_bytes_to_go -= 4;
-        g_gi_chips[index]->envelope_bytes_to_go -= 4;
-
-        // update channel A if it needs it
-        if (g_gi_chips[index]->chan_a_bytes_to_go <= 0) {
-            g_gi_chips[index]->chan_a_bytes_to_go =
-                g_gi_chips[index]->chan_a_bytes_per_switch + g_gi_chips[index]->chan_a_bytes_to_go;
-            g_gi_chips[index]->chan_a_flip = -g_gi_chips[index]->chan_a_flip;
+    // Work on a local copy of the chip.  Stores through 'stream' may alias
+    // anything, so going through g_gi_chips[index] would force every field to
+    // be reloaded after every sample.
+    gi_sound_chip chip = *g_gi_chips[index];
+    int samples        = length / sound::BYTES_PER_SAMPLE;
+    int samples_left   = samples;
+
+    // Which counters can change the output.  A disabled or silent tone or
+    // noise source, or an envelope that no channel follows, still has to be
+    // clocked, but that can be done separately after rendering since nothing
+    // else depends on it.
+    const bool chan_a_loud    = chip.chan_a_amplitude_mode || chip.chan_a_amplitude;
+    const bool chan_b_loud    = chip.chan_b_amplitude_mode || chip.chan_b_amplitude;
+    const bool chan_c_loud    = chip.chan_c_amplitude_mode || chip.chan_c_amplitude;
+    const bool chan_a_heard   = chip.tone_a && chan_a_loud;
+    const bool chan_b_heard   = chip.tone_b && chan_b_loud;
+    const bool chan_c_heard   = chip.tone_c && chan_c_loud;
+    const bool noise_heard    = (chip.noise_a && chan_a_loud) || (chip.noise_b && chan_b_loud) ||
+                                (chip.noise_c && chan_c_loud);
+    const bool envelope_heard = chip.chan_a_amplitude_mode || chip.chan_b_amplitude_mode ||
+                                chip.chan_c_amplitude_mode;
+
+    // The output only changes when an audible counter runs out, so rather than
+    // stepping one sample at a time we jump from edge to edge and fill the run
+    // in between with a single repeated value.
+    while (samples_left > 0) {
+        int run = samples_left;
+        if (chan_a_heard) run = SDL_min(run, samples_to_edge(chip.chan_a_bytes_to_go));
+        if (chan_b_heard) run = SDL_min(run, samples_to_edge(chip.chan_b_bytes_to_go));
+        if (chan_c_heard) run = SDL_min(run, samples_to_edge(chip.chan_c_bytes_to_go));
+        if (noise_heard) run = SDL_min(run, samples_to_edge(chip.noise_bytes_to_go));
+        if (envelope_heard) run = SDL_min(run, samples_to_edge(chip.envelope_bytes_to_go));
+
+        // same sample on the left and right channel, little endian
+        Uint16 sample = (Uint16)mix_sample(chip);
+        Uint32 frame  = ((Uint32)sample << 16) | sample;
+        for (int i = 0; i < run; i++) {
+            STORE_LIL_UINT32(stream, frame);
+            stream += sound::BYTES_PER_SAMPLE;
         }
-        // update channel B if it needs it
-        if (g_gi_chips[index]->chan_b_bytes_to_go <= 0) {
-            g_gi_chips[index]->chan_b_bytes_to_go =
-                g_gi_chips[index]->chan_b_bytes_per_switch + g_gi_chips[index]->chan_b_bytes_to_go;
-            g_gi_chips[index]->chan_b_flip = -g_gi_chips[index]->chan_b_flip;
+        samples_left -= run;
+
+        // service the counters that have run out, in the same order the
+        // hardware would
+        int run_bytes = run * sound::BYTES_PER_SAMPLE;
+        if (chan_a_heard && ((chip.chan_a_bytes_to_go -= run_bytes) <= 0)) {
+            chip.chan_a_bytes_to_go += chip.chan_a_bytes_per_switch;
+            chip.chan_a_flip = -chip.chan_a_flip;
         }
-        // update channel C if it needs it
-        if (g_gi_chips[index]->chan_c_bytes_to_go <= 0) {
-            g_gi_chips[index]->chan_c_bytes_to_go =
-                g_gi_chips[index]->chan_c_bytes_per_switch + g_gi_chips[index]->chan_c_bytes_to_go;
-            g_gi_chips[index]->chan_c_flip = -g_gi_chips[index]->chan_c_flip;
+        if (chan_b_heard && ((chip.chan_b_bytes_to_go -= run_bytes) <= 0)) {
+            chip.chan_b_bytes_to_go += chip.chan_b_bytes_per_switch;
+            chip.chan_b_flip = -chip.chan_b_flip;
         }
-        // update noise if it needs it
-        if (g_gi_chips[index]->noise_bytes_to_go <= 0) {
-            g_gi_chips[index]->noise_bytes_to_go =
-                g_gi_chips[index]->noise_bytes_per_switch + g_gi_chips[index]->noise_bytes_to_go;
-            // the random number generator is a 17 bit shift register with the
-            // output as bit 0, and the input is
-            // not (bit 0 xor bit 3)
-            g_gi_chips[index]->random_seed =
-                (g_gi_chips[index]->random_seed >> 1) |
-                ((~(g_gi_chips[index]->random_seed ^ (g_gi_chips[index]->random_seed >> 3)) & 0x01)
-                 << 16);
-            //			sprintf(s,"Random number %d",
-            // g_gi_chips[index]->random_number);
-            //			printline(s);
-
-            if (g_gi_chips[index]->random_seed & 0x01) {
-                g_gi_chips[index]->noise_flip = -g_gi_chips[index]->noise_flip;
-            }
+        if (chan_c_heard && ((chip.chan_c_bytes_to_go -= run_bytes) <= 0)) {
+            chip.chan_c_bytes_to_go += chip.chan_c_bytes_per_switch;
+            chip.chan_c_flip = -chip.chan_c_flip;
         }
-        // update envelope if it needs it
-        if (g_gi_chips[index]->envelope_bytes_to_go <= 0) {
-            if (!g_gi_chips[index]->envelope_shape_cycle_cont &&
-                g_gi_chips[index]->envelope_cycle_complete) {
-                g_gi_chips[index]->envelope_amplitude =
-                    0; // always hold it low after a cycle if !cont
-            } else if (g_gi_chips[index]->envelope_shape_cycle_hold &&
-                       g_gi_chips[index]->envelope_cycle_complete) {
-                // don't do anything (hold it) if hold and the cycle is complete
-                if (g_gi_chips[index]->envelope_shape_cycle_alt) {
-                    g_gi_chips[index]->envelope_amplitude =
-                        g_gi_chips[index]->envelope_shape_cycle_att ? 0 : 15;
-                }
-            } else if (g_gi_chips[index]->envelope_shape_cycle_alt &&
-                       g_gi_chips[index]->envelope_cycle_complete) {
-                g_gi_chips[index]->envelope_amplitude =
-                    (!g_gi_chips[index]->envelope_shape_cycle_att
-                         ? g_gi_chips[index]->envelope_step
-                         : 15 - g_gi_chips[index]->envelope_step);
-            } else {
-                g_gi_chips[index]->envelope_amplitude =
-                    (g_gi_chips[index]->envelope_shape_cycle_att
-                         ? g_gi_chips[index]->envelope_step
-                         : 15 - g_gi_chips[index]->envelope_step);
-            }
-            // update the volumes
-            if (g_gi_chips[index]->chan_a_amplitude_mode) {
-                g_gi_chips[index]->chan_a_amplitude = g_gi_chips[index]->envelope_amplitude;
-            }
-            if (g_gi_chips[index]->chan_b_amplitude_mode) {
-                g_gi_chips[index]->chan_b_amplitude = g_gi_chips[index]->envelope_amplitude;
-            }
-            if (g_gi_chips[index]->chan_c_amplitude_mode) {
-                g_gi_chips[index]->chan_c_amplitude = g_gi_chips[index]->envelope_amplitude;
-            }
-            g_gi_chips[index]->envelope_bytes_to_go =
-                g_gi_chips[index]->envelope_period + g_gi_chips[index]->envelope_bytes_to_go;
-            g_gi_chips[index]->envelope_step++;
-
-            if (g_gi_chips[index]->envelope_step > 15) {
-                g_gi_chips[index]->envelope_step = 0;
-                if (g_gi_chips[index]->envelope_cycle_complete &&
-                    g_gi_chips[index]->envelope_shape_cycle_alt &&
-                    g_gi_chips[index]->envelope_shape_cycle_cont &&
-                    !g_gi_chips[index]->envelope_shape_cycle_hold) {
-                    g_gi_chips[index]->envelope_cycle_complete = false;
-                } else {
-                    g_gi_chips[index]->envelope_cycle_complete = true;
-                }
-            }
+        if (noise_heard && ((chip.noise_bytes_to_go -= run_bytes) <= 0)) {
+            chip.noise_bytes_to_go += chip.noise_bytes_per_switch;
+            noise_edge(chip);
         }
+        if (envelope_heard && ((chip.envelope_bytes_to_go -= run_bytes) <= 0)) {
+            chip.envelope_bytes_to_go += chip.envelope_period;
+            envelope_edge(chip);
+        }
+    }
+
+    // now catch up the counters that weren't heard
+    int edges;
+    if (!chan_a_heard) {
+        edges = skip_counter(chip.chan_a_bytes_to_go, chip.chan_a_bytes_per_switch, samples);
+        if (edges & 1) chip.chan_a_flip = -chip.chan_a_flip;
+    }
+    if (!chan_b_heard) {
+        edges = skip_counter(chip.chan_b_bytes_to_go, chip.chan_b_bytes_per_switch, samples);
+        if (edges & 1) chip.chan_b_flip = -chip.chan_b_flip;
+    }
+    if (!chan_c_heard) {
+        edges = skip_counter(chip.chan_c_bytes_to_go, chip.chan_c_bytes_per_switch, samples);
+        if (edges & 1) chip.chan_c_flip = -chip.chan_c_flip;
     }
+    if (!noise_heard) {
+        edges = skip_counter(chip.noise_bytes_to_go, chip.noise_bytes_per_switch, samples);
+        while (edges--) noise_edge(chip);
+    }
+    if (!envelope_heard) {
+        edges = skip_counter(chip.envelope_bytes_to_go, chip.envelope_period, samples);
+        // Once the first cycle is over the envelope repeats every 32 steps
+        // (two cycles), so only the tail of a long skip needs to be stepped.
+        if (edges > ENVELOPE_SKIP_LIMIT) {
+            edges = ENVELOPE_SKIP_LIMIT - 32 + ((edges - ENVELOPE_SKIP_LIMIT) % 32);
+        }
+        while (edges--) envelope_edge(chip);
+    }
+
+    *g_gi_chips[index] = chip;
 }
 
 void shutdown(int index)
@@ -13,7 +13,13 @@
 #include <assert.h>
 #endif
 
-#include <queue>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#endif
+
+#include <atomic>
 using namespace std;
 
 namespace samples
@@ -50,18 +56,103 @@ struct callback_s {
     unsigned int uSampleIdx;
 };
 
-// MUST BE PROTECTED BY MUTEX!
-queue<callback_s> g_qCallbacks;
-
 // this number can be any size, but there's no reason to make it huge
+// (it can't go beyond 32 without widening g_uActiveMask)
 const unsigned int MAX_DYNAMIC_SAMPLES = 32; // Raised from 8 by RDG2010
 
 struct data_s g_SampleStates[MAX_DYNAMIC_SAMPLES];
 
+// one bit per slot in g_SampleStates, set while the slot is active, so the
+// mixer only visits slots that are actually playing
+// MUST BE PROTECTED BY SDL_LockAudio!
+Uint32 g_uActiveMask = 0;
+
 // so that we don't need to scan through to find a free slot in the dynamic
 // samples array
 unsigned int g_uNextSampleIdx = 0;
 
+// Finished samples are handed from the audio thread to the main thread through
+// this ring (single producer, single consumer), so the audio thread never has
+// to allocate or wait.  Each slot can only finish once per play() so this is
+// far bigger than it will ever need to be.
+const unsigned int CALLBACK_RING_SIZE = 256; // must be a power of 2
+callback_s g_aCallbackRing[CALLBACK_RING_SIZE];
+atomic<unsigned int> g_uCallbackHead(0); // only written by the audio thread
+atomic<unsigned int> g_uCallbackTail(0); // only written by the main thread
+
+// how many callbacks had to be thrown away because the ring was full
+atomic<unsigned int> g_uCallbacksDropped(0);
+
+static void set_active(unsigned int uSlot, bool bActive)
+{
+    g_SampleStates[uSlot].bActive = bActive;
+    if (bActive) {
+        g_uActiveMask |= (1U << uSlot);
+    } else {
+        g_uActiveMask &= ~(1U << uSlot);
+    }
+}
+
+// NOTE : This runs on the audio thread!!!
+static void queue_callback(const callback_s &cb)
+{
+    unsigned int uHead = g_uCallbackHead.load(memory_order_relaxed);
+
+    if (uHead - g_uCallbackTail.load(memory_order_acquire) < CALLBACK_RING_SIZE) {
+        g_aCallbackRing[uHead & (CALLBACK_RING_SIZE - 1)] = cb;
+        g_uCallbackHead.store(uHead + 1, memory_order_release);
+    } else {
+        g_uCallbacksDropped.fetch_add(1, memory_order_relaxed);
+    }
+}
+
+// Adds 'uCount' interleaved 16-bit values from 'pSrc' into 'pDst', saturating
+// at the limits (just like DO_CLIP would).  Both are in the mixer's format.
+static void mix_saturate(Uint8 *pDst, const Uint8 *pSrc, unsigned int uCount)
+{
+    unsigned int u = 0;
+
+#if SDL_BYTEORDER == SDL_LIL_ENDIAN
+#ifdef __SSE2__
+    for (; u + 8 <= uCount; u += 8) {
+        __m128i dst = _mm_loadu_si128((const __m128i *)(pDst + (u << 1)));
+        __m128i src = _mm_loadu_si128((const __m128i *)(pSrc + (u << 1)));
+        _mm_storeu_si128((__m128i *)(pDst + (u << 1)), _mm_adds_epi16(dst, src));
+    }
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+    for (; u + 8 <= uCount; u += 8) {
+        int16x8_t dst = vld1q_s16((const int16_t *)(pDst + (u << 1)));
+        int16x8_t src = vld1q_s16((const int16_t *)(pSrc + (u << 1)));
+        vst1q_s16((int16_t *)(pDst + (u << 1)), vqaddq_s16(dst, src));
+    }
+#endif
+#endif
+
+    // whatever is left (or everything, if there is no SIMD)
+    for (; u < uCount; u++) {
+        int iMixed = LOAD_LIL_SINT16(pDst + (u << 1)) + LOAD_LIL_SINT16(pSrc + (u << 1));
+        DO_CLIP(iMixed);
+        pDst[u << 1]       = (Uint8)(iMixed & 0xFF);
+        pDst[(u << 1) + 1] = (Uint8)((iMixed >> 8) & 0xFF);
+    }
+}
+
+// Same as mix_saturate, but for a mono source that is duplicated onto both
+// channels.  Samples loaded through convert() never need this.
+static void mix_saturate_mono(Uint8 *pDst, const Uint8 *pSrc, unsigned int uFrames)
+{
+    for (unsigned int u = 0; u < uFrames; u++) {
+        int iSample = LOAD_LIL_SINT16(pSrc + (u << 1));
+        for (unsigned int uChannel = 0; uChannel < 2; uChannel++) {
+            int iMixed = LOAD_LIL_SINT16(pDst) + iSample;
+            DO_CLIP(iMixed);
+            pDst[0] = (Uint8)(iMixed & 0xFF);
+            pDst[1] = (Uint8)((iMixed >> 8) & 0xFF);
+            pDst += 2;
+        }
+    }
+}
+
 // init callback
 int init(unsigned int unused)
 {
@@ -79,11 +170,56 @@ int init(unsigned int unused)
         s->bEndEarly        = false;
         s->finishedCallback = NULL;
     }
+    g_uActiveMask = 0;
 
     return iResult;
 }
 
-void shutdown(int unused) {}
+void shutdown(int unused)
+{
+    unsigned int uDropped = g_uCallbacksDropped.load();
+    if (uDropped != 0) {
+        LOGW << fmt("%u sample completion callbacks were dropped", uDropped);
+    }
+}
+
+bool convert(const SDL_AudioSpec *pSpec, Uint8 **ppu8Buf, Uint32 *puLength)
+{
+    SDL_AudioCVT cvt;
+
+    int iRes = SDL_BuildAudioCVT(&cvt, pSpec->format, pSpec->channels, pSpec->freq,
+                                 sound::FORMAT, sound::CHANNELS, sound::FREQ);
+
+    // already in our format?
+    if (iRes == 0) {
+        return true;
+    }
+
+    if (iRes < 0) {
+        LOGW << fmt("Unable to convert sample: %s", SDL_GetError());
+        return false;
+    }
+
+    cvt.len = *puLength;
+    cvt.buf = (Uint8 *)SDL_malloc(cvt.len * cvt.len_mult);
+    if (!cvt.buf) {
+        LOGW << "Out of memory converting sample";
+        return false;
+    }
+    memcpy(cvt.buf, *ppu8Buf, *puLength);
+
+    if (SDL_ConvertAudio(&cvt) < 0) {
+        LOGW << fmt("Unable to convert sample: %s", SDL_GetError());
+        SDL_free(cvt.buf);
+        return false;
+    }
+
+    SDL_FreeWAV(*ppu8Buf);
+    *ppu8Buf  = cvt.buf;
+    *puLength = cvt.len_cvt;
+
+    return true;
+}
 
 // called from sound mixer to get audio stream
 // NOTE : This runs on the audio thread!!!
@@ -99,74 +235,52 @@ void get_stream(Uint8 *stream, int length, int unused)
     // clear buffer so that our addition will work
     memset(stream, 0, length);
 
-    unsigned int u = 0;
+    // go through every sample that is playing ...
+    for (Uint32 uMask = g_uActiveMask; uMask != 0; uMask &= uMask - 1) {
+        unsigned int u = 0;
+        while (!(uMask & (1U << u))) {
+            ++u;
+        }
 
-    // check to see if any sample is playing ...
-    for (u = 0; u < MAX_DYNAMIC_SAMPLES; ++u) {
         data_s *data = &g_SampleStates[u];
 
-        if (data->bActive) {
-            Uint8 *ptrStream = stream;
-
-            // do each sample
-            for (unsigned int uSample = 0; uSample < uTotalSamples; ++uSample) {
-
-                if (data->bEndEarly) data->uPos = data->uLength;
-
-                // if there is still some sample data to be mixed to this stream
-                if (data->uPos < data->uLength) {
-                    int iMixedSample1 = LOAD_LIL_SINT16((Sint16 *)ptrStream);
-                    int iMixedSample2 = LOAD_LIL_SINT16(((Sint16 *)ptrStream) + 1);
-
-                    Sint16 i16Sample1 = LOAD_LIL_SINT16(data->pu8Buf + data->uPos);
-                    iMixedSample1 += i16Sample1;
-                    data->uPos += 2;
-
-                    // if this is a stereo sample
-                    if (data->uChannels == 2) {
-                        iMixedSample2 += LOAD_LIL_SINT16(data->pu8Buf + data->uPos);
-                        data->uPos += 2;
-                    }
-                    // else this is a mono sample, so just duplicate the last
-                    // sample we read in
-                    else {
-                        iMixedSample2 += i16Sample1;
-                    }
-
-                    DO_CLIP(iMixedSample1); // prevent overflow
-                    DO_CLIP(iMixedSample2);
-
-                    // yes, sample2 should be the most significant, sample1
-                    // least significant.. releasetest tests this
-                    unsigned int val_to_store =
-                        (((Uint16)iMixedSample2) << 16) | (Uint16)iMixedSample1;
-                    STORE_LIL_UINT32(ptrStream, val_to_store);
-                    ptrStream += 4;
-                }
-                // else this sample is done, so get rid of the entry ...
-                else {
-                    data->bActive = false;
-
-                    // if caller has requested to be notified when this sample
-                    // is done ...
-                    if (data->finishedCallback != NULL) {
-                        callback_s cb;
-                        cb.finishedCallback = data->finishedCallback;
-                        cb.pu8Buf           = data->pu8Buf;
-                        cb.uSampleIdx       = u;
-
-                        // NOTE : I am _assuming_ the SDL_LockAudio has already
-                        // been called which is why I don't do it here.
-                        // The callback needs to be queued up so that the main
-                        // thread can issue it (the audio thread can't issue it
-                        // without causing instability)
-                        g_qCallbacks.push(cb);
-                    }
-                    break;
-                }
-            } // end going through stream buffer
-        }     // end while we have states to be addressed
-    }         // end looping through all sample slots
+        if (data->bEndEarly) data->uPos = data->uLength;
+
+        // how much of this sample will fit in the stream
+        unsigned int uBytesPerSample = (data->uChannels == 2) ? 4 : 2;
+        unsigned int uSamples        = (data->uLength - data->uPos) / uBytesPerSample;
+        if (uSamples > uTotalSamples) {
+            uSamples = uTotalSamples;
+        }
+
+        // yes, the right channel should be the most significant,
+        // left least significant.. releasetest tests this
+        if (data->uChannels == 2) {
+            mix_saturate(stream, data->pu8Buf + data->uPos, uSamples << 1);
+        } else {
+            mix_saturate_mono(stream, data->pu8Buf + data->uPos, uSamples);
+        }
+        data->uPos += uSamples * uBytesPerSample;
+
+        // if this sample is done, get rid of the entry ...
+        if (data->uLength - data->uPos < uBytesPerSample) {
+            set_active(u, false);
+
+            // if caller has requested to be notified when this sample
+            // is done ...
+            if (data->finishedCallback != NULL) {
+                callback_s cb;
+                cb.finishedCallback = data->finishedCallback;
+                cb.pu8Buf           = data->pu8Buf;
+                cb.uSampleIdx       = u;
+
+                // The callback needs to be queued up so that the main
+                // thread can issue it (the audio thread can't issue it
+                // without causing instability)
+                queue_callback(cb);
+            }
+        }
+    } // end looping through all active sample slots
 }
 
 int play(Uint8 *pu8Buf, unsigned int uLength,
@@ -225,7 +339,7 @@ int play(Uint8 *pu8Buf, unsigned int uLength,
 
         // if we found a state that we can modify
         if (state != NULL) {
-            state->bActive          = true;
+            set_active(iResult, true);
             state->pu8Buf           = pu8Buf;
             state->uLength          = uLength;
             state->uChannels        = uChannels;
@@ -263,7 +377,7 @@ bool set_state(unsigned int uSlot, bool thisState)
     if (uSlot < MAX_DYNAMIC_SAMPLES) {
         // about to access shared variables
         SDL_LockAudio();
-        g_SampleStates[uSlot].bActive = thisState;
+        set_active(uSlot, thisState);
         SDL_UnlockAudio();
         bResult = true;
     } else {
@@ -302,20 +416,20 @@ void flush_queue()
 
 void do_queued_callbacks()
 {
-    // about to access shared variables
-    SDL_LockAudio();
+    // nothing here is shared with the audio thread except the ring itself, so
+    // no audio lock is needed
+    unsigned int uTail = g_uCallbackTail.load(memory_order_relaxed);
 
     // do all the callbacks that are queued up
-    while (!g_qCallbacks.empty()) {
-        callback_s cb = g_qCallbacks.front();
+    while (uTail != g_uCallbackHead.load(memory_order_acquire)) {
+        callback_s cb = g_aCallbackRing[uTail & (CALLBACK_RING_SIZE - 1)];
+
+        // remove this item from the ring before calling it, in case the
+        // callback plays another sample
+        g_uCallbackTail.store(++uTail, memory_order_release);
 
         // call the callback here
         cb.finishedCallback(cb.pu8Buf, cb.uSampleIdx);
-
-        // remove this item from the queue
-        g_qCallbacks.pop();
     }
-
-    SDL_UnlockAudio();
 }
 }
@@ -37,8 +37,17 @@ void shutdown(int shutdown);
 // called from sound mixer to get audio stream
 void get_stream(Uint8 *stream, int length, int internal_id);
 
+// Converts a sample loaded by SDL_LoadWAV (described by 'pSpec') into the
+// mixer's own format (44.1 kHz, interleaved 16-bit stereo), resampling if
+// needed, so that it can be mixed without any per-sample conversion.
+// On success, *ppu8Buf and *puLength are replaced and true is returned.  The
+// buffer is still owned by the caller and must still be freed with
+// SDL_FreeWAV.
+bool convert(const SDL_AudioSpec *pSpec, Uint8 **ppu8Buf, Uint32 *puLength);
+
 // Plays a sample
-// The sample's audio specs must match our the audio device's specs
+// The sample's audio specs must match our the audio device's specs (see
+// convert).  Mono samples are accepted but are slower to mix.
 // 'uLength' is how long the sample is IN BYTES (so 4-bytes = 1 sample for
 // 16-bit stereo)
 // 'uChannels' is how many channels the sample has (must be 1 for mono or 2 for
@@ -58,6 +67,7 @@ bool is_playing(unsigned int uSlot);
 
 // This is a hack (for now) to ensure that any callbacks that were queued get
 // fired by the main thread (instead of the audio thread).
+// It must only ever be called from the main thread.
 // For now it must be manually called as often as you want your callbacks to be
 // called.
 // (in the future this will be automated)
@@ -42,6 +42,8 @@
 #include "../io/mpo_mem.h"
 #include "../io/numstr.h"
 #include "../ldp-out/ldp-vldp.h" // added by JFA for -startsilent
+#include "../timer/perfstats.h"
+#include "../timer/tracer.h"
 #include "dac.h"
 #include "gisound.h"
 #include "mix.h"
@@ -80,6 +82,10 @@ Uint16 g_u16SoundBufSamples = 2048;
 // # of bytes each individual sound chip should be allocated for its buffer
 unsigned int g_uSoundChipBufSize = g_u16SoundBufSamples * BYTES_PER_SAMPLE;
 
+// whether update_buffer() has run since the last callback (both are under the
+// audio lock)
+bool g_bUpdatedSinceCallback = false;
+
 // the volume (user adjustable) of the VLDP audio stream
 unsigned int g_uVolumeVLDP = MAX_VOLUME;
 
@@ -312,12 +318,11 @@ int load_waves()
         // if loading the .wav file succeeds
         if (SDL_LoadWAV(filename.c_str(), &spec, &g_samples[i].pu8Buf,
                         &g_samples[i].uLength)) {
-            // make sure audio specs are correct
-            if (((spec.channels == CHANNELS) || (spec.channels == 1)) &&
-                (spec.freq == FREQ) && (spec.format == AUDIO_S16)) {
-                g_samples[i].uChannels = spec.channels;
+            // convert it up front so the mixer never has to
+            if (samples::convert(&spec, &g_samples[i].pu8Buf, &g_samples[i].uLength)) {
+                g_samples[i].uChannels = CHANNELS;
             }
-            // else specs are not correct
+            // else it can't be played
             else {
                 LOGW << fmt("ERROR: Audio specs are not correct for %s",
                             filename.c_str());
@@ -335,7 +340,8 @@ int load_waves()
 
     // load "saveme" sound in
     if (!SDL_LoadWAV("sound/saveme.wav", &spec, &g_sample_saveme.pu8Buf,
-                     &g_sample_saveme.uLength)) {
+                     &g_sample_saveme.uLength) ||
+        !samples::convert(&spec, &g_sample_saveme.pu8Buf, &g_sample_saveme.uLength)) {
         LOGW << "Loading 'saveme.wav' failed...";
         result = 0;
     }
@@ -663,8 +669,13 @@ void mixWithMults(Uint8 *stream, int length)
 
 void callback(void *data, Uint8 *stream, int length)
 {
+    TRACE_THREAD_NAME("audio");
+    TRACE_SCOPE("sound callback");
+
     // now go through the sound chips and mix them in
     struct chip *cur = g_chip_head;
+    Uint64 u64StartNs = perfstats::get_ns();
+    unsigned int uUnderruns = 0;
 
     // fill remaining buffer space for each sound chip
     while (cur) {
@@ -672,14 +683,28 @@ void callback(void *data, Uint8 *stream, int length)
         assert(cur->stream_callback != NULL); // every sound chip will have to
                                               // supply this
 #endif
+        // if the emulation is running but hasn't filled even half of the
+        // buffer since the last callback, it has fallen behind the sound card
+        // (while paused nothing gets filled, that doesn't count)
+        if (g_bUpdatedSinceCallback && cur->bNeedsConstantUpdates &&
+            (cur->bytes_left > (g_uSoundChipBufSize >> 1))) {
+            uUnderruns++;
+        }
         cur->stream_callback(cur->buffer_pointer, cur->bytes_left, cur->internal_id);
         cur->buffer_pointer = cur->buffer;
         cur->bytes_left     = g_uSoundChipBufSize;
         cur                 = cur->next;
     }
 
+    g_bUpdatedSinceCallback = false;
+
     // do the actual mixing now
     g_soundmix_callback(stream, length);
+
+    if (uUnderruns) {
+        perfstats::add_value(perfstats::VALUE_AUDIO_UNDERRUNS, uUnderruns);
+    }
+    perfstats::add_timing(perfstats::TIMING_MIXER, perfstats::get_ns() - u64StartNs);
 }
 
 void writedata(Uint8 id, Uint8 data)
@@ -864,6 +889,7 @@ void update_buffer()
         // to ensure that the audio callback doesn't get called while we're in
         // this function
         LOCK_AUDIO();
+        g_bUpdatedSinceCallback = true;
         struct chip *cur = g_chip_head;
         while (cur) {
             // only update if needed, to save CPU cycles
@@ -31,6 +31,7 @@
 #include <memory.h>
 //#include "common.hpp"
 #include "SDL.h"
+#include "../io/mpo_mem.h"
 #include "sound.h" // to get max volume
 #include "tms9919-sdl.hpp"
 #include "tms9919.hpp"
@@ -49,6 +50,9 @@
 #define NOISE_WHITE_GENERATOR 0x12000
 #define NOISE_PERIODIC_GENERATOR 0x08000
 
+// how many samples AudioCallback renders at a time
+#define MIX_BLOCK_SAMPLES 256
+
 cSdlTMS9919::cSdlTMS9919()
     :
 
@@ -131,65 +135,94 @@ void cSdlTMS9919::AudioCallback(Uint8 *stream, int length)
 
     //	int volume = ( m_MasterVolume * AUDIO_MAX_VOLUME ) / 100;
 
-    // bool mix = false;
-    memset(stream, m_AudioSpec.silence, length);
+    // Only the high byte of each (duplicated) 16-bit sample is ever touched by
+    // the voices, so they are summed into this small byte buffer one block at a
+    // time and then expanded into the stream with a single pass.
+    Uint8 mix[MIX_BLOCK_SAMPLES];
 
-    for (int i = 0; i < 4; i++) {
-        // set info to this voice's information
-        sVoiceInfo *info = &m_Info[i];
+    int samples = length / 4;
+    bool active[4];
 
+    for (int i = 0; i < 4; i++) {
         // make sure that attenuation (volume) isn't 15 = off and we have a
         // frequency
-        if ((m_Attenuation[i] != 15) && (info->period >= 1.0)) {
-            // new data so we'll need to mix
-            // mix = true;
+        active[i] = (m_Attenuation[i] != 15) && (m_Info[i].period >= 1.0);
+    }
+
+    for (int done = 0; done < samples; done += MIX_BLOCK_SAMPLES) {
+        int block = SDL_min(samples - done, MIX_BLOCK_SAMPLES);
+
+        memset(mix, m_AudioSpec.silence, block);
+
+        for (int i = 0; i < 4; i++) {
+            if (!active[i]) continue;
 
-            // set left = length (number of samples we need to process)
-            int left = length / 4, j = 1;
+            // keep this voice's state in locals while we render
+            sVoiceInfo *info   = &m_Info[i];
+            const float period = info->period;
+            float toggle       = info->toggle;
+            int setting        = info->setting;
+            int shift          = m_ShiftRegister;
 
-            // now calculate all the samples for the buffer
+            // set left = number of samples we need to process
+            int left = block, j = 0;
+
+            // now calculate all the samples for the block
             do {
                 // how many samples do we copy before we toggle
-                int count = (info->toggle < left) ? (int)info->toggle : left;
+                int count = (toggle < left) ? (int)toggle : left;
 
                 // we are going to do (count) samples so minus them from how
                 // many left to do
                 left -= count;
 
                 // also minus that amount from toggle
-                info->toggle -= count;
-
-                // now copy the frequency to the stream
-                while (count--) {
-                    // copy to both channels
-                    stream[j] += info->setting;
-                    stream[j + 2] = stream[j];
-                    j += 4;
+                toggle -= count;
+
+                // now add the level to the whole run
+                Uint8 level = (Uint8)setting;
+                for (int k = 0; k < count; k++) {
+                    mix[j + k] += level;
                 }
+                j += count;
 
-                if (info->toggle < 1.0) {
-                    info->toggle += info->period;
+                if (toggle < 1.0) {
+                    toggle += period;
 
                     if (i < 3) {
                         // Tone
-                        info->setting = -info->setting;
+                        setting = -setting;
                     } else {
                         // Noise
-                        if (m_ShiftRegister & 1) {
-                            m_ShiftRegister ^= m_NoiseGenerator;
+                        if (shift & 1) {
+                            shift ^= m_NoiseGenerator;
                             // Protect against 0
-                            if (m_ShiftRegister == 0) {
-                                m_ShiftRegister = NOISE_RESET;
+                            if (shift == 0) {
+                                shift = NOISE_RESET;
                             }
-                            info->setting = -info->setting;
+                            setting = -setting;
                         }
-                        m_ShiftRegister >>= 1;
+                        shift >>= 1;
                     }
                 }
             } while (left > 0);
+
+            info->toggle    = toggle;
+            info->setting   = setting;
+            m_ShiftRegister = shift;
+        }
+
+        // copy to both channels (the low bytes are silence)
+        for (int k = 0; k < block; k++) {
+            Uint32 level = m_AudioSpec.silence | (mix[k] << 8);
+            STORE_LIL_UINT32(stream, level | (level << 16));
+            stream += 4;
         }
     }
 
+    // any partial sample at the end is silence
+    memset(stream, m_AudioSpec.silence, length - (samples * 4));
+
     //    if ( m_pSpeechSynthesizer != NULL ) {
     //        mix |= m_pSpeechSynthesizer->AudioCallback ( m_MixBuffer, length
     //        );
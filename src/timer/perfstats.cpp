@@ -0,0 +1,487 @@
+/*
+ * ____ HYPSEUS COPYRIGHT NOTICE ____
+ *
+ * Copyright (C) 2026 Hypseus Singe contributors
+ *
+ * This file is part of HYPSEUS SINGE, a laserdisc arcade game emulator
+ *
+ * HYPSEUS SINGE is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * HYPSEUS SINGE is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "config.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <string>
+#include <plog/Log.h>
+#include "perfstats.h"
+
+#if defined(UNIX) || defined(MAC_OSX)
+#include <sys/resource.h>
+#endif
+
+#ifdef LINUX
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace perfstats
+{
+
+bool g_bEnabled = false;
+// how many emulated ms the benchmark is to run for, and have elapsed so far
+unsigned int g_uRunMs      = 0;
+unsigned int g_uEmulatedMs = 0;
+std::string g_strReportPath = "benchmark.json";
+
+Uint64 g_u64BeginNs = 0;
+Uint64 g_u64EndNs = 0;
+
+// the mixer is timed on the audio thread, so each timing gets its own lock
+timing_s g_timings[TIMING_COUNT];
+SDL_SpinLock g_timingLocks[TIMING_COUNT];
+
+const char *g_timingNames[TIMING_COUNT] = {"mixer", "blit", "pacing",
+                                           "search", "input"};
+
+// the values are updated from the cpu, audio and video threads
+Uint64 g_values[VALUE_COUNT];
+SDL_SpinLock g_valueLock = 0;
+
+// -stats_file
+std::string g_strMetricsPath;
+unsigned int g_uMetricsSecs = 0;
+SDL_Thread *g_metricsThread = NULL;
+SDL_mutex *g_metricsMutex = NULL;
+SDL_cond *g_metricsCond = NULL;
+bool g_bMetricsQuit = false;
+
+// the cache miss counter (-1 if there isn't one)
+int g_iCacheMissFd = -1;
+Uint64 g_u64CacheMisses = 0;
+bool g_bCacheMissesValid = false;
+
+void enable(unsigned int uMs)
+{
+    g_bEnabled = true;
+    g_uRunMs = uMs;
+}
+
+bool is_enabled()
+{
+    return g_bEnabled;
+}
+
+void set_report_path(const char *pszReportPath)
+{
+    g_strReportPath = pszReportPath;
+}
+
+const char *get_report_path()
+{
+    return g_strReportPath.c_str();
+}
+
+static void start_metrics_file();
+static void stop_metrics_file();
+static void start_cache_misses();
+static void stop_cache_misses();
+
+void begin()
+{
+    g_uEmulatedMs = 0;
+    for (unsigned int u = 0; u < TIMING_COUNT; u++) {
+        SDL_AtomicLock(&g_timingLocks[u]);
+        memset(&g_timings[u], 0, sizeof(g_timings[u]));
+        SDL_AtomicUnlock(&g_timingLocks[u]);
+    }
+    g_u64BeginNs = g_u64EndNs = get_ns();
+    start_metrics_file();
+    start_cache_misses();
+}
+
+void end()
+{
+    g_u64EndNs = get_ns();
+    stop_cache_misses();
+    stop_metrics_file();
+}
+
+bool tick_ms()
+{
+    ++g_uEmulatedMs;
+    return (g_uEmulatedMs >= g_uRunMs);
+}
+
+unsigned int get_emulated_ms()
+{
+    return g_uEmulatedMs;
+}
+
+Uint64 get_wall_ns()
+{
+    return g_u64EndNs - g_u64BeginNs;
+}
+
+Uint64 get_ns()
+{
+    static const Uint64 u64Freq = SDL_GetPerformanceFrequency();
+    Uint64 u64Count = SDL_GetPerformanceCounter();
+
+    // split up to avoid overflowing 64 bits with a fast counter
+    return ((u64Count / u64Freq) * 1000000000) +
+           (((u64Count % u64Freq) * 1000000000) / u64Freq);
+}
+
+void add_timing(unsigned int uWhich, Uint64 u64Ns)
+{
+    timing_s *pTiming = &g_timings[uWhich];
+
+    // how many bits the sample needs in microseconds
+    unsigned int uBucket = 0;
+    for (Uint64 u64Us = u64Ns / 1000; u64Us != 0; u64Us >>= 1) {
+        uBucket++;
+    }
+    if (uBucket >= TIMING_BUCKETS) uBucket = TIMING_BUCKETS - 1;
+
+    SDL_AtomicLock(&g_timingLocks[uWhich]);
+    ++pTiming->u64Count;
+    pTiming->u64TotalNs += u64Ns;
+    if (u64Ns > pTiming->u64MaxNs) {
+        pTiming->u64MaxNs = u64Ns;
+    }
+    ++pTiming->u64Buckets[uBucket];
+    SDL_AtomicUnlock(&g_timingLocks[uWhich]);
+}
+
+void get_timing(unsigned int uWhich, timing_s *pTiming)
+{
+    SDL_AtomicLock(&g_timingLocks[uWhich]);
+    *pTiming = g_timings[uWhich];
+    SDL_AtomicUnlock(&g_timingLocks[uWhich]);
+}
+
+const char *get_timing_name(unsigned int uWhich)
+{
+    return g_timingNames[uWhich];
+}
+
+void set_value(unsigned int uWhich, Uint64 u64Value)
+{
+    SDL_AtomicLock(&g_valueLock);
+    g_values[uWhich] = u64Value;
+    SDL_AtomicUnlock(&g_valueLock);
+}
+
+void add_value(unsigned int uWhich, Uint64 u64Amount)
+{
+    SDL_AtomicLock(&g_valueLock);
+    g_values[uWhich] += u64Amount;
+    SDL_AtomicUnlock(&g_valueLock);
+}
+
+void raise_value(unsigned int uWhich, Uint64 u64Value)
+{
+    SDL_AtomicLock(&g_valueLock);
+    if (u64Value > g_values[uWhich]) g_values[uWhich] = u64Value;
+    SDL_AtomicUnlock(&g_valueLock);
+}
+
+Uint64 get_value(unsigned int uWhich)
+{
+    SDL_AtomicLock(&g_valueLock);
+    Uint64 u64Result = g_values[uWhich];
+    SDL_AtomicUnlock(&g_valueLock);
+    return u64Result;
+}
+
+void format_osd(char *pszBuf, size_t uSize)
+{
+    // averages are taken since the previous call so that they follow what is
+    //  happening now rather than since the game started
+    static timing_s prev[TIMING_COUNT];
+    static Uint64 u64PrevNs = 0, u64PrevUpload = 0;
+
+    size_t uLen = 0;
+    pszBuf[0] = 0;
+
+    for (unsigned int u = 0; (u < TIMING_COUNT) && (uLen < uSize); u++) {
+        timing_s timing;
+        get_timing(u, &timing);
+
+        Uint64 u64Count = timing.u64Count - prev[u].u64Count;
+        double dAvgMs = 0.0;
+        if (u64Count != 0) {
+            dAvgMs = (timing.u64TotalNs - prev[u].u64TotalNs) /
+                     (u64Count * 1000000.0);
+        }
+        prev[u] = timing;
+
+        uLen += snprintf(pszBuf + uLen, uSize - uLen,
+                         "%-7s %7.3f ms avg %8.3f ms max\n", g_timingNames[u],
+                         dAvgMs, timing.u64MaxNs / 1000000.0);
+    }
+
+    Uint64 u64Now = get_ns();
+    Uint64 u64Upload = get_value(VALUE_OVERLAY_UPLOAD_BYTES) +
+                       get_value(VALUE_VIDEO_UPLOAD_BYTES);
+    double dUploadKBs = 0.0;
+    if (u64PrevNs && (u64Now > u64PrevNs)) {
+        dUploadKBs = (u64Upload - u64PrevUpload) / 1.024 /
+                     ((u64Now - u64PrevNs) / 1000000.0);
+    }
+    u64PrevNs = u64Now;
+    u64PrevUpload = u64Upload;
+
+    if (uLen < uSize) {
+        snprintf(pszBuf + uLen, uSize - uLen,
+                 "cpu behind %llu ms (max %llu)\n"
+                 "frames %llu decoded, %llu dropped\n"
+                 "audio underruns %llu, disc audio behind %llu\n"
+                 "texture upload %.0f KB/s",
+                 (unsigned long long)get_value(VALUE_CPU_MS_BEHIND),
+                 (unsigned long long)get_value(VALUE_CPU_MS_BEHIND_MAX),
+                 (unsigned long long)get_value(VALUE_FRAMES_DECODED),
+                 (unsigned long long)get_value(VALUE_FRAMES_DROPPED),
+                 (unsigned long long)get_value(VALUE_AUDIO_UNDERRUNS),
+                 (unsigned long long)get_value(VALUE_DISC_AUDIO_BEHIND),
+                 dUploadKBs);
+    }
+}
+
+static void write_value(FILE *F, const char *pszName, const char *pszType,
+                        const char *pszHelp, unsigned int uWhich)
+{
+    fprintf(F, "# HELP %s %s\n", pszName, pszHelp);
+    fprintf(F, "# TYPE %s %s\n", pszName, pszType);
+    fprintf(F, "%s %llu\n", pszName, (unsigned long long)get_value(uWhich));
+}
+
+bool write_metrics(const char *pszPath)
+{
+    static const char *timing_help[TIMING_COUNT] = {
+        "Time spent in the sound mixer callback",
+        "Time spent drawing and presenting a frame",
+        "Time spent sleeping to keep emulation at real time",
+        "Laserdisc search latency",
+        "Time from the host receiving an input event to the game seeing it",
+    };
+
+    // write next to the real file and rename it over, so that a collector
+    //  never sees a half written file
+    std::string strTmp = std::string(pszPath) + ".tmp";
+    FILE *F = fopen(strTmp.c_str(), "w");
+    if (!F) return false;
+
+    for (unsigned int u = 0; u < TIMING_COUNT; u++) {
+        timing_s timing;
+        get_timing(u, &timing);
+
+        std::string strName =
+            std::string("hypseus_") + g_timingNames[u] + "_seconds";
+        const char *pszName = strName.c_str();
+
+        fprintf(F, "# HELP %s %s\n", pszName, timing_help[u]);
+        fprintf(F, "# TYPE %s histogram\n", pszName);
+
+        Uint64 u64Cumulative = 0;
+        for (unsigned int b = 0; b < TIMING_BUCKETS - 1; b++) {
+            u64Cumulative += timing.u64Buckets[b];
+            fprintf(F, "%s_bucket{le=\"%g\"} %llu\n", pszName,
+                    (double)(1 << b) * 0.000001,
+                    (unsigned long long)u64Cumulative);
+        }
+        fprintf(F, "%s_bucket{le=\"+Inf\"} %llu\n", pszName,
+                (unsigned long long)timing.u64Count);
+        fprintf(F, "%s_sum %.9f\n", pszName, timing.u64TotalNs * 0.000000001);
+        fprintf(F, "%s_count %llu\n", pszName,
+                (unsigned long long)timing.u64Count);
+    }
+
+    write_value(F, "hypseus_cpu_ms_behind", "gauge",
+                "How far the cpu emulation is behind real time",
+                VALUE_CPU_MS_BEHIND);
+    write_value(F, "hypseus_cpu_ms_behind_max", "gauge",
+                "Furthest the cpu emulation has been behind real time",
+                VALUE_CPU_MS_BEHIND_MAX);
+    write_value(F, "hypseus_ldp_frames_decoded_total", "counter",
+                "Laserdisc video frames decoded", VALUE_FRAMES_DECODED);
+    write_value(F, "hypseus_ldp_frames_dropped_total", "counter",
+                "Laserdisc video frames dropped", VALUE_FRAMES_DROPPED);
+    write_value(F, "hypseus_audio_underruns_total", "counter",
+                "Mixer callbacks that found a sound chip behind",
+                VALUE_AUDIO_UNDERRUNS);
+    write_value(F, "hypseus_disc_audio_behind_total", "counter",
+                "Disc audio buffers skipped to catch up",
+                VALUE_DISC_AUDIO_BEHIND);
+    write_value(F, "hypseus_overlay_upload_bytes_total", "counter",
+                "Bytes uploaded to the overlay, LED and aux textures",
+                VALUE_OVERLAY_UPLOAD_BYTES);
+    write_value(F, "hypseus_video_upload_bytes_total", "counter",
+                "Bytes uploaded to the laserdisc video texture",
+                VALUE_VIDEO_UPLOAD_BYTES);
+
+    fprintf(F, "# HELP hypseus_peak_rss_bytes Peak resident set size\n");
+    fprintf(F, "# TYPE hypseus_peak_rss_bytes gauge\n");
+    fprintf(F, "hypseus_peak_rss_bytes %llu\n",
+            (unsigned long long)get_peak_rss_kb() * 1024);
+
+    bool bResult = (fclose(F) == 0);
+
+#ifdef WIN32
+    remove(pszPath); // rename() won't replace an existing file here
+#endif
+    if (bResult) bResult = (rename(strTmp.c_str(), pszPath) == 0);
+
+    return bResult;
+}
+
+static int metrics_thread(void *)
+{
+    SDL_LockMutex(g_metricsMutex);
+    while (!g_bMetricsQuit) {
+        SDL_CondWaitTimeout(g_metricsCond, g_metricsMutex,
+                            g_uMetricsSecs * 1000);
+        if (g_bMetricsQuit) break;
+
+        SDL_UnlockMutex(g_metricsMutex);
+        if (!write_metrics(g_strMetricsPath.c_str())) {
+            LOGW << "Could not write " << g_strMetricsPath;
+        }
+        SDL_LockMutex(g_metricsMutex);
+    }
+    SDL_UnlockMutex(g_metricsMutex);
+
+    return 0;
+}
+
+void set_metrics_file(const char *pszPath, unsigned int uSecs)
+{
+    g_strMetricsPath = pszPath;
+    g_uMetricsSecs = uSecs ? uSecs : 1;
+}
+
+static void start_metrics_file()
+{
+    if (g_metricsThread || g_strMetricsPath.empty()) return;
+
+    g_bMetricsQuit = false;
+
+    g_metricsMutex = SDL_CreateMutex();
+    g_metricsCond = SDL_CreateCond();
+    if (g_metricsMutex && g_metricsCond) {
+        g_metricsThread = SDL_CreateThread(metrics_thread, "metrics", NULL);
+    }
+
+    if (!g_metricsThread) {
+        LOGW << "Could not start the thread writing " << g_strMetricsPath;
+    }
+}
+
+static void stop_metrics_file()
+{
+    if (g_metricsThread) {
+        SDL_LockMutex(g_metricsMutex);
+        g_bMetricsQuit = true;
+        SDL_CondSignal(g_metricsCond);
+        SDL_UnlockMutex(g_metricsMutex);
+        SDL_WaitThread(g_metricsThread, NULL);
+        g_metricsThread = NULL;
+
+        // one last time, so the file has the final totals
+        write_metrics(g_strMetricsPath.c_str());
+    }
+
+    if (g_metricsCond) {
+        SDL_DestroyCond(g_metricsCond);
+        g_metricsCond = NULL;
+    }
+
+    if (g_metricsMutex) {
+        SDL_DestroyMutex(g_metricsMutex);
+        g_metricsMutex = NULL;
+    }
+}
+
+static void start_cache_misses()
+{
+    g_bCacheMissesValid = false;
+    g_u64CacheMisses = 0;
+
+#ifdef LINUX
+    if (g_iCacheMissFd != -1) return;
+
+    struct perf_event_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = PERF_TYPE_HARDWARE;
+    attr.config = PERF_COUNT_HW_CACHE_MISSES;
+    attr.disabled = 1;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+
+    // this thread on any cpu
+    g_iCacheMissFd = (int)syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0);
+    if (g_iCacheMissFd == -1) {
+        LOGI << "Cache misses can't be counted (no perf counter access)";
+        return;
+    }
+
+    ioctl(g_iCacheMissFd, PERF_EVENT_IOC_RESET, 0);
+    ioctl(g_iCacheMissFd, PERF_EVENT_IOC_ENABLE, 0);
+#endif
+}
+
+static void stop_cache_misses()
+{
+#ifdef LINUX
+    if (g_iCacheMissFd == -1) return;
+
+    ioctl(g_iCacheMissFd, PERF_EVENT_IOC_DISABLE, 0);
+    Uint64 u64Count = 0;
+    g_bCacheMissesValid = (read(g_iCacheMissFd, &u64Count, sizeof(u64Count)) ==
+                           sizeof(u64Count));
+    g_u64CacheMisses = u64Count;
+    close(g_iCacheMissFd);
+    g_iCacheMissFd = -1;
+#endif
+}
+
+bool get_cache_misses(Uint64 &u64Misses)
+{
+    u64Misses = g_u64CacheMisses;
+    return g_bCacheMissesValid;
+}
+
+Uint64 get_peak_rss_kb()
+{
+    Uint64 u64Result = 0;
+
+#if defined(UNIX) || defined(MAC_OSX)
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) == 0) {
+        u64Result = usage.ru_maxrss;
+#ifdef MAC_OSX
+        u64Result >>= 10; // OSX reports this in bytes
+#endif
+    }
+#endif
+
+    return u64Result;
+}
+
+}
@@ -0,0 +1,132 @@
+/*
+ * ____ HYPSEUS COPYRIGHT NOTICE ____
+ *
+ * Copyright (C) 2026 Hypseus Singe contributors
+ *
+ * This file is part of HYPSEUS SINGE, a laserdisc arcade game emulator
+ *
+ * HYPSEUS SINGE is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * HYPSEUS SINGE is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef PERFSTATS_H
+#define PERFSTATS_H
+
+// Counters and timers for the -benchmark mode, the stats OSD and -stats_file.
+// Everything in here is cheap enough to leave compiled in and sampled all the
+//  time.
+
+#include <SDL.h>
+
+namespace perfstats
+{
+
+// what is being timed
+enum {
+    TIMING_MIXER,  // sound mixer callback
+    TIMING_BLIT,   // vid_blit()
+    TIMING_PACING, // sleeping to keep emulation at real time
+    TIMING_SEARCH, // laserdisc search, from request until the player is done
+    TIMING_INPUT,  // input latency, from the host getting an event to the game
+    TIMING_COUNT
+};
+
+// Bucket i counts the samples shorter than 2^i microseconds (that didn't fit an
+//  earlier bucket), the last one everything longer.
+static const unsigned int TIMING_BUCKETS = 24;
+
+struct timing_s {
+    Uint64 u64Count;   // how many samples were taken
+    Uint64 u64TotalNs; // sum of all samples
+    Uint64 u64MaxNs;   // longest sample
+    Uint64 u64Buckets[TIMING_BUCKETS];
+};
+
+// counters and gauges
+enum {
+    VALUE_CPU_MS_BEHIND, // how far the cpu emulation is behind real time
+    VALUE_CPU_MS_BEHIND_MAX,
+    VALUE_FRAMES_DECODED, // laserdisc video frames
+    VALUE_FRAMES_DROPPED,
+    VALUE_AUDIO_UNDERRUNS,      // mixer callbacks finding a sound chip behind
+    VALUE_DISC_AUDIO_BEHIND,    // disc audio buffers skipped to catch up
+    VALUE_OVERLAY_UPLOAD_BYTES, // overlay, LED and aux textures
+    VALUE_VIDEO_UPLOAD_BYTES,   // laserdisc video texture
+    VALUE_COUNT
+};
+
+// Turns the benchmark on, it will run for 'uMs' milliseconds of emulated time.
+void enable(unsigned int uMs);
+
+bool is_enabled();
+
+// where the JSON report gets written (benchmark.json by default)
+void set_report_path(const char *pszReportPath);
+const char *get_report_path();
+
+// starts the wall clock and the -stats_file thread (call right before the
+//  game starts running)
+void begin();
+
+// stops them again (call as soon as the game stops running)
+void end();
+
+// Must be called once per emulated millisecond.
+// Returns true once the benchmark has run for long enough.
+bool tick_ms();
+
+unsigned int get_emulated_ms();
+
+// how long the benchmark ran for in real time
+Uint64 get_wall_ns();
+
+// high resolution timestamp in nanoseconds (only differences are meaningful)
+Uint64 get_ns();
+
+// Adds one sample to a timing.  Safe to call from any thread.
+void add_timing(unsigned int uWhich, Uint64 u64Ns);
+
+// copies a timing out (thread-safe)
+void get_timing(unsigned int uWhich, timing_s *pTiming);
+
+const char *get_timing_name(unsigned int uWhich);
+
+// Counters and gauges.  All thread-safe.
+void set_value(unsigned int uWhich, Uint64 u64Value);
+void add_value(unsigned int uWhich, Uint64 u64Amount);
+void raise_value(unsigned int uWhich, Uint64 u64Value); // keeps the larger one
+Uint64 get_value(unsigned int uWhich);
+
+// a few lines summing everything up, for the stats OSD
+void format_osd(char *pszBuf, size_t uSize);
+
+// Writes all timings and values in the Prometheus text format.
+bool write_metrics(const char *pszPath);
+
+// Rewrites 'pszPath' with write_metrics() every 'uSecs' seconds from a
+//  background thread, between begin() and end().
+void set_metrics_file(const char *pszPath, unsigned int uSecs);
+
+// peak resident set size of the process in kilobytes (0 if not available)
+Uint64 get_peak_rss_kb();
+
+// Hardware cache misses on the thread that called begin() (the one running the
+//  cpu's), from begin() to end().  Only on linux, and returns false if the
+//  kernel wouldn't give us the counter
+//  (see /proc/sys/kernel/perf_event_paranoid).
+bool get_cache_misses(Uint64 &u64Misses);
+
+}
+
+#endif // PERFSTATS_H
@@ -0,0 +1,191 @@
+/*
+ * ____ HYPSEUS COPYRIGHT NOTICE ____
+ *
+ * Copyright (C) 2026 Hypseus Singe contributors
+ *
+ * This file is part of HYPSEUS SINGE, a laserdisc arcade game emulator
+ *
+ * HYPSEUS SINGE is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * HYPSEUS SINGE is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "config.h"
+
+#ifdef TRACE
+
+#include <stdio.h>
+#include <string>
+#include <vector>
+#include <plog/Log.h>
+#include "tracer.h"
+
+namespace tracer
+{
+
+// events kept per thread (must be a power of 2)
+static const unsigned int RING_SIZE = 1 << 16;
+
+// A writer that was already past its is_recording() check when recording
+//  stopped may still be storing an event.  Leaving this many of the oldest
+//  slots out of the dump keeps it from tearing one that is being read.
+static const unsigned int RING_SLACK = 16;
+
+struct event_s {
+    const char *pszName;
+    Uint64 u64StartNs;
+    Uint64 u64EndNs;
+};
+
+struct ring_s {
+    unsigned int uTid; // numbered in the order the threads first record
+    const char *pszName;
+    SDL_atomic_t head; // events written so far; only the owning thread writes
+    event_s events[RING_SIZE];
+};
+
+SDL_atomic_t g_recording = {0};
+
+std::string g_strPath = "trace.json";
+// events from before this belong to an earlier recording
+Uint64 g_u64StartNs = 0;
+
+// every ring ever created, they live until the process exits
+std::vector<ring_s *> g_vRings;
+SDL_SpinLock g_ringsLock = 0;
+
+thread_local ring_s *t_pRing = NULL;
+thread_local const char *t_pszName = NULL;
+
+static ring_s *get_ring()
+{
+    if (!t_pRing) {
+        ring_s *pRing = new ring_s;
+        pRing->pszName = t_pszName;
+        SDL_AtomicSet(&pRing->head, 0);
+
+        SDL_AtomicLock(&g_ringsLock);
+        pRing->uTid = (unsigned int)g_vRings.size() + 1;
+        g_vRings.push_back(pRing);
+        SDL_AtomicUnlock(&g_ringsLock);
+
+        t_pRing = pRing;
+    }
+
+    return t_pRing;
+}
+
+void set_path(const char *pszPath)
+{
+    g_strPath = pszPath;
+}
+
+void start()
+{
+    if (is_recording()) return;
+
+    g_u64StartNs = perfstats::get_ns();
+    SDL_AtomicSet(&g_recording, 1);
+    LOGI << "Trace recording started";
+}
+
+static void write_trace()
+{
+    FILE *F = fopen(g_strPath.c_str(), "w");
+    if (!F) {
+        LOGW << "Could not write " << g_strPath;
+        return;
+    }
+
+    SDL_AtomicLock(&g_ringsLock);
+    std::vector<ring_s *> vRings = g_vRings;
+    SDL_AtomicUnlock(&g_ringsLock);
+
+    unsigned int uEvents = 0;
+
+    fprintf(F, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+    fprintf(F, "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,"
+               "\"args\":{\"name\":\"hypseus\"}}");
+
+    for (size_t i = 0; i < vRings.size(); i++) {
+        ring_s *pRing = vRings[i];
+
+        if (pRing->pszName) {
+            fprintf(F, ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,"
+                       "\"tid\":%u,\"args\":{\"name\":\"%s\"}}",
+                    pRing->uTid, pRing->pszName);
+        }
+
+        unsigned int uHead = (unsigned int)SDL_AtomicGet(&pRing->head);
+        unsigned int uCount = uHead;
+        if (uCount > RING_SIZE - RING_SLACK) uCount = RING_SIZE - RING_SLACK;
+
+        for (unsigned int u = uHead - uCount; u != uHead; u++) {
+            const event_s &ev = pRing->events[u & (RING_SIZE - 1)];
+            if (ev.u64StartNs < g_u64StartNs) continue;
+
+            fprintf(F, ",\n{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%u,"
+                       "\"ts\":%.3f,\"dur\":%.3f}",
+                    ev.pszName, pRing->uTid,
+                    (ev.u64StartNs - g_u64StartNs) * 0.001,
+                    (ev.u64EndNs - ev.u64StartNs) * 0.001);
+            uEvents++;
+        }
+    }
+
+    fprintf(F, "\n]}\n");
+    fclose(F);
+
+    LOGI << "Wrote " << uEvents << " trace events to " << g_strPath;
+}
+
+void stop()
+{
+    if (!is_recording()) return;
+
+    SDL_AtomicSet(&g_recording, 0);
+    write_trace();
+}
+
+void toggle()
+{
+    if (is_recording()) {
+        stop();
+    } else {
+        start();
+    }
+}
+
+void set_thread_name(const char *pszName)
+{
+    t_pszName = pszName;
+    if (t_pRing) t_pRing->pszName = pszName;
+}
+
+void add_event(const char *pszName, Uint64 u64StartNs, Uint64 u64EndNs)
+{
+    ring_s *pRing = get_ring();
+
+    // only this thread ever moves the head, so a plain read is enough; the
+    //  store publishes the event to write_trace()
+    int iHead = SDL_AtomicGet(&pRing->head);
+    event_s *pEvent = &pRing->events[(unsigned int)iHead & (RING_SIZE - 1)];
+    pEvent->pszName = pszName;
+    pEvent->u64StartNs = u64StartNs;
+    pEvent->u64EndNs = u64EndNs;
+    SDL_AtomicSet(&pRing->head, (int)((unsigned int)iHead + 1));
+}
+
+}
+
+#endif // TRACE
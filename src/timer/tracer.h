@@ -0,0 +1,107 @@
+/*
+ * ____ HYPSEUS COPYRIGHT NOTICE ____
+ *
+ * Copyright (C) 2026 Hypseus Singe contributors
+ *
+ * This file is part of HYPSEUS SINGE, a laserdisc arcade game emulator
+ *
+ * HYPSEUS SINGE is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * HYPSEUS SINGE is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef TRACER_H
+#define TRACER_H
+
+// Event tracer for the emulation, VLDP and audio threads (cmake -DTRACE=ON).
+//
+// TRACE_SCOPE("name") records how long the rest of the enclosing block takes.
+//  Every thread writes into its own ring buffer, so recording takes no locks;
+//  when the ring is full the oldest events are overwritten.
+// Recording is started with -trace_events <file> or Alt-ScrollLock, and
+//  stopped by Alt-ScrollLock or by quitting; the events still in the rings are then written to the file in the
+//  Chrome trace format (load it in chrome://tracing or ui.perfetto.dev).
+// Names must be string literals, only the pointer is kept.
+// Without TRACE the macros compile to nothing.
+
+#include "config.h"
+
+#ifdef TRACE
+
+#include <SDL.h>
+#include "perfstats.h"
+
+namespace tracer
+{
+
+extern SDL_atomic_t g_recording;
+
+inline bool is_recording()
+{
+    return (SDL_AtomicGet(&g_recording) != 0);
+}
+
+// where the trace gets written (trace.json by default)
+void set_path(const char *pszPath);
+
+// start recording right away (-trace_events)
+void start();
+
+// stops recording and writes the trace
+void stop();
+
+// Alt-ScrollLock
+void toggle();
+
+// Names the calling thread in the trace.  The name must be a literal.
+void set_thread_name(const char *pszName);
+
+// one event on the calling thread's ring
+void add_event(const char *pszName, Uint64 u64StartNs, Uint64 u64EndNs);
+
+class scope
+{
+  public:
+    scope(const char *pszName)
+        : m_pszName(pszName),
+          m_u64StartNs(is_recording() ? perfstats::get_ns() : 0)
+    {
+    }
+
+    ~scope()
+    {
+        if (m_u64StartNs)
+            add_event(m_pszName, m_u64StartNs, perfstats::get_ns());
+    }
+
+  private:
+    const char *m_pszName;
+    Uint64 m_u64StartNs;
+};
+
+}
+
+#define TRACE_CONCAT2(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT2(a, b)
+#define TRACE_SCOPE(name)                                                      \
+    tracer::scope TRACE_CONCAT(trace_scope_, __LINE__)(name)
+#define TRACE_THREAD_NAME(name) tracer::set_thread_name(name)
+
+#else
+
+#define TRACE_SCOPE(name)
+#define TRACE_THREAD_NAME(name)
+
+#endif // TRACE
+
+#endif // TRACER_H
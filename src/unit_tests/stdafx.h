@@ -7,6 +7,8 @@
 
 
 #include <iostream>
+#include <vector>
+#include <algorithm>
 #include <tchar.h>
 
 
@@ -15,4 +17,13 @@
 #include "../scoreboard/scoreboard_factory.h"
 #include "../scoreboard/scoreboard_collection.h"
 #include "../scoreboard/scoreboard_interface.h"
+#include "../scoreboard/usb_writer.h"
+#include "../io/mpo_mem.h"
+#include "../io/input_queue.h"
+#include "../io/rom_cache.h"
+#include "../vldp/frame_index.h"
+#include "../vldp/gop_decoder.h"
+#include "../sound/sound.h"
+#include "../sound/gisound.h"
+#include "../sound/sn_intf.h"
 #include "test_framework.h"
@@ -0,0 +1,135 @@
+#include "stdafx.h"
+
+// Tests for the compact frame index VLDP keeps the I frame positions of an
+//  mpeg in.  Lookups are checked against a plain table of one Uint32 per frame,
+//  which is what it replaced, and the memory and lookup time of both get
+//  printed for a few stream lengths.
+
+static const Uint32 NP = FrameIndex::NO_POS;
+
+static Uint32 next_rnd(Uint32 &uSeed)
+{
+	uSeed = (uSeed * 1103515245) + 12345;
+	return (uSeed >> 8) & 0xFFFF;
+}
+
+// Makes a table of uFrames frames, with GOPs of uGOP frames (or random lengths
+//  if uGOP is 0) and about uGOPBytes bytes each.
+static void make_positions(Uint32 uFrames, Uint32 uGOP, Uint32 uGOPBytes,
+	Uint32 uSeed, vector<Uint32> &vPositions)
+{
+	Uint32 uPos = 0;
+	Uint32 uLeft = 0;
+
+	vPositions.clear();
+	for (Uint32 u = 0; u < uFrames; u++) {
+		if (uLeft == 0) {
+			uLeft = uGOP ? uGOP : (1 + (next_rnd(uSeed) % 150));
+			uPos += (uGOPBytes / 2) + (next_rnd(uSeed) % (uGOPBytes + 1));
+			vPositions.push_back(uPos);
+		}
+		else vPositions.push_back(NP);
+		uLeft--;
+	}
+}
+
+static void check_index(const vector<Uint32> &vPositions)
+{
+	FrameIndex index;
+	for (size_t u = 0; u < vPositions.size(); u++) {
+		index.Add(vPositions[u]);
+	}
+
+	TEST_CHECK_EQUAL(index.GetFrameCount(), (unsigned int) vPositions.size());
+
+	bool bSame = true;
+	for (size_t u = 0; u < vPositions.size(); u++) {
+		if (index.GetPosition((Uint32) u) != vPositions[u]) bSame = false;
+	}
+	TEST_CHECK(bSame);
+	TEST_CHECK_EQUAL(index.GetPosition((Uint32) vPositions.size()), NP);
+
+	// every I frame is found from its own position and from just before it
+	bool bFound = true;
+	Uint32 uPrevPos = 0;
+	for (size_t u = 0; u < vPositions.size(); u++) {
+		if (vPositions[u] == NP) continue;
+		if (index.GetFrameAt(vPositions[u]) != u) bFound = false;
+		if (index.GetFrameAt(uPrevPos + 1) != u) bFound = false;
+		uPrevPos = vPositions[u];
+	}
+	TEST_CHECK(bFound);
+	TEST_CHECK_EQUAL(index.GetFrameAt(uPrevPos + 1), index.GetFrameCount());
+}
+
+TEST_CASE(frame_index_lookup)
+{
+	vector<Uint32> vPositions;
+
+	// usual GOPs, random ones (some longer than a slot), I frames only, and
+	//  GOPs too big for a 3 byte varint
+	make_positions(5000, 15, 80000, 1, vPositions);
+	check_index(vPositions);
+	make_positions(5000, 0, 80000, 2, vPositions);
+	check_index(vPositions);
+	make_positions(500, 1, 8000, 3, vPositions);
+	check_index(vPositions);
+	make_positions(500, 12, 40000000, 4, vPositions);
+	check_index(vPositions);
+
+	// frames before the first I frame aren't I frames
+	static const Uint32 positions[] = { NP, NP, 100, NP, NP, 250, 400, NP };
+	vPositions.assign(positions, positions + 8);
+	check_index(vPositions);
+
+	FrameIndex index;
+	TEST_CHECK_EQUAL(index.GetPosition(0), NP);
+	TEST_CHECK_EQUAL(index.GetFrameAt(0), 0u);
+	index.Add(NP);
+	TEST_CHECK_EQUAL(index.GetPosition(0), NP);
+	TEST_CHECK_EQUAL(index.GetFrameAt(0), 1u);
+	index.Clear();
+	TEST_CHECK_EQUAL(index.GetFrameCount(), 0u);
+}
+
+// reports the memory and lookup time of the index and of a plain table
+TEST_CASE(frame_index_benchmark)
+{
+	static const Uint32 LOOKUPS = 4000000;
+	static const Uint32 sizes[] = { 10000, 100000, 1000000, 4000000 };
+
+	cout << "frame_index_benchmark: 15 frame GOPs, " << LOOKUPS << " random lookups" << endl;
+
+	for (int i = 0; i < 4; i++) {
+		vector<Uint32> vPositions;
+		make_positions(sizes[i], 15, 80000, i, vPositions);
+
+		FrameIndex index;
+		for (size_t u = 0; u < vPositions.size(); u++) {
+			index.Add(vPositions[u]);
+		}
+
+		Uint32 uSeed = 99;
+		Uint32 uSum[2] = { 0, 0 };
+		Uint32 uMs[2];
+
+		Uint32 uStartMs = SDL_GetTicks();
+		for (Uint32 u = 0; u < LOOKUPS; u++) {
+			uSum[0] += vPositions[((next_rnd(uSeed) << 16) | next_rnd(uSeed)) % sizes[i]];
+		}
+		uMs[0] = SDL_GetTicks() - uStartMs;
+
+		uSeed = 99;
+		uStartMs = SDL_GetTicks();
+		for (Uint32 u = 0; u < LOOKUPS; u++) {
+			uSum[1] += index.GetPosition(((next_rnd(uSeed) << 16) | next_rnd(uSeed)) % sizes[i]);
+		}
+		uMs[1] = SDL_GetTicks() - uStartMs;
+
+		TEST_CHECK_EQUAL(uSum[1], uSum[0]);
+
+		cout << "  " << sizes[i] << " frames: table " << (sizes[i] * sizeof(Uint32)) << " bytes, "
+			<< (uMs[0] * 1000000.0) / LOOKUPS << " ns; index " << index.GetMemoryUsage()
+			<< " bytes, " << (uMs[1] * 1000000.0) / LOOKUPS << " ns" << endl;
+	}
+}
@@ -115,6 +115,8 @@ void instantiator()
 	TestFrameWork::DoTestEqual(u, 0, 0, "blah");
 	TestFrameWork::DoTestEqual(true, true, 0, "blah");	// two bools
 	TestFrameWork::DoTestEqual(u8, 0, 0, "blah");	// unsigned char, and int
+	TestFrameWork::DoTestEqual(u, u, 0, "blah");	// two unsigned ints
+	TestFrameWork::DoTestEqual(1, 'a', 0, "blah");	// int and char
 
 	TestFrameWork::DoTestNotEqual(1, 2, 0, "blah");
 	
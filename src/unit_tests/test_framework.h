@@ -8,7 +8,7 @@ using namespace std;
 
 #define TEST_CHECK(a) TestFrameWork::DoTest(#a, a, __LINE__, __FILE__)
 
-#define TEST_REQUIRE(a) TestFrameWork::DoTest(#a, a, __LINE__, __FILE__); if (!a) return
+#define TEST_REQUIRE(a) TestFrameWork::DoTest(#a, a, __LINE__, __FILE__); if (!(a)) return
 
 #define TEST_CHECK_EQUAL(a,b) TestFrameWork::DoTestEqual(a, b, __LINE__, __FILE__)
 
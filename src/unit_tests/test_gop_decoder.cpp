@@ -0,0 +1,538 @@
+#include "stdafx.h"
+
+// Tests for the multi-threaded mpeg2 decoder.  A synthetic 720p stream is made
+//  up here (open GOPs, so the leading B frames need the GOP before), decoded
+//  the way VLDP always has with one libmpeg2 decoder, and then again span by
+//  span on the threads.  The frames must come out the same.  The speed of each
+//  thread count gets printed as well.  Last, searches are timed with and
+//  without decoding the B frames that get skipped over.
+
+static const int SYNTH_WIDTH = 1280;
+static const int SYNTH_HEIGHT = 720;
+static const int SYNTH_GOP = 12;	// frames per GOP, as IBBPBBPBBPBB
+
+class BitWriter
+{
+public:
+	void put(unsigned int uBits, int iCount)
+	{
+		while (iCount-- > 0) {
+			m_uByte = (m_uByte << 1) | ((uBits >> iCount) & 1);
+			if (++m_iBits == 8) {
+				m_vData.push_back((Uint8) m_uByte);
+				m_uByte = m_iBits = 0;
+			}
+		}
+	}
+
+	void align()
+	{
+		while (m_iBits) put(0, 1);
+	}
+
+	void start_code(Uint8 u8Code)
+	{
+		align();
+		put(0x000001, 24);
+		put(u8Code, 8);
+	}
+
+	unsigned int size() { return (unsigned int) m_vData.size(); }
+
+	vector<Uint8> m_vData;
+
+private:
+	unsigned int m_uByte = 0;
+	int m_iBits = 0;
+};
+
+class SynthStream
+{
+public:
+	SynthStream() : m_uSeed(12345) { }
+
+	// Makes uGOPs GOPs.  vPositions gets each picture's position if it is an I
+	//  frame, or NO_POS, in decode order like mpegscan's .dat files.
+	void make(unsigned int uGOPs, vector<Uint8> &vStream, vector<Uint32> &vPositions,
+		unsigned int &uHeaderSize)
+	{
+		BitWriter bw;
+
+		sequence_header(bw);
+		uHeaderSize = bw.size();
+
+		for (unsigned int uGOP = 0; uGOP < uGOPs; uGOP++) {
+			gop_header(bw, uGOP, uGOP == 0);
+
+			// decode order: I, then (for all but the first GOP) the two B
+			//  frames before it, then each P with the two B frames before it
+			picture(bw, vPositions, 1, 2);
+			if (uGOP != 0) {
+				picture(bw, vPositions, 3, 0);
+				picture(bw, vPositions, 3, 1);
+			}
+			for (int iRef = 5; iRef < SYNTH_GOP + 2; iRef += 3) {
+				picture(bw, vPositions, 2, iRef);
+				picture(bw, vPositions, 3, iRef - 2);
+				picture(bw, vPositions, 3, iRef - 1);
+			}
+		}
+
+		bw.start_code(0xB7);	// sequence end
+		vStream.swap(bw.m_vData);
+	}
+
+private:
+	unsigned int rnd(unsigned int uRange)
+	{
+		m_uSeed = m_uSeed * 1103515245 + 12345;
+		return (m_uSeed >> 16) % uRange;
+	}
+
+	void sequence_header(BitWriter &bw)
+	{
+		bw.start_code(0xB3);
+		bw.put(SYNTH_WIDTH, 12);
+		bw.put(SYNTH_HEIGHT, 12);
+		bw.put(3, 4);		// 16:9
+		bw.put(4, 4);		// 29.97 fps
+		bw.put(20000, 18);	// bit rate
+		bw.put(1, 1);		// marker
+		bw.put(112, 10);	// vbv buffer size
+		bw.put(0, 3);		// not constrained, default matrices
+
+		bw.start_code(0xB5);	// sequence extension
+		bw.put(1, 4);
+		bw.put(0x44, 8);	// main profile, high level
+		bw.put(1, 1);		// progressive
+		bw.put(1, 2);		// 4:2:0
+		bw.put(0, 4);		// size extensions
+		bw.put(0, 12);		// bit rate extension
+		bw.put(1, 1);		// marker
+		bw.put(0, 8);		// vbv buffer size extension
+		bw.put(0, 8);		// not low delay, frame rate extensions
+	}
+
+	void gop_header(BitWriter &bw, unsigned int uGOP, bool bClosed)
+	{
+		bw.start_code(0xB8);
+		bw.put(0, 6);		// drop frame, hours
+		bw.put(uGOP / 60, 6);
+		bw.put(1, 1);		// marker
+		bw.put(uGOP % 60, 6);
+		bw.put(0, 6);
+		bw.put(bClosed ? 1 : 0, 1);
+		bw.put(0, 1);		// broken link
+	}
+
+	void picture(BitWriter &bw, vector<Uint32> &vPositions, int iType, int iTemporalRef)
+	{
+		bw.align();
+		vPositions.push_back((iType == 1) ? bw.size() : GOPDecoder::NO_POS);
+
+		bw.start_code(0x00);
+		bw.put(iTemporalRef, 10);
+		bw.put(iType, 3);
+		bw.put(0xFFFF, 16);	// vbv delay
+		if (iType >= 2) bw.put(7, 4);	// forward f_code (unused in mpeg2)
+		if (iType == 3) bw.put(7, 4);	// backward f_code
+		bw.put(0, 1);
+
+		bw.start_code(0xB5);	// picture coding extension
+		bw.put(8, 4);
+		bw.put((iType >= 2) ? 0x11 : 0xFF, 8);	// forward f_codes
+		bw.put((iType == 3) ? 0x11 : 0xFF, 8);	// backward f_codes
+		bw.put(0, 2);		// 8 bit dc
+		bw.put(3, 2);		// frame picture
+		bw.put(0, 1);		// top field first
+		bw.put(1, 1);		// frame prediction and dct only
+		bw.put(0, 5);		// concealment, q scale, vlc format, scan, rff
+		bw.put(1, 1);		// chroma 420 type
+		bw.put(1, 1);		// progressive frame
+		bw.put(0, 1);		// no composite display
+
+		for (int iRow = 0; iRow < SYNTH_HEIGHT / 16; iRow++) {
+			bw.start_code((Uint8) (iRow + 1));
+			bw.put(4 + rnd(8), 5);	// quantiser scale
+			bw.put(0, 1);
+
+			for (int iCol = 0; iCol < SYNTH_WIDTH / 16; iCol++) {
+				bw.put(1, 1);	// address increment of 1
+
+				// a third of the macroblocks are coded, the rest are predicted
+				bool bIntra = (iType == 1) || (rnd(3) == 0);
+				if (bIntra) {
+					if (iType == 1) bw.put(1, 1);
+					else bw.put(3, 5);
+					for (int iBlock = 0; iBlock < 6; iBlock++) {
+						intra_block(bw, iBlock < 4);
+					}
+				} else if (iType == 2) {
+					bw.put(1, 3);	// motion compensated, not coded
+					motion_vector(bw);
+				} else {
+					bw.put(2, 2);	// interpolated, not coded
+					motion_vector(bw);
+					motion_vector(bw);
+				}
+			}
+		}
+	}
+
+	void intra_block(BitWriter &bw, bool bLuma)
+	{
+		// dc size 3 (the codes differ for luma and chroma), then the difference
+		if (bLuma) bw.put(5, 3);
+		else bw.put(6, 3);
+		bw.put(rnd(8), 3);
+
+		// a few ac coefficients, all escape coded
+		int iPos = 0;
+		int iCount = 2 + rnd(6);
+		for (int i = 0; i < iCount; i++) {
+			int iRun = rnd(4);
+			iPos += iRun + 1;
+			if (iPos > 63) break;
+			int iLevel = 8 + rnd(40);
+			if (rnd(2)) iLevel = -iLevel;
+			bw.put(1, 6);
+			bw.put(iRun, 6);
+			bw.put(iLevel & 0xFFF, 12);
+		}
+		bw.put(2, 2);	// end of block
+	}
+
+	// a vector that moves by at most a pixel from the last one
+	void motion_vector(BitWriter &bw)
+	{
+		for (int i = 0; i < 2; i++) {
+			switch (rnd(3)) {
+			case 0: bw.put(1, 1); break;	// 0
+			case 1: bw.put(2, 3); break;	// +1
+			default: bw.put(3, 3); break;	// -1
+			}
+		}
+	}
+
+	unsigned int m_uSeed;
+};
+
+static void make_index(const Uint32 *pPositions, size_t uCount, FrameIndex &index)
+{
+	index.Clear();
+	for (size_t u = 0; u < uCount; u++) {
+		index.Add(pPositions[u]);
+	}
+}
+
+static Uint32 hash_frame(const Uint8 *const *buf, int iWidth, int iChromaWidth)
+{
+	unsigned int uSizes[3];
+	uSizes[0] = iWidth * SYNTH_HEIGHT;
+	uSizes[1] = uSizes[2] = iChromaWidth * (SYNTH_HEIGHT / 2);
+
+	Uint32 uHash = 2166136261u;
+	for (int i = 0; i < 3; i++) {
+		for (unsigned int u = 0; u < uSizes[i]; u++) {
+			uHash = (uHash ^ buf[i][u]) * 16777619u;
+		}
+	}
+	return uHash;
+}
+
+// decodes the way vldp_internal does: in 256k chunks, after a search if
+//  uStartPos isn't 0
+static void decode_serial(const vector<Uint8> &vStream, unsigned int uHeaderSize,
+	Uint32 uStartPos, vector<Uint32> &vHashes)
+{
+	static const unsigned int CHUNK = 262144;
+	mpeg2dec_t *pDecoder = mpeg2_init();
+	const mpeg2_info_t *info = mpeg2_info(pDecoder);
+	vector<Uint8> vData(vStream);
+
+	if (uStartPos != 0) {
+		mpeg2_reset(pDecoder, 0);
+		mpeg2_buffer(pDecoder, &vData[0], &vData[0] + uHeaderSize);
+		while (mpeg2_parse(pDecoder) != STATE_BUFFER) { }
+	}
+
+	for (unsigned int uPos = uStartPos; uPos < vData.size(); uPos += CHUNK) {
+		unsigned int uEnd = uPos + CHUNK;
+		if (uEnd > vData.size()) uEnd = (unsigned int) vData.size();
+		mpeg2_buffer(pDecoder, &vData[uPos], &vData[0] + uEnd);
+
+		for (;;) {
+			mpeg2_state_t state = mpeg2_parse(pDecoder);
+			if (state == STATE_BUFFER) break;
+			if (((state == STATE_SLICE) || (state == STATE_END) ||
+				(state == STATE_INVALID_END)) && info->display_fbuf) {
+				vHashes.push_back(hash_frame(info->display_fbuf->buf,
+					info->sequence->width, info->sequence->chroma_width));
+			}
+		}
+	}
+
+	mpeg2_close(pDecoder);
+}
+
+// decodes the way ivldp_render_threaded does, returns how long it took in ms
+static Uint32 decode_threaded(GOPDecoder &decoder, const vector<Uint8> &vStream,
+	unsigned int uHeaderSize, const vector<Uint32> &vPositions, Uint32 uStartPos,
+	vector<Uint32> &vHashes)
+{
+	GOPDecoder::span_cursor_s cursor;
+	GOPDecoder::span_pos_s span;
+	bool bMore = true;
+	Uint32 uStartMs = SDL_GetTicks();
+
+	FrameIndex index;
+	make_index(&vPositions[0], vPositions.size(), index);
+	GOPDecoder::InitCursor(cursor, &index, (Uint32) vStream.size(), uStartPos);
+
+	for (;;) {
+		while (bMore && (decoder.GetQueuedCount() <= decoder.GetThreadCount())) {
+			bMore = GOPDecoder::NextSpan(cursor, span);
+			if (!bMore) break;
+
+			Uint32 uFrom = (span.uLeadStart != GOPDecoder::NO_POS) ? span.uLeadStart : span.uStart;
+			unsigned int uHeader = (uFrom != 0) ? uHeaderSize : 0;
+
+			vector<Uint8> vData(vStream.begin(), vStream.begin() + uHeader);
+			vData.insert(vData.end(), vStream.begin() + uFrom, vStream.begin() + span.uEnd);
+			decoder.Queue(vData, uHeader, span.uStart - uFrom);
+		}
+
+		const GOPDecoder::frame_s *pFrame = decoder.GetFrame();
+		if (!pFrame) break;
+		vHashes.push_back(hash_frame(pFrame->buf, pFrame->width, pFrame->chroma_width));
+	}
+
+	return SDL_GetTicks() - uStartMs;
+}
+
+// spans end on I frames, with the lead-in starting at the I frame before
+TEST_CASE(gop_decoder_spans)
+{
+	static const Uint32 NP = GOPDecoder::NO_POS;
+	static const Uint32 positions[] = { 10, NP, NP, 100, NP, NP, 200, NP, NP, 300, NP };
+	GOPDecoder::span_cursor_s cursor;
+	GOPDecoder::span_pos_s span;
+
+	FrameIndex index;
+	make_index(positions, 11, index);
+	GOPDecoder::InitCursor(cursor, &index, 400, 100);
+
+	// too short for SPAN_MIN_FRAMES, so it all ends up in one span
+	TEST_REQUIRE(GOPDecoder::NextSpan(cursor, span));
+	TEST_CHECK_EQUAL(span.uLeadStart, NP);
+	TEST_CHECK_EQUAL(span.uStart, 100u);
+	TEST_CHECK_EQUAL(span.uEnd, 400u);
+	TEST_CHECK(!GOPDecoder::NextSpan(cursor, span));
+
+	vector<Uint32> vPositions;
+	for (Uint32 u = 0; u < 40; u++) {
+		vPositions.push_back(((u % 10) == 0) ? (u * 100) : NP);
+	}
+	make_index(&vPositions[0], 40, index);
+	GOPDecoder::InitCursor(cursor, &index, 4000, 0);
+
+	TEST_REQUIRE(GOPDecoder::NextSpan(cursor, span));
+	TEST_CHECK_EQUAL(span.uLeadStart, NP);
+	TEST_CHECK_EQUAL(span.uStart, 0u);
+	TEST_CHECK_EQUAL(span.uEnd, 2000u);
+	TEST_REQUIRE(GOPDecoder::NextSpan(cursor, span));
+	TEST_CHECK_EQUAL(span.uLeadStart, 1000u);
+	TEST_CHECK_EQUAL(span.uStart, 2000u);
+	TEST_CHECK_EQUAL(span.uEnd, 4000u);
+	TEST_CHECK(!GOPDecoder::NextSpan(cursor, span));
+}
+
+// every thread count gives exactly the frames one decoder does
+TEST_CASE(gop_decoder_identical)
+{
+	SynthStream synth;
+	vector<Uint8> vStream;
+	vector<Uint32> vPositions;
+	unsigned int uHeaderSize = 0;
+	synth.make(8, vStream, vPositions, uHeaderSize);
+
+	// from the beginning and from a search to the third GOP
+	Uint32 uStarts[2] = { 0, 0 };
+	for (size_t i = 0, uIFrames = 0; i < vPositions.size(); i++) {
+		if ((vPositions[i] != GOPDecoder::NO_POS) && (++uIFrames == 3)) {
+			uStarts[1] = vPositions[i];
+			break;
+		}
+	}
+
+	for (int iStart = 0; iStart < 2; iStart++) {
+		vector<Uint32> vSerial;
+		decode_serial(vStream, uHeaderSize, uStarts[iStart], vSerial);
+		TEST_REQUIRE(vSerial.size() > (unsigned int) SYNTH_GOP * 4);
+
+		for (unsigned int uThreads = 1; uThreads <= 4; uThreads *= 2) {
+			GOPDecoder decoder;
+			TEST_REQUIRE(decoder.Start(uThreads));
+
+			vector<Uint32> vThreaded;
+			decode_threaded(decoder, vStream, uHeaderSize, vPositions, uStarts[iStart], vThreaded);
+			TEST_CHECK_EQUAL((unsigned int) vThreaded.size(), (unsigned int) vSerial.size());
+
+			// After a search the two B frames before the I frame refer to a
+			//  frame that was never decoded, so they are whatever was left in
+			//  the decoder's buffers (the search skips over them).
+			unsigned int uUndefined = (uStarts[iStart] != 0) ? 2 : 0;
+			TEST_REQUIRE(vThreaded.size() == vSerial.size());
+			TEST_CHECK(equal(vThreaded.begin() + uUndefined, vThreaded.end(),
+				vSerial.begin() + uUndefined));
+		}
+	}
+}
+
+// a reset in the middle of decoding leaves nothing behind
+TEST_CASE(gop_decoder_reset)
+{
+	SynthStream synth;
+	vector<Uint8> vStream;
+	vector<Uint32> vPositions;
+	unsigned int uHeaderSize = 0;
+	synth.make(6, vStream, vPositions, uHeaderSize);
+
+	GOPDecoder decoder;
+	TEST_REQUIRE(decoder.Start(2));
+
+	vector<Uint32> vFirst, vSecond;
+	decode_threaded(decoder, vStream, uHeaderSize, vPositions, 0, vFirst);
+
+	// queue everything, take one frame, then throw it all away
+	GOPDecoder::span_cursor_s cursor;
+	GOPDecoder::span_pos_s span;
+	FrameIndex index;
+	make_index(&vPositions[0], vPositions.size(), index);
+	GOPDecoder::InitCursor(cursor, &index, (Uint32) vStream.size(), 0);
+	while (GOPDecoder::NextSpan(cursor, span)) {
+		Uint32 uFrom = (span.uLeadStart != GOPDecoder::NO_POS) ? span.uLeadStart : span.uStart;
+		vector<Uint8> vData(vStream.begin(), vStream.begin() + uHeaderSize);
+		vData.insert(vData.end(), vStream.begin() + uFrom, vStream.begin() + span.uEnd);
+		decoder.Queue(vData, uHeaderSize, span.uStart - uFrom);
+	}
+	TEST_CHECK(decoder.GetFrame() != NULL);
+	decoder.Reset();
+	TEST_CHECK_EQUAL(decoder.GetQueuedCount(), 0u);
+	TEST_CHECK(decoder.GetFrame() == NULL);
+
+	decode_threaded(decoder, vStream, uHeaderSize, vPositions, 0, vSecond);
+	TEST_CHECK(vFirst == vSecond);
+}
+
+// reports the frame rate of each thread count
+TEST_CASE(gop_decoder_benchmark)
+{
+	SynthStream synth;
+	vector<Uint8> vStream;
+	vector<Uint32> vPositions;
+	unsigned int uHeaderSize = 0;
+	synth.make(10, vStream, vPositions, uHeaderSize);
+
+	vector<Uint32> vSerial;
+	Uint32 uStartMs = SDL_GetTicks();
+	decode_serial(vStream, uHeaderSize, 0, vSerial);
+	Uint32 uSerialMs = SDL_GetTicks() - uStartMs;
+	cout << "gop_decoder_benchmark: " << SYNTH_WIDTH << "x" << SYNTH_HEIGHT << ", "
+		<< vSerial.size() << " frames" << endl;
+	cout << "  single decoder: " << (vSerial.size() * 1000.0) / (uSerialMs ? uSerialMs : 1)
+		<< " fps" << endl;
+
+	for (unsigned int uThreads = 1; uThreads <= 4; uThreads *= 2) {
+		GOPDecoder decoder;
+		TEST_REQUIRE(decoder.Start(uThreads));
+
+		vector<Uint32> vHashes;
+		Uint32 uMs = decode_threaded(decoder, vStream, uHeaderSize, vPositions, 0, vHashes);
+		TEST_CHECK(vHashes == vSerial);
+
+		cout << "  " << uThreads << " thread(s): " << (vHashes.size() * 1000.0) / (uMs ? uMs : 1)
+			<< " fps" << endl;
+	}
+}
+
+// Searches the way idle_handler_search does, from the I frame at uStartPos,
+//  skipping uSkip frames.  Returns the hash of the frame it lands on.
+//  bSkipB decodes only what the frames after it refer to, as decode_mpeg2
+//  does while s_frames_to_skip is set.
+static Uint32 decode_search(const vector<Uint8> &vStream, unsigned int uHeaderSize,
+	Uint32 uStartPos, unsigned int uSkip, bool bSkipB)
+{
+	mpeg2dec_t *pDecoder = mpeg2_init();
+	const mpeg2_info_t *info = mpeg2_info(pDecoder);
+	vector<Uint8> vData(vStream);
+	Uint32 uHash = 0;
+	bool bFound = false;
+
+	mpeg2_reset(pDecoder, 0);
+	mpeg2_buffer(pDecoder, &vData[0], &vData[0] + uHeaderSize);
+	while (mpeg2_parse(pDecoder) != STATE_BUFFER) { }
+
+	mpeg2_buffer(pDecoder, &vData[uStartPos], &vData[0] + vData.size());
+	while (!bFound) {
+		mpeg2_state_t state = mpeg2_parse(pDecoder);
+		if (state == STATE_BUFFER) break;
+
+		if (state == STATE_PICTURE) {
+			mpeg2_skip(pDecoder, bSkipB && (uSkip > 0) &&
+				((info->current_picture->flags & PIC_MASK_CODING_TYPE) == PIC_FLAG_CODING_TYPE_B));
+		}
+		else if (((state == STATE_SLICE) || (state == STATE_END) ||
+			(state == STATE_INVALID_END)) && info->display_fbuf) {
+			if (uSkip == 0) {
+				uHash = hash_frame(info->display_fbuf->buf,
+					info->sequence->width, info->sequence->chroma_width);
+				bFound = true;
+			}
+			else uSkip--;
+		}
+	}
+
+	mpeg2_close(pDecoder);
+	TEST_CHECK(bFound);
+	return uHash;
+}
+
+// not decoding the skipped B frames lands on the same frame, sooner
+TEST_CASE(vldp_search_benchmark)
+{
+	SynthStream synth;
+	vector<Uint8> vStream;
+	vector<Uint32> vPositions;
+	unsigned int uHeaderSize = 0;
+	synth.make(6, vStream, vPositions, uHeaderSize);
+
+	// the fourth GOP, as a search that backed up to its I frame sees it
+	Uint32 uStartPos = 0;
+	for (size_t i = 0, uIFrames = 0; i < vPositions.size(); i++) {
+		if ((vPositions[i] != GOPDecoder::NO_POS) && (++uIFrames == 4)) {
+			uStartPos = vPositions[i];
+			break;
+		}
+	}
+	TEST_REQUIRE(uStartPos != 0);
+
+	// the first two frames are the leading B frames, which are never right
+	//  after a search
+	Uint32 uMs[2] = { 0, 0 };
+	unsigned int uSearches = 0;
+	for (unsigned int uSkip = 2; uSkip < SYNTH_GOP + 2; uSkip++, uSearches++) {
+		Uint32 uHashes[2];
+		for (int iSkipB = 0; iSkipB < 2; iSkipB++) {
+			Uint32 uStartMs = SDL_GetTicks();
+			uHashes[iSkipB] = decode_search(vStream, uHeaderSize, uStartPos, uSkip, iSkipB != 0);
+			uMs[iSkipB] += SDL_GetTicks() - uStartMs;
+		}
+		TEST_CHECK_EQUAL(uHashes[1], uHashes[0]);
+	}
+
+	cout << "vldp_search_benchmark: " << uSearches << " searches into a "
+		<< SYNTH_GOP << " frame GOP" << endl;
+	cout << "  decoding every frame: " << (uMs[0] * 1.0) / uSearches << " ms per search" << endl;
+	cout << "  skipping B frames:    " << (uMs[1] * 1.0) / uSearches << " ms per search" << endl;
+}
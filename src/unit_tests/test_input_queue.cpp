@@ -0,0 +1,124 @@
+#include "stdafx.h"
+
+// Tests for the timed input queue.  Synthetic key events are fed in the way
+//  cpu::execute does it: the host polls every INPUT_POLL_MS, while the queue is
+//  drained once per emulated ms.  The latency of each event is measured in
+//  emulated ms from when it arrived to when the game got it.
+
+static const unsigned int POLL_MS = 4;
+
+static SDL_Event make_key_event(Uint32 uTimestamp, int iKey)
+{
+	SDL_Event event;
+	memset(&event, 0, sizeof(event));
+	event.type = SDL_KEYDOWN;
+	event.common.timestamp = uTimestamp;
+	event.key.keysym.sym = iKey;
+	return event;
+}
+
+struct arrival_s
+{
+	Uint32 uHostMs;
+	int iKey;
+};
+
+// Runs the emulation from host ms 1000 to 1100, with the emulated clock
+//  'iEmuBehindMs' behind the host.  Returns the latency of each event in the
+//  order the game got them, along with their keys.
+static void run_schedule(const arrival_s *pArrivals, unsigned int uCount,
+	int iEmuBehindMs, vector<int> &vLatency, vector<int> &vKeys)
+{
+	TimedInputQueue q(POLL_MS);
+	vector<SDL_Event> vPending;	// arrived at the host, not polled yet
+	unsigned int uNext = 0;
+
+	for (Uint32 uHostMs = 1000; uHostMs < 1100; uHostMs++) {
+		unsigned int uEmuMs = uHostMs - iEmuBehindMs;
+
+		while ((uNext < uCount) && (pArrivals[uNext].uHostMs <= uHostMs)) {
+			vPending.push_back(make_key_event(pArrivals[uNext].uHostMs, pArrivals[uNext].iKey));
+			uNext++;
+		}
+
+		if ((uHostMs % POLL_MS) == 0) {
+			for (size_t i = 0; i < vPending.size(); i++) {
+				q.push(vPending[i], uHostMs, uEmuMs);
+			}
+			vPending.clear();
+		}
+
+		SDL_Event event;
+		while (q.pop_due(uEmuMs, &event)) {
+			int iArrivalEmuMs = (int) event.common.timestamp - iEmuBehindMs;
+			vLatency.push_back((int) uEmuMs - iArrivalEmuMs);
+			vKeys.push_back(event.key.keysym.sym);
+		}
+	}
+}
+
+// every event sees the same latency, whenever in the poll interval it arrived
+TEST_CASE(input_queue_jitter)
+{
+	static const arrival_s arrivals[] = {
+		{ 1001, 'a' }, { 1002, 'b' }, { 1003, 'c' }, { 1004, 'd' },
+		{ 1017, 'e' }, { 1030, 'f' }, { 1030, 'g' }, { 1045, 'h' },
+	};
+	unsigned int uCount = sizeof(arrivals) / sizeof(arrival_s);
+
+	for (int iBehind = 0; iBehind <= 10; iBehind += 10) {
+		vector<int> vLatency, vKeys;
+		run_schedule(arrivals, uCount, iBehind, vLatency, vKeys);
+
+		TEST_REQUIRE(vLatency.size() == uCount);
+		for (unsigned int u = 0; u < uCount; u++) {
+			TEST_CHECK_EQUAL(vLatency[u], (int) POLL_MS);
+			TEST_CHECK_EQUAL(vKeys[u], arrivals[u].iKey);
+		}
+	}
+}
+
+// events that waited longer than the delay go out right away
+TEST_CASE(input_queue_late)
+{
+	TimedInputQueue q(POLL_MS);
+	SDL_Event event;
+
+	q.push(make_key_event(900, 'a'), 1000, 500);
+	q.push(make_key_event(999, 'b'), 1000, 500);
+	q.push(make_key_event(0, 'c'), 1000, 500);	// no timestamp
+
+	TEST_CHECK(q.pop_due(500, &event));
+	TEST_CHECK_EQUAL(event.key.keysym.sym, 'a');
+
+	// 'b' arrived 1 ms ago so it's due at 503, 'c' counts as brand new
+	TEST_CHECK(!q.pop_due(502, &event));
+	TEST_CHECK(q.pop_due(503, &event));
+	TEST_CHECK_EQUAL(event.key.keysym.sym, 'b');
+	TEST_CHECK(!q.pop_due(503, &event));
+	TEST_CHECK(q.pop_due(504, &event));
+	TEST_CHECK_EQUAL(event.key.keysym.sym, 'c');
+	TEST_CHECK(q.empty());
+
+	// pop() doesn't care whether anything is due
+	q.push(make_key_event(1000, 'd'), 1000, 500);
+	TEST_CHECK(!q.pop_due(500, &event));
+	TEST_CHECK(q.pop(&event));
+	TEST_CHECK_EQUAL(event.key.keysym.sym, 'd');
+}
+
+// an event polled later never overtakes one polled earlier
+TEST_CASE(input_queue_order)
+{
+	TimedInputQueue q(POLL_MS);
+	SDL_Event event;
+
+	q.push(make_key_event(1000, 'a'), 1000, 500);	// due at 504
+	q.push(make_key_event(997, 'b'), 1000, 500);	// would be due at 501
+
+	TEST_CHECK(!q.pop_due(503, &event));
+	TEST_CHECK(q.pop_due(504, &event));
+	TEST_CHECK_EQUAL(event.key.keysym.sym, 'a');
+	TEST_CHECK(q.pop_due(504, &event));
+	TEST_CHECK_EQUAL(event.key.keysym.sym, 'b');
+}
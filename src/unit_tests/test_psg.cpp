@@ -0,0 +1,206 @@
+#include "stdafx.h"
+
+// Golden-output tests for the programmable sound generators (AY-3-8910 and
+//  SN76496/TMS9919).  Each scenario pokes a fixed register script into the chip
+//  and streams it exactly the way sound::update_buffer() and sound::callback()
+//  do (1 ms slices with the odd larger callback remainder mixed in).
+// The results must match, byte for byte, the .wav files in unit_tests/golden/
+//  which were recorded from the original per-sample implementations.
+// If a golden file is missing, the captured output is written out in its place
+//  (and the test fails) so that a new recording can be reviewed and committed.
+
+static const char *GOLDEN_DIR = "golden/";
+
+// how many milliseconds each scenario runs for
+static const unsigned int PSG_TEST_MS = 400;
+
+// every so often the audio callback drains a bigger chunk than 1 ms
+static const unsigned int PSG_CALLBACK_EVERY_MS = 37;
+static const unsigned int PSG_CALLBACK_BYTES    = 1236;
+
+struct psg_write_s
+{
+	unsigned int uMs;	// when to do the write
+	unsigned int uReg;	// register (ignored for SN76496)
+	unsigned int uVal;	// value
+};
+
+static const psg_write_s g_ayScript[] =
+{
+	{ 0, gisound::ENABLE, 0x38 },	// tones on, noise off
+	{ 0, gisound::CHANNEL_A_TONE_PERIOD_FINE, 0xFE },
+	{ 0, gisound::CHANNEL_A_TONE_PERIOD_COARSE, 0x00 },
+	{ 0, gisound::CHANNEL_B_TONE_PERIOD_FINE, 0x52 },
+	{ 0, gisound::CHANNEL_B_TONE_PERIOD_COARSE, 0x01 },
+	{ 0, gisound::CHANNEL_C_TONE_PERIOD_FINE, 0x10 },
+	{ 0, gisound::CHANNEL_C_TONE_PERIOD_COARSE, 0x03 },
+	{ 0, gisound::CHANNEL_A_AMPLITUDE, 0x0F },
+	{ 0, gisound::CHANNEL_B_AMPLITUDE, 0x0A },
+	{ 0, gisound::CHANNEL_C_AMPLITUDE, 0x06 },
+	{ 30, gisound::CHANNEL_A_TONE_PERIOD_FINE, 0x40 },	// pitch shift mid-period
+	{ 45, gisound::CHANNEL_B_TONE_PERIOD_COARSE, 0x00 },
+	{ 60, gisound::NOISE_PERIOD, 0x0C },
+	{ 60, gisound::ENABLE, 0x20 },	// noise on A and B
+	{ 90, gisound::ENVELOPE_PERIOD_FINE, 0x00 },
+	{ 90, gisound::ENVELOPE_PERIOD_COARSE, 0x04 },
+	{ 90, gisound::ENVELOPE_SHAPE_CYCLE, 0x0E },	// cont, att, alt
+	{ 90, gisound::CHANNEL_C_AMPLITUDE, 0x10 },	// C follows envelope
+	{ 140, gisound::CHANNEL_A_AMPLITUDE, 0x10 },
+	{ 140, gisound::ENVELOPE_SHAPE_CYCLE, 0x0D },	// cont, att, hold
+	{ 140, gisound::ENVELOPE_PERIOD_COARSE, 0x01 },
+	{ 180, gisound::ENVELOPE_SHAPE_CYCLE, 0x00 },	// one-shot decay
+	{ 180, gisound::ENVELOPE_PERIOD_COARSE, 0x02 },
+	{ 210, gisound::CHANNEL_A_TONE_PERIOD_FINE, 0x01 },	// ultrasonic tone
+	{ 210, gisound::CHANNEL_A_TONE_PERIOD_COARSE, 0x00 },
+	{ 210, gisound::CHANNEL_A_AMPLITUDE, 0x0C },
+	{ 250, gisound::NOISE_PERIOD, 0x01 },
+	{ 250, gisound::ENABLE, 0x06 },	// tone A, noise everywhere
+	{ 300, gisound::ENVELOPE_SHAPE_CYCLE, 0x08 },	// saw down, repeating
+	{ 300, gisound::ENVELOPE_PERIOD_FINE, 0x80 },
+	{ 300, gisound::ENVELOPE_PERIOD_COARSE, 0x00 },
+	{ 300, gisound::CHANNEL_B_AMPLITUDE, 0x10 },
+	{ 350, gisound::ENABLE, 0x3F },	// everything off
+};
+
+static const psg_write_s g_snScript[] =
+{
+	{ 0, 0, 0xE5 },	// noise: white, /1024 (differs from the power-on default)
+	{ 0, 0, 0x8E }, { 0, 0, 0x0F },	// tone 0
+	{ 0, 0, 0x90 },	// tone 0 full volume
+	{ 0, 0, 0xA3 }, { 0, 0, 0x1A },	// tone 1
+	{ 0, 0, 0xB4 },	// tone 1 attenuated
+	{ 40, 0, 0xC7 }, { 40, 0, 0x05 },	// tone 2
+	{ 40, 0, 0xD2 },
+	{ 80, 0, 0xF6 },	// noise on
+	{ 120, 0, 0xE3 },	// periodic noise, driven by tone 2
+	{ 150, 0, 0xC1 }, { 150, 0, 0x09 },	// retune tone 2 while it drives noise
+	{ 200, 0, 0x8A }, { 200, 0, 0x00 },	// tone 0 very high
+	{ 240, 0, 0x9F },	// tone 0 off
+	{ 260, 0, 0xE6 },	// white noise, /2048
+	{ 300, 0, 0xBF },	// tone 1 off
+	{ 330, 0, 0xDF },	// tone 2 off
+	{ 370, 0, 0xFF },	// noise off
+};
+
+static void psg_write_wav(const string &strPath, const Uint8 *pBuf, Uint32 uLength)
+{
+	FILE *F = fopen(strPath.c_str(), "wb");
+	if (!F)
+	{
+		return;
+	}
+
+	// canonical 44-byte RIFF header, 44.1 kHz stereo 16-bit
+	Uint8 hdr[44];
+	const Uint32 uFields[] =
+	{
+		0x46464952, 36 + uLength, 0x45564157, 0x20746D66, 16,
+		(2 << 16) | 1, sound::FREQ, sound::FREQ * sound::BYTES_PER_SAMPLE,
+		(16 << 16) | sound::BYTES_PER_SAMPLE, 0x61746164, uLength
+	};
+	for (unsigned int u = 0; u < sizeof(uFields) / sizeof(Uint32); u++)
+	{
+		STORE_LIL_UINT32(hdr + (u * 4), uFields[u]);
+	}
+
+	fwrite(hdr, 1, sizeof(hdr), F);
+	fwrite(pBuf, 1, uLength, F);
+	fclose(F);
+}
+
+// compares a capture against its golden recording (or records it if the golden file doesn't exist yet)
+static void psg_check_golden(const char *szName, const Uint8 *pBuf, Uint32 uLength)
+{
+	string strPath = GOLDEN_DIR;
+	strPath += szName;
+
+	SDL_AudioSpec spec;
+	Uint8 *pGolden = NULL;
+	Uint32 uGoldenLength = 0;
+
+	if (!SDL_LoadWAV(strPath.c_str(), &spec, &pGolden, &uGoldenLength))
+	{
+		psg_write_wav(strPath, pBuf, uLength);
+		TEST_CHECK(pGolden != NULL);
+		return;
+	}
+
+	TEST_CHECK_EQUAL(uGoldenLength, uLength);
+
+	Uint32 uFirstDiff = 0;
+	while ((uFirstDiff < uLength) && (uFirstDiff < uGoldenLength) &&
+		(pGolden[uFirstDiff] == pBuf[uFirstDiff]))
+	{
+		++uFirstDiff;
+	}
+
+	// reports the byte offset of the first mismatch if there is one
+	TEST_CHECK_EQUAL(uFirstDiff, uGoldenLength);
+
+	SDL_FreeWAV(pGolden);
+}
+
+// Streams a scenario the same way the sound mixer would.
+// 'write' pokes one scripted write into the chip, 'stream' renders audio.
+template <class W, class S> static void psg_run(const psg_write_s *pScript, unsigned int uScriptLen,
+	int iChip, W write, S stream, const char *szGolden)
+{
+	const unsigned int uMaxBytes = (PSG_TEST_MS * sound::G_1MS_BUF_SIZE) +
+		((PSG_TEST_MS / PSG_CALLBACK_EVERY_MS) + 1) * PSG_CALLBACK_BYTES;
+	Uint8 *pBuf = new Uint8[uMaxBytes];
+	Uint32 uPos = 0;
+	unsigned int uNext = 0;
+
+	for (unsigned int uMs = 0; uMs < PSG_TEST_MS; uMs++)
+	{
+		while ((uNext < uScriptLen) && (pScript[uNext].uMs == uMs))
+		{
+			write(pScript[uNext].uReg, pScript[uNext].uVal, iChip);
+			++uNext;
+		}
+
+		stream(pBuf + uPos, sound::G_1MS_BUF_SIZE, iChip);
+		uPos += sound::G_1MS_BUF_SIZE;
+
+		if ((uMs % PSG_CALLBACK_EVERY_MS) == (PSG_CALLBACK_EVERY_MS - 1))
+		{
+			stream(pBuf + uPos, PSG_CALLBACK_BYTES, iChip);
+			uPos += PSG_CALLBACK_BYTES;
+		}
+	}
+
+	psg_check_golden(szGolden, pBuf, uPos);
+	delete [] pBuf;
+}
+
+static void ay_write(unsigned int uReg, unsigned int uVal, int iChip)
+{
+	gisound::writedata(uReg, uVal, iChip);
+}
+
+static void sn_write(unsigned int, unsigned int uVal, int iChip)
+{
+	tms9919_writedata((Uint8) uVal, iChip);
+}
+
+TEST_CASE(psg_ay_3_8910)
+{
+	int iChip = gisound::initialize(1789772);
+	TEST_REQUIRE(iChip >= 0);
+
+	psg_run(g_ayScript, sizeof(g_ayScript) / sizeof(psg_write_s), iChip,
+		ay_write, gisound::stream, "ay_3_8910.wav");
+
+	gisound::shutdown(iChip);
+}
+
+TEST_CASE(psg_sn76496)
+{
+	int iChip = tms9919_initialize(3579545);
+	TEST_REQUIRE(iChip >= 0);
+
+	psg_run(g_snScript, sizeof(g_snScript) / sizeof(psg_write_s), iChip,
+		sn_write, tms9919_stream, "sn76496.wav");
+
+	tms9919_shutdown(iChip);
+}
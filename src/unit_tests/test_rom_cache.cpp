@@ -0,0 +1,135 @@
+#include "stdafx.h"
+#include <zlib.h>
+#include <stdio.h>
+
+// Tests for the ROM cache.  Any file can stand in for the .zip, since only its
+//  path, size and time are looked at.  The benchmark compares inflating and
+//  checksumming a ROM set (what a cold start does for every image) with
+//  copying it out of the cache.
+
+static const char *ROM_CACHE_TEST_ZIP = "test_rom_cache.zip";
+
+static void write_file(const char *path, const char *text)
+{
+	FILE *F = fopen(path, "wb");
+	fwrite(text, strlen(text), 1, F);
+	fclose(F);
+}
+
+static vector<Uint8> make_image(Uint32 uSize, Uint32 uSeed)
+{
+	vector<Uint8> v(uSize);
+	for (Uint32 u = 0; u < uSize; u++) {
+		// compressible, like most ROMs
+		uSeed = (uSeed * 1103515245) + 12345;
+		v[u] = (Uint8) (((uSeed >> 16) & 7) | (u & 0xF0));
+	}
+	return v;
+}
+
+TEST_CASE(rom_cache_roundtrip)
+{
+	vector<Uint8> vA = make_image(4096, 1), vB = make_image(8192, 2);
+	Uint8 buf[8192];
+	Uint32 uCRC = 0;
+
+	write_file(ROM_CACHE_TEST_ZIP, "not really a zip");
+	{
+		RomCache cache(".");
+		remove(cache.GetCachePath(ROM_CACHE_TEST_ZIP).c_str());
+
+		cache.Open(ROM_CACHE_TEST_ZIP);
+		TEST_CHECK(!cache.Load("a.bin", buf, 4096, uCRC));
+		cache.Add("a.bin", &vA[0], 4096, 0x1234);
+		cache.Add("b.bin", &vB[0], 8192, 0x5678);
+		cache.Close();
+
+		cache.Open(ROM_CACHE_TEST_ZIP);
+		TEST_CHECK(cache.Load("A.BIN", buf, 4096, uCRC));
+		TEST_CHECK_EQUAL(uCRC, 0x1234u);
+		TEST_CHECK(memcmp(buf, &vA[0], 4096) == 0);
+		TEST_CHECK(cache.Load("b.bin", buf, 8192, uCRC));
+		TEST_CHECK_EQUAL(uCRC, 0x5678u);
+		TEST_CHECK(memcmp(buf, &vB[0], 8192) == 0);
+
+		// the wrong size is as good as missing
+		TEST_CHECK(!cache.Load("b.bin", buf, 4096, uCRC));
+
+		// adding to a cache keeps what was in it
+		cache.Add("c.bin", &vA[0], 100, 0x9ABC);
+		cache.Close();
+		cache.Open(ROM_CACHE_TEST_ZIP);
+		TEST_CHECK(cache.Load("a.bin", buf, 4096, uCRC));
+		TEST_CHECK(cache.Load("c.bin", buf, 100, uCRC));
+		TEST_CHECK_EQUAL(uCRC, 0x9ABCu);
+		cache.Close();
+
+		// a different .zip throws the cache out
+		write_file(ROM_CACHE_TEST_ZIP, "not really a zip either");
+		cache.Open(ROM_CACHE_TEST_ZIP);
+		TEST_CHECK(!cache.Load("a.bin", buf, 4096, uCRC));
+		cache.Close();
+
+		remove(cache.GetCachePath(ROM_CACHE_TEST_ZIP).c_str());
+	}
+	remove(ROM_CACHE_TEST_ZIP);
+}
+
+// reports how long a ROM set takes to load with and without the cache
+TEST_CASE(rom_cache_benchmark)
+{
+	static const unsigned int ROMS = 32;
+	static const Uint32 ROM_SIZE = 65536;
+	vector<vector<Uint8> > vCompressed(ROMS);
+	vector<Uint8> vMem(ROMS * ROM_SIZE);
+	char name[32];
+
+	write_file(ROM_CACHE_TEST_ZIP, "stand-in");
+
+	for (unsigned int i = 0; i < ROMS; i++) {
+		vector<Uint8> vImage = make_image(ROM_SIZE, i);
+		uLongf uLen = compressBound(ROM_SIZE);
+		vCompressed[i].resize(uLen);
+		compress(&vCompressed[i][0], &uLen, &vImage[0], ROM_SIZE);
+		vCompressed[i].resize(uLen);
+	}
+
+	RomCache cache(".");
+	remove(cache.GetCachePath(ROM_CACHE_TEST_ZIP).c_str());
+
+	// cold: inflate, checksum and fill the cache
+	Uint32 uStartMs = SDL_GetTicks();
+	cache.Open(ROM_CACHE_TEST_ZIP);
+	for (unsigned int i = 0; i < ROMS; i++) {
+		uLongf uLen = ROM_SIZE;
+		Uint8 *pBuf = &vMem[i * ROM_SIZE];
+		uncompress(pBuf, &uLen, &vCompressed[i][0], (uLong) vCompressed[i].size());
+		Uint32 uCRC = crc32(crc32(0L, Z_NULL, 0), pBuf, ROM_SIZE);
+		snprintf(name, sizeof(name), "rom%u.bin", i);
+		cache.Add(name, pBuf, ROM_SIZE, uCRC);
+	}
+	cache.Close();
+	Uint32 uColdMs = SDL_GetTicks() - uStartMs;
+
+	vector<Uint8> vWarm(ROMS * ROM_SIZE);
+	bool bAll = true;
+	uStartMs = SDL_GetTicks();
+	cache.Open(ROM_CACHE_TEST_ZIP);
+	for (unsigned int i = 0; i < ROMS; i++) {
+		Uint32 uCRC = 0;
+		snprintf(name, sizeof(name), "rom%u.bin", i);
+		if (!cache.Load(name, &vWarm[i * ROM_SIZE], ROM_SIZE, uCRC)) bAll = false;
+	}
+	cache.Close();
+	Uint32 uWarmMs = SDL_GetTicks() - uStartMs;
+
+	TEST_CHECK(bAll);
+	TEST_CHECK(vWarm == vMem);
+
+	cout << "rom_cache_benchmark: " << ROMS << " ROMs of " << ROM_SIZE << " bytes" << endl;
+	cout << "  cold (inflate, CRC, write cache): " << uColdMs << " ms" << endl;
+	cout << "  warm (from the cache):            " << uWarmMs << " ms" << endl;
+
+	remove(cache.GetCachePath(ROM_CACHE_TEST_ZIP).c_str());
+	remove(ROM_CACHE_TEST_ZIP);
+}
@@ -0,0 +1,138 @@
+#include "stdafx.h"
+
+// Tests for the USB scoreboard writer, using a fake serial device that can be
+//  made as slow as a real one.
+
+class FakeUSBDevice : public USBWriter::IDevice
+{
+public:
+	FakeUSBDevice(unsigned int uDelayMs) : m_uDelayMs(uDelayMs), m_uWrites(0)
+	{
+		m_mutex = SDL_CreateMutex();
+	}
+
+	~FakeUSBDevice()
+	{
+		SDL_DestroyMutex(m_mutex);
+	}
+
+	bool write(const void *pBuf, unsigned int uLen)
+	{
+		// pretend the port is slow
+		if (m_uDelayMs) SDL_Delay(m_uDelayMs);
+
+		SDL_LockMutex(m_mutex);
+		const Uint8 *p = (const Uint8 *) pBuf;
+		m_vBytes.insert(m_vBytes.end(), p, p + uLen);
+		m_uWrites++;
+		SDL_UnlockMutex(m_mutex);
+		return true;
+	}
+
+	vector<Uint8> GetBytes()
+	{
+		SDL_LockMutex(m_mutex);
+		vector<Uint8> v = m_vBytes;
+		SDL_UnlockMutex(m_mutex);
+		return v;
+	}
+
+	unsigned int GetWrites()
+	{
+		SDL_LockMutex(m_mutex);
+		unsigned int u = m_uWrites;
+		SDL_UnlockMutex(m_mutex);
+		return u;
+	}
+
+private:
+	unsigned int m_uDelayMs;
+	SDL_mutex *m_mutex;
+	vector<Uint8> m_vBytes;
+	unsigned int m_uWrites;
+};
+
+static DigitStruct make_digit(char unit, char digit, char value)
+{
+	DigitStruct ds;
+	ds.unit = unit;
+	ds.digit = digit;
+	ds.value = value;
+	return ds;
+}
+
+// a slow device must not hold up the caller
+TEST_CASE(usb_writer_nonblocking)
+{
+	FakeUSBDevice dev(50);
+	USBWriter writer;
+	writer.Start(&dev, 1);
+
+	Uint32 uStart = SDL_GetTicks();
+	for (unsigned int u = 0; u < 100; u++) {
+		writer.Queue(make_digit(SCOREBOARD, (char) (u % 12), (char) ASCI(u % 10)));
+		SDL_Delay(1);
+	}
+	Uint32 uElapsed = SDL_GetTicks() - uStart;
+
+	// writing synchronously would have taken 100 * 50 ms
+	TEST_CHECK(uElapsed < 1000);
+
+	writer.Stop();
+	TEST_CHECK(dev.GetWrites() < 100);
+}
+
+// only the last value of a digit gets sent, and all changes go out in one write
+TEST_CASE(usb_writer_coalesce)
+{
+	FakeUSBDevice dev(0);
+	USBWriter writer;
+	writer.Start(&dev, 200);
+
+	writer.Queue(make_digit(SCOREBOARD, 3, ASCI(1)));
+	writer.Queue(make_digit(SCOREBOARD, 1, ASCI(2)));
+	writer.Queue(make_digit(SCOREBOARD, 3, ASCI(4)));
+	writer.Queue(make_digit(ANNUNCIATOR, ANNUNCIATOR, ASCI(7)));
+
+	writer.Stop();
+
+	vector<Uint8> v = dev.GetBytes();
+	TEST_REQUIRE(v.size() == 3 * sizeof(DigitStruct));
+	TEST_CHECK_EQUAL(dev.GetWrites(), 1);
+	TEST_CHECK_EQUAL(writer.GetDroppedCount(), 1);
+
+	// in the order the digits first changed, with the latest value
+	TEST_CHECK_EQUAL(v[0], SCOREBOARD);
+	TEST_CHECK_EQUAL(v[1], 3);
+	TEST_CHECK_EQUAL(v[2], ASCI(4));
+	TEST_CHECK_EQUAL(v[3], SCOREBOARD);
+	TEST_CHECK_EQUAL(v[4], 1);
+	TEST_CHECK_EQUAL(v[5], ASCI(2));
+	TEST_CHECK_EQUAL(v[6], ANNUNCIATOR);
+	TEST_CHECK_EQUAL(v[7], ANNUNCIATOR);
+	TEST_CHECK_EQUAL(v[8], ASCI(7));
+}
+
+// digits the device is already showing aren't sent again
+TEST_CASE(usb_writer_unchanged)
+{
+	FakeUSBDevice dev(0);
+	USBWriter writer;
+	writer.Start(&dev, 1);
+
+	writer.Queue(make_digit(SCOREBOARD, 0, ASCI(5)));
+	SDL_Delay(100);
+	TEST_CHECK_EQUAL(dev.GetWrites(), 1);
+
+	writer.Queue(make_digit(SCOREBOARD, 0, ASCI(5)));
+	SDL_Delay(100);
+	TEST_CHECK_EQUAL(dev.GetWrites(), 1);
+
+	writer.Queue(make_digit(SCOREBOARD, 0, ASCI(6)));
+	writer.Stop();
+
+	vector<Uint8> v = dev.GetBytes();
+	TEST_REQUIRE(v.size() == 2 * sizeof(DigitStruct));
+	TEST_CHECK_EQUAL(v[2], ASCI(5));
+	TEST_CHECK_EQUAL(v[5], ASCI(6));
+}
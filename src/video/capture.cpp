@@ -0,0 +1,318 @@
+/*
+ * ____ HYPSEUS COPYRIGHT NOTICE ____
+ *
+ * Copyright (C) 2026 Hypseus Singe contributors
+ *
+ * This file is part of HYPSEUS SINGE, a laserdisc arcade game emulator
+ *
+ * HYPSEUS SINGE is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * HYPSEUS SINGE is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "config.h"
+
+#include <stdio.h>
+#include <list>
+#include <string>
+#include <vector>
+#include <SDL_image.h>
+#include <plog/Log.h>
+#include "../io/conout.h"
+#include "../io/mpo_fileio.h"
+#include "capture.h"
+#include "video.h" // for PATH_SEPARATOR
+
+using namespace std;
+
+namespace capture
+{
+
+// how many sequence frames may be waiting to be written at once
+static const unsigned int POOL_SIZE = 4;
+
+struct job_s {
+    SDL_Surface *pSurface;
+    bool bScreenshot;
+    unsigned int uNumber; // sequence frame number
+};
+
+SDL_mutex *g_mutex = NULL; // guards everything down to g_bQuit
+SDL_cond *g_cond = NULL;   // signalled when g_lstJobs changes
+list<job_s> g_lstJobs;
+vector<SDL_Surface *> g_vFree; // buffers that have been written out
+unsigned int g_uBusy = 0;      // buffers handed out and not yet written
+bool g_bQuit = false;
+
+SDL_Thread *g_thread = NULL;
+bool g_bStartFailed = false; // write on the render thread instead
+
+string g_strDir;
+unsigned int g_uEvery = 0; // 0 when no sequence is being captured
+bool g_bRaw = false;
+unsigned int g_uFrame   = 0; // presented frames
+unsigned int g_uSaved   = 0; // sequence frames handed to the worker
+unsigned int g_uDropped = 0; // sequence frames skipped, the worker was behind
+
+int g_iNextShot = 1; // where to start looking for a free screenshot name
+
+static void write_screenshot(SDL_Surface *pSurface)
+{
+    char filename[64];
+
+    // the numbers only go up during a session, so don't probe from 1 every time
+    for (;;) {
+        snprintf(filename, sizeof(filename), "screenshots%shypseus-%d.png",
+                 PATH_SEPARATOR, g_iNextShot++);
+
+        if (!mpo_file_exists(filename))
+            break;
+    }
+
+    if (IMG_SavePNG(pSurface, filename) == 0) {
+        LOGI << fmt("Wrote screenshot: %s", filename);
+    } else {
+        LOGE << fmt("Could not write screenshot: %s !!", filename);
+    }
+}
+
+static void write_sequence_frame(SDL_Surface *pSurface, unsigned int uNumber)
+{
+    char filename[512];
+
+    if (!g_bRaw) {
+        snprintf(filename, sizeof(filename), "%s%sframe-%06u.png",
+                 g_strDir.c_str(), PATH_SEPARATOR, uNumber);
+
+        if (IMG_SavePNG(pSurface, filename) != 0) {
+            LOGE << fmt("Could not write %s", filename);
+        }
+        return;
+    }
+
+    snprintf(filename, sizeof(filename), "%s%sframe-%06u-%dx%d.raw",
+             g_strDir.c_str(), PATH_SEPARATOR, uNumber, pSurface->w,
+             pSurface->h);
+
+    FILE *F = fopen(filename, "wb");
+    if (!F) {
+        LOGE << fmt("Could not create %s", filename);
+        return;
+    }
+
+    // rows without the pitch padding
+    const Uint8 *pRow = (const Uint8 *)pSurface->pixels;
+    for (int y = 0; y < pSurface->h; y++, pRow += pSurface->pitch) {
+        fwrite(pRow, 4, pSurface->w, F);
+    }
+    fclose(F);
+}
+
+static void write_job(const job_s &job)
+{
+    if (job.bScreenshot) {
+        write_screenshot(job.pSurface);
+    } else {
+        write_sequence_frame(job.pSurface, job.uNumber);
+    }
+}
+
+// (g_mutex must be held)
+static void release_buffer(SDL_Surface *pSurface)
+{
+    g_vFree.push_back(pSurface);
+    g_uBusy--;
+}
+
+static int capture_thread(void *)
+{
+    SDL_LockMutex(g_mutex);
+    while (!g_bQuit || !g_lstJobs.empty()) {
+        if (g_lstJobs.empty()) {
+            SDL_CondWait(g_cond, g_mutex);
+            continue;
+        }
+
+        job_s job = g_lstJobs.front();
+        g_lstJobs.pop_front();
+
+        // encoding is the slow part, don't hold up get_buffer() meanwhile
+        SDL_UnlockMutex(g_mutex);
+        write_job(job);
+        SDL_LockMutex(g_mutex);
+
+        release_buffer(job.pSurface);
+    }
+    SDL_UnlockMutex(g_mutex);
+
+    return 0;
+}
+
+static bool start()
+{
+    if (g_thread) return true;
+    if (g_bStartFailed) return false;
+
+    g_mutex = SDL_CreateMutex();
+    g_cond  = SDL_CreateCond();
+    if (g_mutex && g_cond) {
+        g_bQuit = false;
+        g_thread = SDL_CreateThread(capture_thread, "capture", NULL);
+    }
+
+    if (!g_thread) {
+        LOGW << "Could not start the capture thread, frames will be written "
+                "as they are taken";
+        g_bStartFailed = true;
+    }
+
+    return (g_thread != NULL);
+}
+
+static void submit(SDL_Surface *pSurface, bool bScreenshot)
+{
+    job_s job;
+    job.pSurface    = pSurface;
+    job.bScreenshot = bScreenshot;
+    job.uNumber     = bScreenshot ? 0 : g_uSaved++;
+
+    if (!g_thread) {
+        write_job(job);
+        SDL_FreeSurface(pSurface);
+        return;
+    }
+
+    SDL_LockMutex(g_mutex);
+    g_lstJobs.push_back(job);
+    SDL_CondSignal(g_cond);
+    SDL_UnlockMutex(g_mutex);
+}
+
+bool set_sequence(const char *pszDir, unsigned int uEvery, bool bRaw)
+{
+    // fails if it's already there, which is fine
+    mpo_mkdir(pszDir);
+
+    // rather than finding out on every frame that nothing can be written
+    string strProbe = string(pszDir) + PATH_SEPARATOR + ".hypseus-capture";
+    FILE *F = fopen(strProbe.c_str(), "wb");
+    if (!F) return false;
+    fclose(F);
+    remove(strProbe.c_str());
+
+    g_strDir = pszDir;
+    g_uEvery = uEvery;
+    g_bRaw   = bRaw;
+    g_uFrame = 0;
+    return true;
+}
+
+bool sequence_frame_due()
+{
+    if (g_uEvery == 0) return false;
+
+    return ((g_uFrame++ % g_uEvery) == 0);
+}
+
+SDL_Surface *get_buffer(int w, int h, bool bScreenshot)
+{
+    SDL_Surface *pResult = NULL;
+    SDL_Surface *pStale = NULL;
+
+    if (!start()) {
+        return SDL_CreateRGBSurface(0, w, h, 32, 0, 0, 0, 0);
+    }
+
+    SDL_LockMutex(g_mutex);
+    if (!bScreenshot && (g_uBusy >= POOL_SIZE)) {
+        SDL_UnlockMutex(g_mutex);
+        g_uDropped++;
+        return NULL;
+    }
+
+    for (size_t i = 0; i < g_vFree.size(); i++) {
+        if ((g_vFree[i]->w == w) && (g_vFree[i]->h == h)) {
+            pResult = g_vFree[i];
+            g_vFree.erase(g_vFree.begin() + i);
+            break;
+        }
+    }
+
+    // the window was resized, this one won't be any use again
+    if (!pResult && !g_vFree.empty()) {
+        pStale = g_vFree.back();
+        g_vFree.pop_back();
+    }
+    g_uBusy++;
+    SDL_UnlockMutex(g_mutex);
+
+    if (pStale) SDL_FreeSurface(pStale);
+
+    if (!pResult) {
+        pResult = SDL_CreateRGBSurface(0, w, h, 32, 0, 0, 0, 0);
+
+        if (!pResult) {
+            SDL_LockMutex(g_mutex);
+            g_uBusy--;
+            SDL_UnlockMutex(g_mutex);
+        }
+    }
+
+    return pResult;
+}
+
+void submit_screenshot(SDL_Surface *pSurface)
+{
+    submit(pSurface, true);
+}
+
+void submit_sequence_frame(SDL_Surface *pSurface)
+{
+    submit(pSurface, false);
+}
+
+void shutdown()
+{
+    if (g_thread) {
+        SDL_LockMutex(g_mutex);
+        g_bQuit = true;
+        SDL_CondSignal(g_cond);
+        SDL_UnlockMutex(g_mutex);
+        SDL_WaitThread(g_thread, NULL);
+        g_thread = NULL;
+    }
+
+    for (size_t i = 0; i < g_vFree.size(); i++) {
+        SDL_FreeSurface(g_vFree[i]);
+    }
+    g_vFree.clear();
+    g_uBusy = 0;
+
+    if (g_cond) {
+        SDL_DestroyCond(g_cond);
+        g_cond = NULL;
+    }
+
+    if (g_mutex) {
+        SDL_DestroyMutex(g_mutex);
+        g_mutex = NULL;
+    }
+
+    if (g_uEvery) {
+        LOGI << fmt("Captured %u frames to %s (%u dropped)", g_uSaved,
+                    g_strDir.c_str(), g_uDropped);
+        g_uEvery = 0;
+    }
+}
+
+}
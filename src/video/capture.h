@@ -0,0 +1,59 @@
+/*
+ * ____ HYPSEUS COPYRIGHT NOTICE ____
+ *
+ * Copyright (C) 2026 Hypseus Singe contributors
+ *
+ * This file is part of HYPSEUS SINGE, a laserdisc arcade game emulator
+ *
+ * HYPSEUS SINGE is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * HYPSEUS SINGE is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef CAPTURE_H
+#define CAPTURE_H
+
+// Writes screenshots and frame sequences on a worker thread so that the
+//  render thread only has to read the pixels back.
+// The render thread gets a surface from the pool with get_buffer(), fills it
+//  and hands it over with submit_*(); the worker picks a file name, encodes
+//  it and returns the surface to the pool.
+
+#include <SDL.h>
+
+namespace capture
+{
+
+// Starts saving every 'uEvery'th presented frame into 'pszDir', as PNG or
+//  (if bRaw) as the bare 32-bit pixels, with the size in the file name.
+// The directory is created if needed.  Returns false if it can't be written.
+bool set_sequence(const char *pszDir, unsigned int uEvery, bool bRaw);
+
+// Call once per presented frame.  True if this one belongs to the sequence.
+bool sequence_frame_due();
+
+// A 32-bit surface of the given size from the pool.  For a screenshot it
+//  never fails for lack of free buffers.  For a sequence frame it returns NULL
+//  when the worker is behind, and that frame is dropped rather than waited for.
+SDL_Surface *get_buffer(int w, int h, bool bScreenshot);
+
+// Hands a buffer from get_buffer() to the worker.
+void submit_screenshot(SDL_Surface *pSurface);
+void submit_sequence_frame(SDL_Surface *pSurface);
+
+// Waits for everything queued to be written, then stops the worker.
+void shutdown();
+
+}
+
+#endif // CAPTURE_H
@@ -0,0 +1,393 @@
+/*
+ * ____ HYPSEUS COPYRIGHT NOTICE ____
+ *
+ * Copyright (C) 2026 Hypseus Singe contributors
+ *
+ * This file is part of HYPSEUS SINGE, a laserdisc arcade game emulator
+ *
+ * HYPSEUS SINGE is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * HYPSEUS SINGE is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "config.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <vector>
+#include <SDL_image.h>
+#include <plog/Log.h>
+#include "../hypseus.h"
+#include "../game/game.h"
+#include "../io/conout.h"
+#include "../io/mpo_fileio.h"
+#include "../ldp-out/ldp-vldp.h"
+#include "golden.h"
+#include "video.h"
+
+using namespace std;
+
+namespace golden
+{
+
+// VLDP runs on its own thread, so give it a moment to show the frame that
+//  belongs to the checkpoint (emulated time stands still meanwhile)
+static const unsigned int SETTLE_POLL_MS    = 5;
+static const unsigned int SETTLE_POLLS      = 10; // polls without a new frame
+static const unsigned int SETTLE_TIMEOUT_MS = 2000;
+
+struct image_result_s {
+    string strStatus; // none, recorded, match, differs, size differs or error
+    Uint64 u64Hash;
+    int iWidth, iHeight;
+    unsigned int uDiffPixels;
+};
+
+struct checkpoint_s {
+    unsigned int uMs;
+    string strName;
+    bool bReached;
+    unsigned int uVldpFrame;
+    bool bVideoSettled;
+    image_result_s overlay;
+    image_result_s video;
+    // since the previous checkpoint
+    Uint64 u64BlitCount, u64BlitTotalNs, u64BlitMaxNs;
+};
+
+vector<checkpoint_s> g_vCheckpoints;
+size_t g_uNext = 0;
+string g_strDir;
+string g_strReportPath = "golden.json";
+bool g_bEnabled = false;
+
+Uint64 g_u64BlitCount = 0, g_u64BlitTotalNs = 0, g_u64BlitMaxNs = 0;
+
+// FNV-1a over the pixels (not the pitch padding)
+static Uint64 hash_surface(const SDL_Surface *pSurface)
+{
+    Uint64 u64Hash = 0xCBF29CE484222325ULL;
+    const Uint8 *pRow = (const Uint8 *)pSurface->pixels;
+    int iRowBytes = pSurface->w * pSurface->format->BytesPerPixel;
+
+    for (int y = 0; y < pSurface->h; y++, pRow += pSurface->pitch) {
+        for (int x = 0; x < iRowBytes; x++) {
+            u64Hash ^= pRow[x];
+            u64Hash *= 0x100000001B3ULL;
+        }
+    }
+
+    return u64Hash;
+}
+
+static unsigned int count_diff_pixels(const SDL_Surface *pA,
+                                      const SDL_Surface *pB)
+{
+    unsigned int uResult = 0;
+
+    for (int y = 0; y < pA->h; y++) {
+        const Uint32 *pRowA =
+            (const Uint32 *)((const Uint8 *)pA->pixels + y * pA->pitch);
+        const Uint32 *pRowB =
+            (const Uint32 *)((const Uint8 *)pB->pixels + y * pB->pitch);
+        for (int x = 0; x < pA->w; x++) {
+            if (pRowA[x] != pRowB[x]) uResult++;
+        }
+    }
+
+    return uResult;
+}
+
+// Compares 'pSurface' with <dir>/<name>.png, recording it if it isn't there.
+static void check_image(SDL_Surface *pSurface, const string &strName,
+                        image_result_s &result)
+{
+    // (this also copies the overlay, which the game keeps drawing into)
+    SDL_Surface *pActual =
+        SDL_ConvertSurfaceFormat(pSurface, SDL_PIXELFORMAT_ARGB8888, 0);
+
+    if (!pActual) {
+        result.strStatus = "error";
+        return;
+    }
+
+    string strPath = g_strDir + PATH_SEPARATOR + strName + ".png";
+    result.u64Hash = hash_surface(pActual);
+    result.iWidth  = pActual->w;
+    result.iHeight = pActual->h;
+
+    if (!mpo_file_exists(strPath.c_str())) {
+        if (IMG_SavePNG(pActual, strPath.c_str()) == 0) {
+            result.strStatus = "recorded";
+            LOGI << fmt("Recorded golden image %s", strPath.c_str());
+        } else {
+            result.strStatus = "error";
+            LOGE << fmt("Could not write golden image %s", strPath.c_str());
+        }
+        SDL_FreeSurface(pActual);
+        return;
+    }
+
+    SDL_Surface *pLoaded = IMG_Load(strPath.c_str());
+    SDL_Surface *pGolden =
+        pLoaded ? SDL_ConvertSurfaceFormat(pLoaded, SDL_PIXELFORMAT_ARGB8888, 0)
+                : NULL;
+    if (pLoaded) SDL_FreeSurface(pLoaded);
+
+    if (!pGolden) {
+        result.strStatus = "error";
+        LOGE << fmt("Could not load golden image %s", strPath.c_str());
+    } else if ((pGolden->w != pActual->w) || (pGolden->h != pActual->h)) {
+        result.strStatus = "size differs";
+    } else {
+        result.uDiffPixels = count_diff_pixels(pGolden, pActual);
+        result.strStatus   = result.uDiffPixels ? "differs" : "match";
+    }
+
+    // keep what we got so it can be looked at
+    if (result.strStatus != "match") {
+        string strActual = g_strDir + PATH_SEPARATOR + strName + ".actual.png";
+        IMG_SavePNG(pActual, strActual.c_str());
+        LOGW << fmt("%s does not match its golden image (%s), saved %s",
+                    strName.c_str(), result.strStatus.c_str(),
+                    strActual.c_str());
+    }
+
+    if (pGolden) SDL_FreeSurface(pGolden);
+    SDL_FreeSurface(pActual);
+}
+
+// waits until VLDP has stopped moving, returns false if it never did
+static bool wait_for_vldp(unsigned int &uFrame)
+{
+    ldp_vldp *pVldp = dynamic_cast<ldp_vldp *>(g_ldp);
+    unsigned int uStable = 0;
+    unsigned int uWaited = 0;
+
+    if (!pVldp || !pVldp->get_vldp_frame(uFrame)) return true;
+
+    while (uStable < SETTLE_POLLS) {
+        if (uWaited >= SETTLE_TIMEOUT_MS) return false;
+
+        SDL_Delay(SETTLE_POLL_MS);
+        uWaited += SETTLE_POLL_MS;
+
+        unsigned int uNow = 0;
+        pVldp->get_vldp_frame(uNow);
+        if (uNow == uFrame) {
+            uStable++;
+        } else {
+            uFrame = uNow;
+            uStable = 0;
+        }
+    }
+
+    return true;
+}
+
+static void check(checkpoint_s &cp)
+{
+    cp.bReached       = true;
+    cp.u64BlitCount   = g_u64BlitCount;
+    cp.u64BlitTotalNs = g_u64BlitTotalNs;
+    cp.u64BlitMaxNs   = g_u64BlitMaxNs;
+    g_u64BlitCount = g_u64BlitTotalNs = g_u64BlitMaxNs = 0;
+
+    cp.bVideoSettled = wait_for_vldp(cp.uVldpFrame);
+    if (!cp.bVideoSettled) {
+        LOGW << fmt("VLDP did not settle for checkpoint %s",
+                    cp.strName.c_str());
+    }
+
+    SDL_Surface *pOverlay = g_game->get_finished_video_overlay();
+    if (pOverlay) {
+        check_image(pOverlay, cp.strName + "-overlay", cp.overlay);
+    }
+
+    SDL_Surface *pVideo = video::vid_copy_yuv_frame();
+    if (pVideo) {
+        check_image(pVideo, cp.strName + "-video", cp.video);
+        SDL_FreeSurface(pVideo);
+    }
+}
+
+bool start(const char *pszCheckpoints, const char *pszDir)
+{
+    FILE *F = fopen(pszCheckpoints, "rt");
+    char szLine[256];
+
+    if (!F) {
+        LOGE << fmt("Could not open golden checkpoints %s", pszCheckpoints);
+        return false;
+    }
+
+    g_vCheckpoints.clear();
+    while (fgets(szLine, sizeof(szLine), F)) {
+        char szName[128] = {0};
+        unsigned int uMs = 0;
+
+        if (szLine[0] == '#') continue;
+        int iFields = sscanf(szLine, "%u %127s", &uMs, szName);
+        if (iFields < 1) continue;
+
+        checkpoint_s cp;
+        cp.uMs = uMs;
+        if (iFields > 1) {
+            cp.strName = szName;
+        } else {
+            snprintf(szName, sizeof(szName), "%u", uMs);
+            cp.strName = szName;
+        }
+        cp.bReached            = false;
+        cp.uVldpFrame          = 0;
+        cp.bVideoSettled       = false;
+        cp.overlay.strStatus   = cp.video.strStatus = "none";
+        cp.overlay.u64Hash     = cp.video.u64Hash = 0;
+        cp.overlay.iWidth      = cp.overlay.iHeight = 0;
+        cp.video.iWidth        = cp.video.iHeight = 0;
+        cp.overlay.uDiffPixels = cp.video.uDiffPixels = 0;
+        cp.u64BlitCount = cp.u64BlitTotalNs = cp.u64BlitMaxNs = 0;
+
+        // keep them in order, the file might not be
+        vector<checkpoint_s>::iterator i = g_vCheckpoints.begin();
+        while ((i != g_vCheckpoints.end()) && (i->uMs <= uMs)) ++i;
+        g_vCheckpoints.insert(i, cp);
+    }
+    fclose(F);
+
+    if (g_vCheckpoints.empty()) {
+        LOGE << fmt("No checkpoints in %s", pszCheckpoints);
+        return false;
+    }
+
+    g_strDir   = pszDir;
+    g_uNext    = 0;
+    g_bEnabled = true;
+    LOGI << fmt("Checking %u golden frames against %s",
+                (unsigned int)g_vCheckpoints.size(), pszDir);
+    return true;
+}
+
+bool is_enabled()
+{
+    return g_bEnabled;
+}
+
+void set_report_path(const char *pszReportPath)
+{
+    g_strReportPath = pszReportPath;
+}
+
+void think(unsigned int uMs)
+{
+    if (!g_bEnabled || (g_uNext >= g_vCheckpoints.size())) return;
+
+    while ((g_uNext < g_vCheckpoints.size()) &&
+           (g_vCheckpoints[g_uNext].uMs <= uMs)) {
+        check(g_vCheckpoints[g_uNext++]);
+    }
+
+    // nothing left to look at
+    if (g_uNext == g_vCheckpoints.size()) {
+        set_quitflag();
+    }
+}
+
+void add_blit_ns(Uint64 u64Ns)
+{
+    if (!g_bEnabled) return;
+
+    g_u64BlitCount++;
+    g_u64BlitTotalNs += u64Ns;
+    if (u64Ns > g_u64BlitMaxNs) g_u64BlitMaxNs = u64Ns;
+}
+
+static bool result_ok(const image_result_s &result)
+{
+    return (result.strStatus == "none") || (result.strStatus == "recorded") ||
+           (result.strStatus == "match");
+}
+
+static void write_image_result(FILE *F, const char *pszName,
+                               const image_result_s &result)
+{
+    fprintf(F, "\"%s\": { \"status\": \"%s\", \"hash\": \"%016llx\", "
+               "\"w\": %d, \"h\": %d, \"diff_pixels\": %u }",
+            pszName, result.strStatus.c_str(),
+            (unsigned long long)result.u64Hash, result.iWidth, result.iHeight,
+            result.uDiffPixels);
+}
+
+bool write_report(const char *pszGameName)
+{
+    bool bPassed = true;
+    unsigned int uFailed = 0;
+
+    for (size_t u = 0; u < g_vCheckpoints.size(); u++) {
+        const checkpoint_s &cp = g_vCheckpoints[u];
+        if (!cp.bReached || !result_ok(cp.overlay) || !result_ok(cp.video)) {
+            bPassed = false;
+            uFailed++;
+        }
+    }
+
+    FILE *F = fopen(g_strReportPath.c_str(), "wt");
+    if (!F) {
+        LOGW << fmt("Could not write golden report to %s",
+                    g_strReportPath.c_str());
+        return bPassed;
+    }
+
+    fprintf(F, "{\n");
+    fprintf(F, "  \"game\": \"%s\",\n", pszGameName);
+    fprintf(F, "  \"passed\": %s,\n", bPassed ? "true" : "false");
+    fprintf(F, "  \"checkpoints\": [");
+    for (size_t u = 0; u < g_vCheckpoints.size(); u++) {
+        const checkpoint_s &cp = g_vCheckpoints[u];
+
+        fprintf(F, "%s\n    { \"name\": \"%s\", \"ms\": %u, \"reached\": %s, "
+                   "\"vldp_frame\": %u, \"video_settled\": %s,\n      ",
+                (u != 0) ? "," : "", cp.strName.c_str(), cp.uMs,
+                cp.bReached ? "true" : "false", cp.uVldpFrame,
+                cp.bVideoSettled ? "true" : "false");
+        write_image_result(F, "overlay", cp.overlay);
+        fprintf(F, ",\n      ");
+        write_image_result(F, "video", cp.video);
+        Uint64 u64AvgNs =
+            cp.u64BlitCount ? (cp.u64BlitTotalNs / cp.u64BlitCount) : 0;
+        fprintf(F, ",\n      \"blit\": { \"count\": %llu, \"avg_ns\": %llu, "
+                   "\"max_ns\": %llu } }",
+                (unsigned long long)cp.u64BlitCount,
+                (unsigned long long)u64AvgNs,
+                (unsigned long long)cp.u64BlitMaxNs);
+    }
+    fprintf(F, "%s]\n", g_vCheckpoints.empty() ? "" : "\n  ");
+    fprintf(F, "}\n");
+    fclose(F);
+
+    if (bPassed) {
+        LOGI << fmt("All %u golden checkpoints passed, report written to %s",
+                    (unsigned int)g_vCheckpoints.size(),
+                    g_strReportPath.c_str());
+    } else {
+        LOGE << fmt("%u of %u golden checkpoints failed, see %s", uFailed,
+                    (unsigned int)g_vCheckpoints.size(),
+                    g_strReportPath.c_str());
+    }
+
+    return bPassed;
+}
+
+}
@@ -0,0 +1,69 @@
+/*
+ * ____ HYPSEUS COPYRIGHT NOTICE ____
+ *
+ * Copyright (C) 2026 Hypseus Singe contributors
+ *
+ * This file is part of HYPSEUS SINGE, a laserdisc arcade game emulator
+ *
+ * HYPSEUS SINGE is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * HYPSEUS SINGE is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef GOLDEN_H
+#define GOLDEN_H
+
+// Golden frame regression checks (-golden <checkpoint file> <dir>).
+//
+// The checkpoint file lists emulated milliseconds, one per line, each with an
+//  optional name:
+//     # comment
+//     5000 attract
+//     12000
+// When a checkpoint is reached the game's video overlay and the last VLDP
+//  frame are copied straight out of memory (so the result doesn't depend on
+//  the renderer or the window size) and compared with <dir>/<name>-overlay.png
+//  and <dir>/<name>-video.png.  Missing golden images get recorded; images that
+//  differ are saved next to them as <name>-*.actual.png.
+// The game quits after the last checkpoint and the results, along with the
+//  cost of every vid_blit() between checkpoints, go to golden.json.
+// Runs headless like -benchmark; combine it with -playback_input for scripted
+//  input.
+
+#include <SDL.h>
+
+namespace golden
+{
+
+// Loads the checkpoints and enables the checks.  Returns false if the file
+//  can't be read or has no checkpoints in it.
+bool start(const char *pszCheckpoints, const char *pszDir);
+
+bool is_enabled();
+
+// where the JSON report gets written (golden.json by default)
+void set_report_path(const char *pszReportPath);
+
+// Checks any checkpoint that is due.  Call once per emulated millisecond.
+void think(unsigned int uMs);
+
+// how long one vid_blit() took
+void add_blit_ns(Uint64 u64Ns);
+
+// Writes the report.  Returns false if any image didn't match its golden copy
+//  or a checkpoint was never reached.
+bool write_report(const char *pszGameName);
+
+}
+
+#endif // GOLDEN_H
@@ -33,6 +33,10 @@
 #include "../io/mpo_fileio.h"
 #include "../io/mpo_mem.h"
 #include "../ldp-out/ldp.h"
+#include "../timer/perfstats.h"
+#include "../timer/tracer.h"
+#include "capture.h"
+#include "golden.h"
 #include "palette.h"
 #include "video.h"
 #include <SDL_syswm.h> // rdg2010
@@ -42,6 +46,7 @@
 #include <stdlib.h>
 #include <string.h>
 #include <string> // for some error messages
+#include <vector>
 
 using namespace std;
 
@@ -54,6 +59,7 @@ const int g_an_w = 220, g_an_h = 128;
 const int g_sb_w = 340, g_sb_h = 480;
 int s_alpha = 255;
 int s_shunt = 2;
+int s_scanline_mask = SCANLINE_MASK_NONE;
 
 int g_viewport_width = g_vid_width, g_viewport_height = g_vid_height;
 int g_aspect_width = 0, g_aspect_height = 0;
@@ -67,6 +73,9 @@ unsigned int g_overlay_width = 0, g_overlay_height = 0;
 FC_Font *g_font                    = NULL;
 FC_Font *g_fixfont                 = NULL;
 TTF_Font *g_ttfont                 = NULL;
+SDL_Surface *g_ttglyphs[128]       = {NULL}; // draw_string glyph cache
+int g_ttadvance[128]               = {0};
+int g_ttminx[128]                  = {0};
 SDL_Surface *g_led_bmps[LED_RANGE] = {0};
 SDL_Surface *g_other_bmps[B_EMPTY] = {0};
 SDL_Window *g_window               = NULL;
@@ -83,6 +92,10 @@ SDL_Surface *g_sb_blit_surface     = NULL;
 SDL_Surface *g_aux_blit_surface    = NULL;
 SDL_Texture *g_bezel_texture       = NULL;
 SDL_Texture *g_aux_texture         = NULL;
+SDL_Texture *g_scanline_texture    = NULL; // scanlines and CRT mask, made by draw_scanlines()
+
+// what g_scanline_texture was made for
+int g_scanline_tex_w = 0, g_scanline_tex_h = 0, g_scanline_tex_shunt = 0;
 
 SDL_Rect g_aux_rect;
 SDL_Rect g_rotate_rect;
@@ -104,6 +117,8 @@ bool g_opengl = false;
 bool g_vulkan = false;
 bool g_grabmouse = false;
 bool g_vsync = true;
+bool g_present_limit = false; // only present ~60 frames per real second
+bool g_stats_osd = false; // show the runtime stats on top of everything
 bool g_yuv_blue = false;
 bool g_vid_resized = false;
 bool g_enhance_overlay = false;
@@ -554,12 +569,32 @@ void vid_free_yuv_overlay () {
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
+// throws out draw_scanlines' texture (it belongs to the renderer)
+static void free_scanline_texture()
+{
+    if (g_scanline_texture) SDL_DestroyTexture(g_scanline_texture);
+    g_scanline_texture = NULL;
+    g_scanline_tex_w = g_scanline_tex_h = g_scanline_tex_shunt = 0;
+}
+
+// throws out draw_string's glyph cache
+static void free_ttglyphs()
+{
+    for (int i = 0; i < 128; i++) {
+        if (g_ttglyphs[i]) SDL_FreeSurface(g_ttglyphs[i]);
+        g_ttglyphs[i] = NULL;
+    }
+}
+
 // deinitializes the window and renderer we have used.
 // returns true if successful, false if failure
 bool deinit_display()
 {
     SDL_SetWindowGrab(g_window, SDL_FALSE);
 
+    // finish writing any screenshots before the renderer goes away
+    capture::shutdown();
+
     if (g_sb_texture)
         SDL_DestroyTexture(g_sb_texture);
 
@@ -576,6 +611,7 @@ bool deinit_display()
 
     FC_FreeFont(g_font);
     FC_FreeFont(g_fixfont);
+    free_ttglyphs();
 
     if (g_bezel_texture)
         SDL_DestroyTexture(g_bezel_texture);
@@ -583,6 +619,8 @@ bool deinit_display()
     if (g_aux_texture)
         SDL_DestroyTexture(g_aux_texture);
 
+    free_scanline_texture();
+
     SDL_DestroyTexture(g_overlay_texture);
     SDL_DestroyRenderer(g_renderer);
     SDL_DestroyWindow(g_window);
@@ -602,6 +640,7 @@ void resize_cleanup()
 
     if (g_bezel_texture) SDL_DestroyTexture(g_bezel_texture);
     if (g_aux_texture) SDL_DestroyTexture(g_aux_texture);
+    free_scanline_texture();
 
     if (g_overlay_texture) SDL_DestroyTexture(g_overlay_texture);
     if (g_renderer) SDL_DestroyRenderer(g_renderer);
@@ -1022,10 +1061,12 @@ void set_vulkan(bool value) { g_vulkan = value; }
 void set_textureaccess(int value) { g_texture_access = value; }
 void set_grabmouse(bool value) { g_grabmouse = value; }
 void set_vsync(bool value) { g_vsync = value; }
+void set_present_limit(bool value) { g_present_limit = value; }
 void set_yuv_blue(bool value) { g_yuv_blue = value; }
 void set_scanlines(bool value) { g_scanlines = value; }
 void set_shunt(int value) { s_shunt = value; }
 void set_alpha(int value) { s_alpha = value; }
+void set_scanline_mask(int value) { s_scanline_mask = value; }
 void set_queue_screenshot(bool value) { queue_take_screenshot = value; }
 void set_fullscreen_scale_nearest(bool value) { g_fs_scale_nearest = value; }
 void set_singe_blend_sprite(bool value) { g_singe_blend_sprite = value; }
@@ -1121,6 +1162,25 @@ void set_video_height(Uint16 height)
     g_vid_resized = true;
 }
 
+// Games redraw the same few characters over and over, so each one is only
+// rasterized the first time it gets drawn and then blitted from here.
+static SDL_Surface *get_ttglyph(unsigned char c, int *pAdvance, int *pMinx)
+{
+    if (!g_ttglyphs[c]) {
+        char s[2] = {(char)c, 0};
+        SDL_Color color = {0xe1, 0xe1, 0xe1};
+        g_ttglyphs[c] = TTF_RenderText_Solid(g_ttfont, s, color);
+        if (TTF_GlyphMetrics(g_ttfont, c, &g_ttminx[c], NULL, NULL, NULL,
+                             &g_ttadvance[c]) < 0) {
+            g_ttminx[c] = 0;
+            g_ttadvance[c] = g_ttglyphs[c] ? g_ttglyphs[c]->w : 0;
+        }
+    }
+    *pAdvance = g_ttadvance[c];
+    *pMinx = g_ttminx[c];
+    return g_ttglyphs[c];
+}
+
 void draw_string(const char *t, int col, int row, SDL_Surface *surface)
 {
     SDL_Rect dest;
@@ -1128,17 +1188,41 @@ void draw_string(const char *t, int col, int row, SDL_Surface *surface)
     dest.w = (unsigned short)(6 * strlen(t));
     dest.h = 14;
 
-    SDL_Surface *text_surface;
-
     if (g_game->get_use_old_overlay()) dest.x = (short)((col * 6));
     else dest.x = (short)((col * 5));
 
     SDL_FillRect(surface, &dest, 0x00000000);
-    SDL_Color color={0xe1, 0xe1, 0xe1};
-    text_surface=TTF_RenderText_Solid(g_ttfont, t, color);
 
-    SDL_BlitSurface(text_surface, NULL, surface, &dest);
-    SDL_FreeSurface(text_surface);
+    // The glyphs go where SDL_ttf would have put them for the whole string:
+    // the pen moves on by each advance plus the font's kerning for the pair,
+    // and the string is shifted right if a glyph hangs off to the left of it.
+    bool kerning = (TTF_GetFontKerning(g_ttfont) != 0);
+    int advance, minx, pen = 0, left = 0;
+    unsigned char c, prev = 0;
+    const unsigned char *p;
+
+    for (p = (const unsigned char *)t; *p; prev = c, p++) {
+        c = (*p < 128) ? *p : '?';
+        get_ttglyph(c, &advance, &minx);
+        if (kerning && prev) pen += TTF_GetFontKerningSizeGlyphs(g_ttfont, prev, c);
+        if (pen + minx < left) left = pen + minx;
+        pen += advance;
+    }
+
+    pen = -left;
+    prev = 0;
+    for (p = (const unsigned char *)t; *p; prev = c, p++) {
+        c = (*p < 128) ? *p : '?';
+        SDL_Surface *glyph = get_ttglyph(c, &advance, &minx);
+        if (kerning && prev) pen += TTF_GetFontKerningSizeGlyphs(g_ttfont, prev, c);
+        if (glyph) {
+            // a single glyph surface already starts at the overhang, if any
+            SDL_Rect glyph_dest = {dest.x + pen + ((minx < 0) ? minx : 0),
+                                   dest.y, glyph->w, glyph->h};
+            SDL_BlitSurface(glyph, NULL, surface, &glyph_dest);
+        }
+        pen += advance;
+    }
 }
 
 void draw_subtitle(char *s, bool insert)
@@ -1178,6 +1262,43 @@ void draw_LDP1450_overlay()
     }
 }
 
+void draw_stats()
+{
+    static char text[512] = "";
+    static Uint32 uLastUpdate = 0;
+
+    if (!g_font) return;
+
+    // averages over half a second are easier to read than ones that change
+    // every frame
+    Uint32 uNow = SDL_GetTicks();
+    if (!text[0] || ((uNow - uLastUpdate) >= 500)) {
+        perfstats::format_osd(text, sizeof(text));
+        uLastUpdate = uNow;
+    }
+
+    SDL_Rect box = {0, 0, 0, 0};
+    box.w = FC_GetWidth(g_font, "%s", text) + 8;
+    box.h = FC_GetHeight(g_font, "%s", text) + 8;
+
+    Uint8 r, g, b, a;
+    SDL_BlendMode mode;
+    SDL_GetRenderDrawColor(g_renderer, &r, &g, &b, &a);
+    SDL_GetRenderDrawBlendMode(g_renderer, &mode);
+    SDL_SetRenderDrawBlendMode(g_renderer, SDL_BLENDMODE_BLEND);
+    SDL_SetRenderDrawColor(g_renderer, 0, 0, 0, 0xb0);
+    SDL_RenderFillRect(g_renderer, &box);
+    SDL_SetRenderDrawColor(g_renderer, r, g, b, a);
+    SDL_SetRenderDrawBlendMode(g_renderer, mode);
+
+    FC_Draw(g_font, g_renderer, 4, 4, "%s", text);
+}
+
+void vid_toggle_stats()
+{
+    g_stats_osd = !g_stats_osd;
+}
+
 // toggles fullscreen mode
 void vid_toggle_fullscreen()
 {
@@ -1297,7 +1418,10 @@ int vid_update_yuv_overlay ( uint8_t *Yplane, uint8_t *Uplane, uint8_t *Vplane,
     // As a reminder, mutexes are very simple: this fn tries to lock(=get)
     // the mutex, but if it's already taken, LockMutex doesn't return
     // until the mutex is free and we can lock(=get) it here.
-    SDL_LockMutex(g_yuv_surface->mutex);
+    {
+        TRACE_SCOPE("yuv mutex wait");
+        SDL_LockMutex(g_yuv_surface->mutex);
+    }
 
     if (g_yuv_video_timer_blank) {
 
@@ -1326,6 +1450,102 @@ int vid_update_yuv_overlay ( uint8_t *Yplane, uint8_t *Uplane, uint8_t *Vplane,
     return 0;
 }
 
+bool vid_get_yuv_pixels (const SDL_Point *pPoints, int iCount, uint8_t *pYUV) {
+    if (!g_yuv_surface) return false;
+
+    SDL_LockMutex(g_yuv_surface->mutex);
+
+    // the planes are stored without padding (see vid_update_yuv_overlay)
+    int w  = g_yuv_surface->width;
+    int h  = g_yuv_surface->height;
+    int cw = w >> 1;
+
+    for (int i = 0; i < iCount; i++) {
+        int x = SDL_max(0, SDL_min(pPoints[i].x, w - 1));
+        int y = SDL_max(0, SDL_min(pPoints[i].y, h - 1));
+        int c = (y >> 1) * cw + (x >> 1);
+
+        *pYUV++ = g_yuv_surface->Yplane[y * w + x];
+        *pYUV++ = g_yuv_surface->Uplane[c];
+        *pYUV++ = g_yuv_surface->Vplane[c];
+    }
+
+    SDL_UnlockMutex(g_yuv_surface->mutex);
+    return true;
+}
+
+bool vid_get_yuv_average (const SDL_Rect *pRect, uint8_t *pYUV) {
+    if (!g_yuv_surface) return false;
+
+    SDL_LockMutex(g_yuv_surface->mutex);
+
+    int w  = g_yuv_surface->width;
+    int h  = g_yuv_surface->height;
+    int cw = w >> 1;
+    int x0 = SDL_max(0, pRect->x);
+    int y0 = SDL_max(0, pRect->y);
+    int x1 = SDL_min(w, pRect->x + pRect->w);
+    int y1 = SDL_min(h, pRect->y + pRect->h);
+    Uint32 uY = 0, uU = 0, uV = 0, uCount = 0;
+
+    for (int y = y0; y < y1; y++) {
+        const uint8_t *pY = g_yuv_surface->Yplane + y * w;
+        const uint8_t *pU = g_yuv_surface->Uplane + (y >> 1) * cw;
+        const uint8_t *pV = g_yuv_surface->Vplane + (y >> 1) * cw;
+        for (int x = x0; x < x1; x++) {
+            uY += pY[x];
+            uU += pU[x >> 1];
+            uV += pV[x >> 1];
+        }
+        uCount += x1 - x0;
+    }
+
+    SDL_UnlockMutex(g_yuv_surface->mutex);
+
+    // an empty rectangle is an error on the caller's part
+    if (!uCount) return false;
+
+    pYUV[0] = (uint8_t)(uY / uCount);
+    pYUV[1] = (uint8_t)(uU / uCount);
+    pYUV[2] = (uint8_t)(uV / uCount);
+    return true;
+}
+
+SDL_Surface *vid_copy_yuv_frame() {
+    if (!g_yuv_surface) return NULL;
+
+    SDL_LockMutex(g_yuv_surface->mutex);
+
+    int w = g_yuv_surface->width;
+    int h = g_yuv_surface->height;
+    SDL_Surface *surface = SDL_CreateRGBSurfaceWithFormat(0, w, h + (h >> 1), 8,
+                               SDL_PIXELFORMAT_INDEX8);
+
+    if (surface) {
+        SDL_Color grey[256];
+        for (int i = 0; i < 256; i++) {
+            grey[i].r = grey[i].g = grey[i].b = (Uint8)i;
+            grey[i].a = SDL_ALPHA_OPAQUE;
+        }
+        SDL_SetPaletteColors(surface->format->palette, grey, 0, 256);
+
+        // Y on top, then U and V side by side underneath
+        Uint8 *pDst = (Uint8 *)surface->pixels;
+        int cw = w >> 1;
+        for (int y = 0; y < h; y++) {
+            memcpy(pDst + y * surface->pitch, g_yuv_surface->Yplane + y * w, w);
+        }
+        for (int y = 0; y < (h >> 1); y++) {
+            Uint8 *pRow = pDst + (h + y) * surface->pitch;
+            memcpy(pRow, g_yuv_surface->Uplane + y * cw, cw);
+            memcpy(pRow + cw, g_yuv_surface->Vplane + y * cw, cw);
+        }
+    }
+
+    SDL_UnlockMutex(g_yuv_surface->mutex);
+    return surface;
+}
+
 void vid_update_overlay_surface (SDL_Surface *tx, int x, int y) {
     // We have got here from game::blit(), which is also called when scoreboard is updated,
     // so in that case we simply return and don't do any overlay surface update. 
@@ -1376,6 +1596,19 @@ void vid_blit () {
     // boolean DO need to be protected with a mutex.
 
 
+    // When running unthrottled, the game may blit many times faster than the
+    // display can refresh. Drop the extra frames; the needs_update flags stay
+    // set so the next frame that does get shown picks everything up.
+    if (g_present_limit) {
+        static Uint32 uLastPresent = 0;
+        Uint32 uNow = SDL_GetTicks();
+        if ((uNow - uLastPresent) < 16) return;
+        uLastPresent = uNow;
+    }
+
+    TRACE_SCOPE("vid_blit");
+    Uint64 u64StartNs = perfstats::get_ns();
+
     // First clear the renderer before the SDL_RenderCopy() calls for this frame.
     // Prevents stroboscopic effects on the background in fullscreen mode,
     // and is recommended by SDL_Rendercopy() documentation.
@@ -1384,7 +1617,10 @@ void vid_blit () {
     // Does YUV texture need update from the YUV "surface"?
     // Don't try if the vldp object didn't call setup_yuv_surface (in noldp mode)
     if (g_yuv_surface) {
-	SDL_LockMutex(g_yuv_surface->mutex);
+	{
+	    TRACE_SCOPE("yuv mutex wait");
+	    SDL_LockMutex(g_yuv_surface->mutex);
+	}
 	if (g_yuv_video_needs_update) {
 	    // If we don't have a YUV texture yet (we may be here for the first time or the vldp could have
 	    // ordered it's destruction in the mpeg_callback function because video dimensions have changed),
@@ -1398,6 +1634,8 @@ void vid_blit () {
 		g_yuv_surface->Yplane, g_yuv_surface->Ypitch,
 		g_yuv_surface->Uplane, g_yuv_surface->Vpitch,
 		g_yuv_surface->Vplane, g_yuv_surface->Vpitch);
+	    perfstats::add_value(perfstats::VALUE_VIDEO_UPLOAD_BYTES,
+		(g_yuv_surface->Ypitch + g_yuv_surface->Vpitch) * g_yuv_surface->height);
 	    g_yuv_video_needs_update = false;
 	}
 	SDL_UnlockMutex(g_yuv_surface->mutex);
@@ -1407,12 +1645,16 @@ void vid_blit () {
     if (g_scoreboard_needs_update) {
         SDL_UpdateTexture(g_overlay_texture, &g_leds_size_rect,
 	    (void *)g_leds_surface->pixels, g_leds_surface->pitch);
+        perfstats::add_value(perfstats::VALUE_OVERLAY_UPLOAD_BYTES,
+	    g_leds_surface->pitch * g_leds_size_rect.h);
     }
 
     // Does OVERLAY texture need update from the overlay surface?
     if (g_overlay_needs_update) {
         SDL_UpdateTexture(g_overlay_texture, &g_overlay_size_rect,
 	    (void *)g_screen_blitter->pixels, g_screen_blitter->pitch);
+        perfstats::add_value(perfstats::VALUE_OVERLAY_UPLOAD_BYTES,
+	    g_screen_blitter->pitch * g_overlay_size_rect.h);
 
 	g_overlay_needs_update = false;
     }
@@ -1438,6 +1680,8 @@ void vid_blit () {
     if (g_aux_needs_update) {
         SDL_UpdateTexture(g_aux_texture, &g_annu_rect,
             (void *)g_aux_blit_surface->pixels, g_aux_blit_surface->pitch);
+        perfstats::add_value(perfstats::VALUE_OVERLAY_UPLOAD_BYTES,
+            g_aux_blit_surface->pitch * g_annu_rect.h);
 
         g_aux_needs_update = false;
     }
@@ -1486,6 +1730,18 @@ void vid_blit () {
         SDL_RenderSetLogicalSize(g_renderer, g_viewport_width, g_viewport_height);
     }
 
+    // read back what is about to be shown; the writing happens on the capture thread
+    if (queue_take_screenshot) {
+        set_queue_screenshot(false);
+        take_screenshot();
+    } else if (capture::sequence_frame_due()) {
+        SDL_Surface *surface = read_screen(false);
+        if (surface) capture::submit_sequence_frame(surface);
+    }
+
+    // after the readback, so the stats don't end up in screenshots
+    if (g_stats_osd) draw_stats();
+
     SDL_RenderPresent(g_renderer);
 
     if (g_softsboard_needs_update) {
@@ -1493,10 +1749,9 @@ void vid_blit () {
         g_softsboard_needs_update = false;
     }
 
-    if (queue_take_screenshot) {
-        set_queue_screenshot(false);
-        take_screenshot();
-    }
+    Uint64 u64BlitNs = perfstats::get_ns() - u64StartNs;
+    perfstats::add_timing(perfstats::TIMING_BLIT, u64BlitNs);
+    if (golden::is_enabled()) golden::add_blit_ns(u64BlitNs);
 }
 
 int get_yuv_overlay_width() {
@@ -1521,9 +1776,6 @@ bool get_yuv_overlay_ready() {
 void take_screenshot()
 {
     struct       stat info;
-    char         filename[64];
-    int32_t      screenshot_num = 0;
-    bool         fullscreen = false;
     const char   dir[12] = "screenshots";
 
     if (stat(dir, &info ) != 0 )
@@ -1531,95 +1783,151 @@ void take_screenshot()
     else if (!(info.st_mode & S_IFDIR))
         { LOGW << fmt("'%s' is not a directory.", dir); return; }
 
+    SDL_Surface *surface = read_screen(true);
+
+    // picking a file name and encoding happen on the capture thread
+    if (surface) capture::submit_screenshot(surface);
+}
+
+// Reads back the window (plus the scoreboard window, if any) into a capture
+// buffer.  Returns NULL if there is nothing to read or no buffer free.
+SDL_Surface *read_screen(bool bScreenshot)
+{
+    bool         fullscreen = false;
     int flags = SDL_GetWindowFlags(g_window);
     SDL_Rect     screenshot;
     SDL_Surface  *surface      = NULL;
     SDL_Surface  *scoreboard   = NULL;
 
+    if (!g_renderer) {
+        LOGE << "Could not allocate renderer";
+        return NULL;
+    }
+
     if (flags & SDL_WINDOW_FULLSCREEN_DESKTOP || flags & SDL_WINDOW_MAXIMIZED)
         fullscreen = true;
 
-    if (g_renderer) {
+    if (fullscreen)
+        SDL_RenderSetViewport(g_renderer, NULL);
+
+    SDL_RenderGetViewport(g_renderer, &screenshot);
+
+    if (fullscreen)
+        SDL_GetRendererOutputSize(g_renderer, &screenshot.w, &screenshot.h);
 
-        if (fullscreen)
-            SDL_RenderSetViewport(g_renderer, NULL);
+    surface = capture::get_buffer(screenshot.w, screenshot.h, bScreenshot);
 
-        SDL_RenderGetViewport(g_renderer, &screenshot);
+    if (!surface) {
+        if (bScreenshot) { LOGE << "Cannot allocate surface"; }
+    }
+    else if (SDL_RenderReadPixels(g_renderer, &screenshot, surface->format->format,
+        surface->pixels, surface->pitch) != 0)
+        { LOGE << fmt("Cannot ReadPixels - Something bad happened: %s", SDL_GetError());
+             g_game->set_game_errors(SDL_ERROR_SCREENSHOT);
+             set_quitflag(); }
+
+    else if (g_sb_window) {
+
+        SDL_DisplayMode mode;
+        if (SDL_GetCurrentDisplayMode(SDL_GetWindowDisplayIndex(g_window), &mode) != 0)
+            { LOGE << fmt("Cannot GetDisplayMode: %s", SDL_GetError());
+             g_game->set_game_errors(SDL_ERROR_SCREENSHOT);
+             set_quitflag(); }
+
+        SDL_Rect     boardrect;
+        SDL_RenderGetViewport(g_sb_renderer, &boardrect);
+        scoreboard = SDL_CreateRGBSurface(0, boardrect.w, boardrect.h, 32, 0, 0, 0, 0);
+
+        if (scoreboard) {
+            SDL_RenderReadPixels(g_sb_renderer, &boardrect, scoreboard->format->format,
+                   scoreboard->pixels, scoreboard->pitch);
+
+            boardrect.x = (mode.w / screenshot.w) * sb_window_pos_x;
+            boardrect.y = (mode.h / screenshot.h) * sb_window_pos_y;
+
+            if (!fullscreen) {
+                mode.w = screenshot.w;
+                mode.h = screenshot.h;
+            }
 
-        if (fullscreen)
-            SDL_GetRendererOutputSize(g_renderer, &screenshot.w, &screenshot.h);
+            if (boardrect.x > (mode.w - g_sb_w)) boardrect.x = mode.w - g_sb_w;
+            if (boardrect.y > (mode.h - g_sb_h)) boardrect.y = mode.h - g_sb_h;
 
-        surface = SDL_CreateRGBSurface(0, screenshot.w, screenshot.h, 32, 0, 0, 0, 0);
+            SDL_BlitSurface(scoreboard, NULL, surface, &boardrect);
+            SDL_FreeSurface(scoreboard);
+        }
+    }
 
-        if (!surface) { LOGE << "Cannot allocate surface"; return; }
+    if (fullscreen)
+        SDL_RenderSetLogicalSize(g_renderer, g_viewport_width, g_viewport_height);
 
-        if (SDL_RenderReadPixels(g_renderer, &screenshot, surface->format->format,
-            surface->pixels, surface->pitch) != 0)
-            { LOGE << fmt("Cannot ReadPixels - Something bad happened: %s", SDL_GetError());
-                 g_game->set_game_errors(SDL_ERROR_SCREENSHOT);
-                 set_quitflag(); }
+    return surface;
+}
 
-        if (g_sb_window) {
+// Makes the texture draw_scanlines() multiplies the screen with: every l'th
+// row darkened the same as blending in a black line with s_alpha did, and the
+// CRT mask (if any) on top.  Returns NULL if the renderer can't make it.
+static SDL_Texture *make_scanline_texture(int w, int h, int l)
+{
+    static const int MASK_DIM = 0xA0; // how much of the other colors a
+                                      // phosphor lets through
 
-            SDL_DisplayMode mode;
-            if (SDL_GetCurrentDisplayMode(SDL_GetWindowDisplayIndex(g_window), &mode) != 0)
-                { LOGE << fmt("Cannot GetDisplayMode: %s", SDL_GetError());
-                 g_game->set_game_errors(SDL_ERROR_SCREENSHOT);
-                 set_quitflag(); }
+    SDL_Texture *texture = SDL_CreateTexture(g_renderer, SDL_PIXELFORMAT_ARGB8888,
+                                             SDL_TEXTUREACCESS_STATIC, w, h);
+    if (!texture) return NULL;
 
-            SDL_Rect     boardrect;
-            SDL_RenderGetViewport(g_sb_renderer, &boardrect);
-            scoreboard = SDL_CreateRGBSurface(0, boardrect.w, boardrect.h, 32, 0, 0, 0, 0);
+    std::vector<Uint32> vPixels(w * h);
+    Uint32 *p = &vPixels[0];
 
-            if (scoreboard) {
-                SDL_RenderReadPixels(g_sb_renderer, &boardrect, scoreboard->format->format,
-                       scoreboard->pixels, scoreboard->pitch);
+    for (int y = 0; y < h; y++) {
+        int line = ((y % l) == 0) ? (255 - s_alpha) : 255;
 
-                boardrect.x = (mode.w / screenshot.w) * sb_window_pos_x;
-                boardrect.y = (mode.h / screenshot.h) * sb_window_pos_y;
+        for (int x = 0; x < w; x++) {
+            int rgb[3] = {line, line, line};
 
-                if (!fullscreen) {
-                    mode.w = screenshot.w;
-                    mode.h = screenshot.h;
-                }
+            if (s_scanline_mask != SCANLINE_MASK_NONE) {
+                // red, green and blue stripes one pixel wide
+                int lit = x % 3;
 
-                if (boardrect.x > (mode.w - g_sb_w)) boardrect.x = mode.w - g_sb_w;
-                if (boardrect.y > (mode.h - g_sb_h)) boardrect.y = mode.h - g_sb_h;
+                // a slot mask breaks the stripes up every 4 rows, staggered
+                // from one RGB triad to the next
+                if ((s_scanline_mask == SCANLINE_MASK_SLOT) &&
+                    (((y + ((x / 3) & 1) * 2) & 3) == 3))
+                    lit = -1;
 
-                SDL_BlitSurface(scoreboard, NULL, surface, &boardrect);
+                for (int c = 0; c < 3; c++)
+                    if (c != lit) rgb[c] = (rgb[c] * MASK_DIM) / 255;
             }
+            *p++ = 0xFF000000 | (rgb[0] << 16) | (rgb[1] << 8) | rgb[2];
         }
-
-    } else {
-        LOGE << "Could not allocate renderer";
-        return;
     }
 
-    if (fullscreen)
-        SDL_RenderSetLogicalSize(g_renderer, g_viewport_width, g_viewport_height);
+    SDL_UpdateTexture(texture, NULL, &vPixels[0], w * sizeof(Uint32));
+    SDL_SetTextureBlendMode(texture, SDL_BLENDMODE_MOD);
+    return texture;
+}
 
-    for (;;) {
-        screenshot_num++;
-        snprintf(filename, sizeof(filename), "%s%shypseus-%d.png",
-          dir, PATH_SEPARATOR, screenshot_num);
+// Darkens every l'th row (and applies the CRT mask) with a single copy of a
+// texture that is only made again when the viewport changes size.
+void draw_scanlines(int w, int h, int l) {
 
-        if (!mpo_file_exists(filename))
-            break;
-    }
+    if ((w != g_scanline_tex_w) || (h != g_scanline_tex_h) || (l != g_scanline_tex_shunt)) {
+        free_scanline_texture();
+        g_scanline_texture = make_scanline_texture(w, h, l);
+        g_scanline_tex_w = w;
+        g_scanline_tex_h = h;
+        g_scanline_tex_shunt = l;
 
-    if (IMG_SavePNG(surface, filename) == 0) {
-        LOGI << fmt("Wrote screenshot: %s", filename);
-    } else {
-        LOGE <<  fmt("Could not write screenshot: %s !!", filename);
+        if (!g_scanline_texture) {
+            LOGW << fmt("Could not create scanline texture, drawing lines instead: %s",
+                        SDL_GetError());
+        }
     }
 
-    if (scoreboard)
-        SDL_FreeSurface(scoreboard);
-
-    SDL_FreeSurface(surface);
-}
-
-void draw_scanlines(int w, int h, int l) {
+    if (g_scanline_texture) {
+        SDL_RenderCopy(g_renderer, g_scanline_texture, NULL, NULL);
+        return;
+    }
 
     SDL_SetRenderDrawColor(g_renderer, 0, 0, 0, s_alpha);
 
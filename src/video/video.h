@@ -83,6 +83,13 @@ enum {
     B_EMPTY
 }; // bitmaps
 
+// CRT masks drawn along with the scanlines
+enum {
+    SCANLINE_MASK_NONE,
+    SCANLINE_MASK_GRILLE, // aperture grille
+    SCANLINE_MASK_SLOT
+};
+
 bool init_display();
 
 // MAC: YUV surface protection block: it needs protection because it's accessed from both
@@ -99,6 +106,17 @@ int vid_update_yuv_texture (uint8_t *Yplane, uint8_t *Uplane, uint8_t *Vplane, i
 void vid_blank_yuv_texture (bool value);
 void vid_free_yuv_overlay ();
 
+// Reads pixels straight out of the YUV surface (the last frame VLDP gave us),
+// so nothing has to be read back from the GPU.  Points are in video
+// coordinates and get clamped to the frame.  Three bytes (Y, U, V) are written
+// per point.  Both return false if there is no video.
+bool vid_get_yuv_pixels (const SDL_Point *pPoints, int iCount, uint8_t *pYUV);
+// averages Y, U and V over 'pRect' (clipped to the frame)
+bool vid_get_yuv_average (const SDL_Rect *pRect, uint8_t *pYUV);
+// Copies the last frame into a new greyscale 8-bit surface laid out as I420
+// (Y, then U and V side by side below it).  NULL if there is no video.
+SDL_Surface *vid_copy_yuv_frame ();
+
 void vid_update_overlay_surface(SDL_Surface *tx, int x, int y);
 void vid_blit();
 // MAC: sdl_video_run thread block ends here
@@ -148,6 +166,7 @@ int get_textureaccess();
 void set_textureaccess(int value);
 void set_grabmouse(bool value);
 void set_vsync(bool value);
+void set_present_limit(bool value);
 void set_yuv_blue(bool value);
 void set_fullscreen(bool value);
 void set_fakefullscreen(bool value);
@@ -157,6 +176,7 @@ void set_ignore_aspect_ratio(bool bEnabled);
 void set_scanlines(bool value);
 void set_shunt(int value);
 void set_alpha(int value);
+void set_scanline_mask(int value);
 void set_yuv_video_blank(bool value);
 void set_video_timer_blank(bool value);
 int get_scalefactor();           // by RDG2010
@@ -172,7 +192,9 @@ void draw_border(int, int);
 void draw_string(const char *, int, int, SDL_Surface *);
 void draw_subtitle(char *, bool ins);
 void draw_LDP1450_overlay();
+void draw_stats();
 void vid_toggle_fullscreen();
+void vid_toggle_stats(); // the runtime stats on top of the picture
 void vid_toggle_scanlines();
 void vid_scoreboard_switch();
 void set_aspect_ratio(int fRatio);
@@ -197,6 +219,7 @@ bool draw_ranks();
 bool draw_annunciator(int which);
 
 void take_screenshot();
+SDL_Surface *read_screen(bool bScreenshot);
 void set_queue_screenshot(bool bEnabled);
 
 unsigned int get_draw_width();
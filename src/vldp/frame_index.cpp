@@ -0,0 +1,155 @@
+/*
+ * ____ HYPSEUS COPYRIGHT NOTICE ____
+ *
+ * Copyright (C) 2026 Hypseus Singe contributors
+ *
+ * This file is part of HYPSEUS SINGE, a laserdisc arcade game emulator
+ *
+ * HYPSEUS SINGE is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * HYPSEUS SINGE is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "frame_index.h"
+
+FrameIndex::FrameIndex() { Clear(); }
+
+void FrameIndex::Clear()
+{
+    m_vGroups.clear();
+    m_vSlots.clear();
+    m_uTotalFrames = 0;
+    m_uFirstFrame  = NO_POS;
+    m_uFirstPos    = NO_POS;
+    m_uCurFrame    = NO_POS;
+    m_uCurPos      = NO_POS;
+    m_uCurFrames   = 0;
+}
+
+void FrameIndex::Add(Uint32 uPos)
+{
+    if (uPos != NO_POS) {
+        // The delta wraps around if the positions ever go backwards, which
+        //  adding it back undoes.
+        if (m_uCurFrame != NO_POS) {
+            PutVarint(m_uCurFrames);
+            PutVarint(uPos - m_uCurPos);
+        } else {
+            m_uFirstFrame = m_uTotalFrames;
+            m_uFirstPos   = uPos;
+        }
+        m_uCurFrame  = m_uTotalFrames;
+        m_uCurPos    = uPos;
+        m_uCurFrames = 0;
+    }
+    m_uCurFrames++;
+
+    // the current group will go where m_vGroups ends now
+    if ((m_uTotalFrames % SLOT_FRAMES) == 0) {
+        slot_s slot;
+        slot.uByte  = (Uint32) m_vGroups.size();
+        slot.uFrame = m_uCurFrame;
+        slot.uPos   = m_uCurPos;
+        m_vSlots.push_back(slot);
+    }
+
+    m_uTotalFrames++;
+}
+
+Uint32 FrameIndex::GetPosition(Uint32 uFrame) const
+{
+    if ((uFrame >= m_uTotalFrames) || (m_uFirstFrame == NO_POS) || (uFrame < m_uFirstFrame)) {
+        return NO_POS;
+    }
+
+    const slot_s &slot = m_vSlots[uFrame / SLOT_FRAMES];
+    const Uint8 *p     = m_vGroups.empty() ? NULL : &m_vGroups[0];
+    const Uint8 *pEnd  = p + m_vGroups.size();
+    Uint32 uGroupFrame = m_uFirstFrame;
+    Uint32 uGroupPos   = m_uFirstPos;
+
+    // (a slot from before the first I frame starts at the first group)
+    if (slot.uFrame != NO_POS) {
+        p += slot.uByte;
+        uGroupFrame = slot.uFrame;
+        uGroupPos   = slot.uPos;
+    }
+
+    // running off the end means uFrame is in the current group
+    while (p != pEnd) {
+        Uint32 uFrames = GetVarint(p);
+        if (uFrame < uGroupFrame + uFrames) break;
+
+        uGroupFrame += uFrames;
+        uGroupPos += GetVarint(p);
+    }
+
+    return (uFrame == uGroupFrame) ? uGroupPos : NO_POS;
+}
+
+Uint32 FrameIndex::GetFrameAt(Uint32 uPos) const
+{
+    if (m_uFirstFrame == NO_POS) return m_uTotalFrames;
+
+    const Uint8 *p     = m_vGroups.empty() ? NULL : &m_vGroups[0];
+    const Uint8 *pEnd  = p + m_vGroups.size();
+    Uint32 uGroupFrame = m_uFirstFrame;
+    Uint32 uGroupPos   = m_uFirstPos;
+
+    // the last slot (after the first I frame) that starts at or before uPos
+    size_t lo = (m_uFirstFrame + SLOT_FRAMES - 1) / SLOT_FRAMES;
+    size_t hi = m_vSlots.size();
+    if ((lo < hi) && (m_vSlots[lo].uPos <= uPos)) {
+        while (hi - lo > 1) {
+            size_t mid = (lo + hi) / 2;
+            if (m_vSlots[mid].uPos <= uPos) lo = mid;
+            else hi = mid;
+        }
+        p += m_vSlots[lo].uByte;
+        uGroupFrame = m_vSlots[lo].uFrame;
+        uGroupPos   = m_vSlots[lo].uPos;
+    }
+
+    while (uGroupPos < uPos) {
+        if (p == pEnd) return m_uTotalFrames; // past the last I frame
+        uGroupFrame += GetVarint(p);
+        uGroupPos += GetVarint(p);
+    }
+
+    return uGroupFrame;
+}
+
+size_t FrameIndex::GetMemoryUsage() const
+{
+    return sizeof(*this) + m_vGroups.capacity() + (m_vSlots.capacity() * sizeof(slot_s));
+}
+
+void FrameIndex::PutVarint(Uint32 u)
+{
+    while (u >= 0x80) {
+        m_vGroups.push_back((Uint8) (u | 0x80));
+        u >>= 7;
+    }
+    m_vGroups.push_back((Uint8) u);
+}
+
+Uint32 FrameIndex::GetVarint(const Uint8 *&p)
+{
+    Uint32 u = 0;
+    for (int iShift = 0;; iShift += 7) {
+        Uint8 u8 = *p++;
+        u |= (Uint32) (u8 & 0x7F) << iShift;
+        if (!(u8 & 0x80)) break;
+    }
+    return u;
+}
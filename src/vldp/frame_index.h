@@ -0,0 +1,88 @@
+/*
+ * ____ HYPSEUS COPYRIGHT NOTICE ____
+ *
+ * Copyright (C) 2026 Hypseus Singe contributors
+ *
+ * This file is part of HYPSEUS SINGE, a laserdisc arcade game emulator
+ *
+ * HYPSEUS SINGE is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * HYPSEUS SINGE is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef FRAME_INDEX_H
+#define FRAME_INDEX_H
+
+#include <SDL.h>
+#include <stddef.h>
+#include <vector>
+
+// The file position of each I frame of an mpeg, as mpegscan writes them to
+//  .DAT files, kept in a fraction of the memory of one Uint32 per frame.
+//
+// Every I frame starts a group that runs up to the next one.  Each finished
+//  group is stored as two varints: how many frames it has, and how far the
+//  next group's I frame is from its own.  Every SLOT_FRAMES frames a slot
+//  records which group that frame falls in, so a lookup never walks more than
+//  SLOT_FRAMES frames' worth of groups.
+class FrameIndex
+{
+public:
+    // what GetPosition() returns for frames that aren't I frames
+    static const Uint32 NO_POS = 0xFFFFFFFF;
+
+    static const Uint32 SLOT_FRAMES = 64;
+
+    FrameIndex();
+
+    void Clear();
+
+    // appends the next frame: its position if it is an I frame, or NO_POS
+    void Add(Uint32 uPos);
+
+    Uint32 GetFrameCount() const { return m_uTotalFrames; }
+
+    // the position of frame uFrame if it is an I frame, NO_POS otherwise
+    Uint32 GetPosition(Uint32 uFrame) const;
+
+    // the first I frame at or after position uPos (GetFrameCount() if there
+    //  isn't one)
+    Uint32 GetFrameAt(Uint32 uPos) const;
+
+    // bytes of memory the index is using
+    size_t GetMemoryUsage() const;
+
+private:
+    // where the group holding frame (slot # * SLOT_FRAMES) is
+    struct slot_s {
+        Uint32 uByte;  // its offset in m_vGroups
+        Uint32 uFrame; // its I frame (NO_POS if there wasn't one yet)
+        Uint32 uPos;   // and that I frame's position
+    };
+
+    void PutVarint(Uint32 u);
+    static Uint32 GetVarint(const Uint8 *&p);
+
+    std::vector<Uint8> m_vGroups; // finished groups
+    std::vector<slot_s> m_vSlots;
+    Uint32 m_uTotalFrames;
+    Uint32 m_uFirstFrame; // the first I frame (NO_POS if none yet)
+    Uint32 m_uFirstPos;
+
+    // the last group, which isn't in m_vGroups until the next I frame
+    Uint32 m_uCurFrame; // NO_POS before the first I frame
+    Uint32 m_uCurPos;
+    Uint32 m_uCurFrames;
+};
+
+#endif // FRAME_INDEX_H
@@ -0,0 +1,424 @@
+/*
+ * ____ HYPSEUS COPYRIGHT NOTICE ____
+ *
+ * Copyright (C) 2026 Hypseus Singe contributors
+ *
+ * This file is part of HYPSEUS SINGE, a laserdisc arcade game emulator
+ *
+ * HYPSEUS SINGE is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * HYPSEUS SINGE is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "gop_decoder.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+GOPDecoder::GOPDecoder()
+    : m_mutex(NULL), m_workCond(NULL), m_frameCond(NULL), m_bQuit(false),
+      m_uFrames(0), m_uMaxFrames(0), m_pCurFrame(NULL)
+{
+}
+
+GOPDecoder::~GOPDecoder() { Stop(); }
+
+bool GOPDecoder::Start(unsigned int uThreads)
+{
+    Stop();
+
+    m_mutex     = SDL_CreateMutex();
+    m_workCond  = SDL_CreateCond();
+    m_frameCond = SDL_CreateCond();
+    m_bQuit     = false;
+
+    if (!m_mutex || !m_workCond || !m_frameCond) {
+        Stop();
+        return false;
+    }
+
+    // The decoders are all made here, because the first mpeg2_init() sets up
+    // libmpeg2's shared tables.
+    m_vWorkers.reserve(uThreads);
+    for (unsigned int u = 0; u < uThreads; u++) {
+        worker_s worker;
+        worker.pThis    = this;
+        worker.pDecoder = mpeg2_init();
+        worker.thread   = NULL;
+        if (!worker.pDecoder) break;
+        m_vWorkers.push_back(worker);
+    }
+
+    // (the threads point into m_vWorkers, so it must not grow after this)
+    for (size_t i = 0; i < m_vWorkers.size(); i++) {
+        m_vWorkers[i].thread =
+            SDL_CreateThread(ThreadProc, "VLDP decode", &m_vWorkers[i]);
+
+        // make do with the ones we've got
+        if (!m_vWorkers[i].thread) {
+            while (m_vWorkers.size() > i) {
+                mpeg2_close(m_vWorkers.back().pDecoder);
+                m_vWorkers.pop_back();
+            }
+        }
+    }
+
+    if (m_vWorkers.empty()) {
+        Stop();
+        return false;
+    }
+
+    m_uMaxFrames = (unsigned int) m_vWorkers.size() * FRAMES_PER_THREAD;
+    return true;
+}
+
+void GOPDecoder::Stop()
+{
+    if (!m_vWorkers.empty()) {
+        Reset();
+
+        SDL_LockMutex(m_mutex);
+        m_bQuit = true;
+        SDL_CondBroadcast(m_workCond);
+        SDL_UnlockMutex(m_mutex);
+
+        for (size_t i = 0; i < m_vWorkers.size(); i++) {
+            SDL_WaitThread(m_vWorkers[i].thread, NULL);
+            mpeg2_close(m_vWorkers[i].pDecoder);
+        }
+        m_vWorkers.clear();
+    }
+
+    for (size_t i = 0; i < m_vFreeFrames.size(); i++) {
+        free(m_vFreeFrames[i]);
+    }
+    m_vFreeFrames.clear();
+
+    if (m_frameCond) {
+        SDL_DestroyCond(m_frameCond);
+        m_frameCond = NULL;
+    }
+    if (m_workCond) {
+        SDL_DestroyCond(m_workCond);
+        m_workCond = NULL;
+    }
+    if (m_mutex) {
+        SDL_DestroyMutex(m_mutex);
+        m_mutex = NULL;
+    }
+}
+
+void GOPDecoder::Queue(std::vector<Uint8> &vData, unsigned int uHeaderBytes,
+                       unsigned int uLeadBytes)
+{
+    span_s *pSpan = new span_s;
+    pSpan->vData.swap(vData);
+    pSpan->uHeaderBytes = uHeaderBytes;
+    pSpan->uLeadBytes   = uLeadBytes;
+    pSpan->state        = SPAN_QUEUED;
+    pSpan->bCancelled   = false;
+
+    SDL_LockMutex(m_mutex);
+    m_spans.push_back(pSpan);
+    SDL_CondSignal(m_workCond);
+    SDL_UnlockMutex(m_mutex);
+}
+
+unsigned int GOPDecoder::GetQueuedCount()
+{
+    SDL_LockMutex(m_mutex);
+    unsigned int uCount = (unsigned int) m_spans.size();
+    SDL_UnlockMutex(m_mutex);
+    return uCount;
+}
+
+const GOPDecoder::frame_s *GOPDecoder::GetFrame()
+{
+    SDL_LockMutex(m_mutex);
+
+    if (m_pCurFrame) {
+        FreeFrame(m_pCurFrame);
+        m_pCurFrame = NULL;
+    }
+
+    while (!m_spans.empty()) {
+        span_s *pSpan = m_spans.front();
+
+        if (!pSpan->frames.empty()) {
+            m_pCurFrame = pSpan->frames.front();
+            pSpan->frames.pop_front();
+            m_uFrames--;
+            SDL_CondBroadcast(m_workCond); // there's room for another frame
+            break;
+        }
+
+        if (pSpan->state == SPAN_DONE) {
+            m_spans.pop_front();
+            delete pSpan;
+            SDL_CondBroadcast(m_workCond); // the next span is at the front now
+            continue;
+        }
+
+        SDL_CondWait(m_frameCond, m_mutex);
+    }
+
+    SDL_UnlockMutex(m_mutex);
+    return m_pCurFrame;
+}
+
+void GOPDecoder::Reset()
+{
+    if (!m_mutex) return;
+
+    SDL_LockMutex(m_mutex);
+
+    for (size_t i = 0; i < m_spans.size(); i++) {
+        DropSpan(m_spans[i]);
+    }
+    m_spans.clear();
+
+    if (m_pCurFrame) {
+        FreeFrame(m_pCurFrame);
+        m_pCurFrame = NULL;
+    }
+
+    // wake up any thread waiting for room, so it sees its span is gone
+    SDL_CondBroadcast(m_workCond);
+    SDL_UnlockMutex(m_mutex);
+}
+
+void GOPDecoder::InitCursor(span_cursor_s &cursor, const FrameIndex *pIndex,
+                            Uint32 uLength, Uint32 uStartPos)
+{
+    cursor.pIndex  = pIndex;
+    cursor.uLength = uLength;
+    cursor.uIdx    = pIndex->GetFrameAt(uStartPos);
+    cursor.uPos    = uStartPos;
+    cursor.uLastI  = NO_POS;
+}
+
+bool GOPDecoder::NextSpan(span_cursor_s &cursor, span_pos_s &span)
+{
+    if (cursor.uPos >= cursor.uLength) return false;
+
+    Uint32 uFirst       = cursor.uIdx;
+    Uint32 uIdx         = uFirst;
+    Uint32 uLastI       = cursor.uLastI;
+    Uint32 uTotalFrames = cursor.pIndex->GetFrameCount();
+
+    for (; uIdx < uTotalFrames; uIdx++) {
+        Uint32 uPos = cursor.pIndex->GetPosition(uIdx);
+        if (uPos == NO_POS) continue;
+
+        if ((uPos > cursor.uPos) && (uIdx - uFirst >= SPAN_MIN_FRAMES)) break;
+        uLastI = uPos;
+    }
+
+    span.uLeadStart = cursor.uLastI;
+    span.uStart     = cursor.uPos;
+    span.uEnd = (uIdx < uTotalFrames) ? cursor.pIndex->GetPosition(uIdx) : cursor.uLength;
+
+    // the next span's lead-in starts at the last I frame of this one
+    cursor.uIdx   = uIdx;
+    cursor.uPos   = span.uEnd;
+    cursor.uLastI = uLastI;
+    return true;
+}
+
+int GOPDecoder::ThreadProc(void *pWorker)
+{
+    worker_s *pW = (worker_s *) pWorker;
+    pW->pThis->Run(pW->pDecoder);
+    return 0;
+}
+
+void GOPDecoder::Run(mpeg2dec_t *pDecoder)
+{
+    SDL_LockMutex(m_mutex);
+
+    for (;;) {
+        span_s *pSpan = NULL;
+
+        while (!m_bQuit) {
+            for (size_t i = 0; i < m_spans.size(); i++) {
+                if (m_spans[i]->state == SPAN_QUEUED) {
+                    pSpan = m_spans[i];
+                    break;
+                }
+            }
+            if (pSpan) break;
+            SDL_CondWait(m_workCond, m_mutex);
+        }
+
+        if (m_bQuit) break;
+
+        pSpan->state = SPAN_DECODING;
+        SDL_UnlockMutex(m_mutex);
+
+        Decode(pDecoder, pSpan);
+
+        SDL_LockMutex(m_mutex);
+        if (pSpan->bCancelled) {
+            delete pSpan;
+        } else {
+            pSpan->state = SPAN_DONE;
+            SDL_CondSignal(m_frameCond);
+        }
+    }
+
+    SDL_UnlockMutex(m_mutex);
+}
+
+void GOPDecoder::Decode(mpeg2dec_t *pDecoder, span_s *pSpan)
+{
+    Uint8 *pData = pSpan->vData.empty() ? NULL : &pSpan->vData[0];
+    Uint8 *pLead = pData + pSpan->uHeaderBytes;
+    Uint8 *pBody = pLead + pSpan->uLeadBytes;
+    Uint8 *pEnd  = pData + pSpan->vData.size();
+
+    mpeg2_reset(pDecoder, 1);
+    mpeg2_skip(pDecoder, 0);
+
+    // this is how a search starts decoding from the middle of the file too
+    if (!Parse(pDecoder, pData, pLead, pSpan, false)) return;
+    if (!Parse(pDecoder, pLead, pBody, pSpan, false)) return;
+    Parse(pDecoder, pBody, pEnd, pSpan, true);
+}
+
+bool GOPDecoder::Parse(mpeg2dec_t *pDecoder, Uint8 *pStart, Uint8 *pEnd,
+                       span_s *pSpan, bool bKeep)
+{
+    const mpeg2_info_t *info = mpeg2_info(pDecoder);
+
+    if (pStart == pEnd) return true;
+
+    mpeg2_buffer(pDecoder, pStart, pEnd);
+
+    for (;;) {
+        switch (mpeg2_parse(pDecoder)) {
+        case STATE_BUFFER:
+            return true;
+        case STATE_PICTURE:
+            // nothing refers to a B frame, so the lead-in can do without them
+            mpeg2_skip(pDecoder, !bKeep && ((info->current_picture->flags & PIC_MASK_CODING_TYPE) ==
+                                            PIC_FLAG_CODING_TYPE_B));
+            if (IsCancelled(pSpan)) return false;
+            break;
+        case STATE_SLICE:
+        case STATE_END:
+        case STATE_INVALID_END:
+            if (bKeep && info->display_fbuf) {
+                if (!AddFrame(pSpan, info)) return false;
+            }
+            break;
+        default:
+            break;
+        }
+    }
+}
+
+bool GOPDecoder::AddFrame(span_s *pSpan, const mpeg2_info_t *info)
+{
+    const mpeg2_sequence_t *seq = info->sequence;
+    unsigned int uLuma   = seq->width * seq->height;
+    unsigned int uChroma = seq->chroma_width * seq->chroma_height;
+
+    SDL_LockMutex(m_mutex);
+    frame_s *pFrame = NewFrame(uLuma + (uChroma * 2));
+    SDL_UnlockMutex(m_mutex);
+
+    if (!pFrame) return false;
+
+    pFrame->buf[0]       = (Uint8 *) (pFrame + 1); // the planes follow the struct
+    pFrame->buf[1]       = pFrame->buf[0] + uLuma;
+    pFrame->buf[2]       = pFrame->buf[1] + uChroma;
+    pFrame->width        = seq->width;
+    pFrame->chroma_width = seq->chroma_width;
+    memcpy(pFrame->buf[0], info->display_fbuf->buf[0], uLuma);
+    memcpy(pFrame->buf[1], info->display_fbuf->buf[1], uChroma);
+    memcpy(pFrame->buf[2], info->display_fbuf->buf[2], uChroma);
+
+    SDL_LockMutex(m_mutex);
+
+    // Only the span at the front may go over the limit, so the frame that is
+    // needed next can always be decoded.
+    while (!pSpan->bCancelled && !m_bQuit && (m_uFrames >= m_uMaxFrames) &&
+           (m_spans.front() != pSpan)) {
+        SDL_CondWait(m_workCond, m_mutex);
+    }
+
+    bool bAdded = !pSpan->bCancelled && !m_bQuit;
+    if (bAdded) {
+        pSpan->frames.push_back(pFrame);
+        m_uFrames++;
+        SDL_CondSignal(m_frameCond);
+    } else {
+        FreeFrame(pFrame);
+    }
+
+    SDL_UnlockMutex(m_mutex);
+    return bAdded;
+}
+
+bool GOPDecoder::IsCancelled(span_s *pSpan)
+{
+    SDL_LockMutex(m_mutex);
+    bool bCancelled = pSpan->bCancelled || m_bQuit;
+    SDL_UnlockMutex(m_mutex);
+    return bCancelled;
+}
+
+GOPDecoder::frame_s *GOPDecoder::NewFrame(unsigned int uSize)
+{
+    frame_s *pFrame = NULL;
+
+    if (!m_vFreeFrames.empty()) {
+        pFrame = m_vFreeFrames.back();
+        m_vFreeFrames.pop_back();
+
+        // a different mpeg was opened
+        if (pFrame->uSize != uSize) {
+            free(pFrame);
+            pFrame = NULL;
+        }
+    }
+
+    if (!pFrame) {
+        pFrame = (frame_s *) malloc(sizeof(frame_s) + uSize);
+        if (!pFrame) {
+            fprintf(stderr, "VLDP : Out of memory for a decoded frame\n");
+            return NULL;
+        }
+        pFrame->uSize = uSize;
+    }
+
+    return pFrame;
+}
+
+void GOPDecoder::FreeFrame(frame_s *pFrame) { m_vFreeFrames.push_back(pFrame); }
+
+void GOPDecoder::DropSpan(span_s *pSpan)
+{
+    while (!pSpan->frames.empty()) {
+        FreeFrame(pSpan->frames.front());
+        pSpan->frames.pop_front();
+        m_uFrames--;
+    }
+
+    // the thread decoding it deletes it once it notices
+    if (pSpan->state == SPAN_DECODING) {
+        pSpan->bCancelled = true;
+    } else {
+        delete pSpan;
+    }
+}
@@ -0,0 +1,172 @@
+/*
+ * ____ HYPSEUS COPYRIGHT NOTICE ____
+ *
+ * Copyright (C) 2026 Hypseus Singe contributors
+ *
+ * This file is part of HYPSEUS SINGE, a laserdisc arcade game emulator
+ *
+ * HYPSEUS SINGE is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * HYPSEUS SINGE is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef GOP_DECODER_H
+#define GOP_DECODER_H
+
+#include <SDL.h>
+#include <stdint.h>
+#include <deque>
+#include <vector>
+
+#include <mpeg2.h>
+
+#include "frame_index.h"
+
+// Decodes an mpeg2 stream on several threads at once and hands the frames back
+//  in display order, ahead of when they are needed.
+//
+// The stream is cut into spans at I frames and each thread decodes a whole
+//  span.  The leading B frames of an open GOP refer to the last P frame of the
+//  GOP before, so a span carries a 'lead-in' starting at the I frame before
+//  it.  The lead-in is decoded (minus its B frames) only to rebuild the
+//  reference frames, and whatever it displays is thrown away.  A frame comes
+//  out of a span exactly as it would have come out of one decoder going
+//  through the whole stream, since libmpeg2 only depends on the bytes it was
+//  given.
+class GOPDecoder
+{
+public:
+    // marks frames that aren't I frames in a frame index
+    static const Uint32 NO_POS = FrameIndex::NO_POS;
+
+    // a span ends at the first I frame at least this many frames in
+    static const Uint32 SPAN_MIN_FRAMES = 12;
+
+    // how many decoded frames each thread may keep waiting
+    static const unsigned int FRAMES_PER_THREAD = 8;
+
+    struct frame_s {
+        Uint8 *buf[3];    // Y, U, V
+        int width;        // Y pitch
+        int chroma_width; // U and V pitch
+        unsigned int uSize;
+    };
+
+    // one span and where it lies in the file
+    struct span_pos_s {
+        Uint32 uLeadStart; // the I frame the lead-in starts at (NO_POS if none)
+        Uint32 uStart;
+        Uint32 uEnd;
+    };
+
+    // walks a frame index span by span
+    struct span_cursor_s {
+        const FrameIndex *pIndex;
+        Uint32 uLength; // stream length
+        Uint32 uIdx;    // the frame the next span starts on
+        Uint32 uPos;    // where the next span starts
+        Uint32 uLastI;  // the last I frame before uPos
+    };
+
+    GOPDecoder();
+    ~GOPDecoder();
+
+    // Starts uThreads decoding threads.  Returns false if none could be
+    //  started.
+    bool Start(unsigned int uThreads);
+
+    // throws everything away and stops the threads
+    void Stop();
+
+    bool IsStarted() { return !m_vWorkers.empty(); }
+    unsigned int GetThreadCount() { return (unsigned int) m_vWorkers.size(); }
+
+    // Queues a span.  vData holds the sequence header (empty if the span is at
+    //  the beginning of the stream), then the lead-in, then the span itself.
+    //  vData is emptied.
+    void Queue(std::vector<Uint8> &vData, unsigned int uHeaderBytes,
+               unsigned int uLeadBytes);
+
+    // spans queued that haven't been handed out completely yet
+    unsigned int GetQueuedCount();
+
+    // Returns the next frame, waiting for it to be decoded if need be, or NULL
+    //  once every queued span has been handed out.  The frame stays valid
+    //  until the next call or Reset().
+    const frame_s *GetFrame();
+
+    // throws away every queued span and decoded frame
+    void Reset();
+
+    // starts 'cursor' on the first I frame at or after uStartPos
+    static void InitCursor(span_cursor_s &cursor, const FrameIndex *pIndex,
+                           Uint32 uLength, Uint32 uStartPos);
+
+    // works out where the next span lies, returns false past the end
+    static bool NextSpan(span_cursor_s &cursor, span_pos_s &span);
+
+private:
+    enum span_state_e { SPAN_QUEUED, SPAN_DECODING, SPAN_DONE };
+
+    struct span_s {
+        std::vector<Uint8> vData;
+        unsigned int uHeaderBytes;
+        unsigned int uLeadBytes;
+        span_state_e state;
+        bool bCancelled; // Reset() dropped it while it was being decoded
+        std::deque<frame_s *> frames; // decoded, not handed out yet
+    };
+
+    struct worker_s {
+        GOPDecoder *pThis;
+        mpeg2dec_t *pDecoder;
+        SDL_Thread *thread;
+    };
+
+    static int ThreadProc(void *pWorker);
+    void Run(mpeg2dec_t *pDecoder);
+
+    void Decode(mpeg2dec_t *pDecoder, span_s *pSpan);
+
+    // feeds libmpeg2 pStart to pEnd, keeping what it displays if bKeep is
+    //  set.  Returns false if the span was cancelled.
+    bool Parse(mpeg2dec_t *pDecoder, Uint8 *pStart, Uint8 *pEnd, span_s *pSpan,
+               bool bKeep);
+
+    // copies the frame being displayed into the span
+    bool AddFrame(span_s *pSpan, const mpeg2_info_t *info);
+
+    bool IsCancelled(span_s *pSpan);
+
+    // these need m_mutex held
+    frame_s *NewFrame(unsigned int uSize);
+    void FreeFrame(frame_s *pFrame);
+    void DropSpan(span_s *pSpan);
+
+    std::vector<worker_s> m_vWorkers;
+
+    SDL_mutex *m_mutex;      // guards everything below
+    SDL_cond *m_workCond;    // signalled when a span is queued, frames are
+                             // taken, or on Stop()
+    SDL_cond *m_frameCond;   // signalled when a frame is decoded or a span is
+                             // finished
+    bool m_bQuit;
+
+    std::deque<span_s *> m_spans; // in stream order
+    unsigned int m_uFrames;       // decoded frames waiting in m_spans
+    unsigned int m_uMaxFrames;
+    frame_s *m_pCurFrame;         // handed out by GetFrame()
+    std::vector<frame_s *> m_vFreeFrames;
+};
+
+#endif // GOP_DECODER_H
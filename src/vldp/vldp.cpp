@@ -38,22 +38,15 @@ SDL_Thread *private_thread = NULL;
 
 int p_initialized = 0; // whether VLDP has been initialized
 
-Uint8 g_req_cmdORcount = CMDORCOUNT_INITIAL;  // the current command parent
-                                              // thread requests of the child
-                                              // thread
-unsigned int g_ack_count = ACK_COUNT_INITIAL; // the result returned by the
-                                              // internal child thread
-char g_req_file[STRSIZE];                     // requested mpeg filename
-Uint32 g_req_timer       = 0; // requests timer value to be used for mpeg playback
-Uint32 g_req_frame       = 0; // requested frame to search to
-Uint32 g_req_min_seek_ms = 0; // seek must take at least this many milliseconds
-                              // (simulate laserdisc seek delay)
-VLDP_BOOL g_req_precache          = VLDP_FALSE; // whether g_req_idx has any meaning
-uint32_t g_req_idx                 = 0; // multipurpose index (used by precaching)
-unsigned int g_req_skip_per_frame = 0; // how many frames to skip per frame (for
-                                       // playing at 2X for example)
-unsigned int g_req_stall_per_frame = 0; // how many frames to stall per frame
-                                        // (for playing at 1/2X for example)
+struct vldp_req_s g_req;       // the current command parent thread requests
+                               // of the child thread
+SDL_atomic_t g_req_seq = {0};  // bumped for every command issued
+Uint32 g_ack_seq       = 0;    // the last command the child thread
+                               // acknowledged
+SDL_mutex *g_cmd_mutex  = NULL;
+SDL_cond *g_cmd_cond    = NULL;
+SDL_cond *g_ack_cond    = NULL;
+SDL_cond *g_status_cond = NULL;
 struct vldp_out_info g_out_info; // contains info that the parent thread should
                                  // have access to
 const struct vldp_in_info *g_in_info; // contains info from parent thread that
@@ -69,28 +62,29 @@ VLDP_BOOL vldp_cmd(int cmd)
 {
     VLDP_BOOL result = VLDP_FALSE;
     Uint32 cur_time  = g_in_info->GetTicksFunc();
-    Uint8 tmp        = g_req_cmdORcount; // we want to replace the real value
-                                  // atomically so we use a tmp variable first
-    static unsigned int old_ack_count = ACK_COUNT_INITIAL;
-
-    tmp++; // increment the counter so child thread knows we're issuing a new
-           // command
-    tmp &= 0xF;             // strip off old command
-    tmp |= cmd;             // replace it with new command
-    g_req_cmdORcount = tmp; // here is the atomic replacement
-
-    // loop until we timeout or get a response
-    while ((g_in_info->GetTicksFunc() - cur_time) < VLDP_TIMEOUT) {
-        // if the count has changed, it means the other thread has acknowledged
-        // our new command
-        if (g_ack_count != old_ack_count) {
-            result        = VLDP_TRUE;
-            old_ack_count = g_ack_count; // prepare to receive the next command
+    Uint32 elapsed   = 0;
+
+    SDL_LockMutex(g_cmd_mutex);
+
+    // the arguments are already in g_req, publishing the new number hands the
+    // whole command over
+    g_req.cmd  = cmd;
+    Uint32 seq = (Uint32)SDL_AtomicGet(&g_req_seq) + 1;
+    SDL_AtomicSet(&g_req_seq, (int)seq);
+    SDL_CondSignal(g_cmd_cond); // wake the child thread if it is idle
+
+    // sleep until our command (and not some earlier one that timed out) is
+    // acknowledged
+    while ((elapsed = g_in_info->GetTicksFunc() - cur_time) < VLDP_TIMEOUT) {
+        if (g_ack_seq == seq) {
+            result = VLDP_TRUE;
             break;
         }
-        SDL_Delay(0); // switch to other thread
+        SDL_CondWaitTimeout(g_ack_cond, g_cmd_mutex, VLDP_TIMEOUT - elapsed);
     }
 
+    SDL_UnlockMutex(g_cmd_mutex);
+
     // if we weren't able to communicate, notify user
     if (!result) {
         fprintf(stderr, "VLDP error!  Timed out waiting for internal thread to "
@@ -109,17 +103,22 @@ int vldp_wait_for_status(int stat)
     int result      = 0; // assume error unless we explicitly
     int done        = 0;
     Uint32 cur_time = g_in_info->GetTicksFunc();
-    while (!done && ((g_in_info->GetTicksFunc() - cur_time) < VLDP_TIMEOUT)) {
+    Uint32 elapsed  = 0;
+
+    SDL_LockMutex(g_cmd_mutex);
+    while (!done && ((elapsed = g_in_info->GetTicksFunc() - cur_time) < VLDP_TIMEOUT)) {
         if (g_out_info.status == stat) {
             done   = 1;
             result = 1;
         } else if (g_out_info.status == STAT_ERROR) {
             done = 1;
         }
-        // else keep waiting
-        SDL_Delay(0); // switch to other thread, timing is critical so we delay
-                      // for 0
+        // else sleep until the status changes
+        else {
+            SDL_CondWaitTimeout(g_status_cond, g_cmd_mutex, VLDP_TIMEOUT - elapsed);
+        }
     }
+    SDL_UnlockMutex(g_cmd_mutex);
 
     // if we timed out but are busy, indicate that
     if (g_out_info.status == STAT_BUSY) {
@@ -127,7 +126,7 @@ int vldp_wait_for_status(int stat)
     }
 
     // else if we timed out
-    else if ((g_in_info->GetTicksFunc() - cur_time) >= VLDP_TIMEOUT) {
+    else if (!done) {
         fprintf(stderr, "VLDP ERROR!!!!  Timed out with getting our expected "
                         "response!\n");
     }
@@ -146,6 +145,13 @@ void vldp_shutdown()
                                               // terminate
     }
     p_initialized = 0;
+
+    if (g_status_cond) SDL_DestroyCond(g_status_cond);
+    if (g_ack_cond) SDL_DestroyCond(g_ack_cond);
+    if (g_cmd_cond) SDL_DestroyCond(g_cmd_cond);
+    if (g_cmd_mutex) SDL_DestroyMutex(g_cmd_mutex);
+    g_status_cond = g_ack_cond = g_cmd_cond = NULL;
+    g_cmd_mutex = NULL;
 }
 
 // requests that we open an mpeg file
@@ -162,8 +168,8 @@ int vldp_open(const char *filename)
         // if file exists, we can open it
         if (F) {
             fclose(F);
-            SAFE_STRCPY(g_req_file, filename, sizeof(g_req_file));
-            g_req_precache = VLDP_FALSE; // we're not precaching ...
+            SAFE_STRCPY(g_req.file, filename, sizeof(g_req.file));
+            g_req.precache = VLDP_FALSE; // we're not precaching ...
             result         = vldp_cmd(VLDP_REQ_OPEN);
         } else {
             fprintf(stderr, "VLDP ERROR : can't open file %s\n", filename);
@@ -180,15 +186,29 @@ VLDP_BOOL vldp_open_precached(uint32_t uIdx, const char *filename)
     if (p_initialized) {
         // even though we're using an index, we still need filename to compute
         // .dat filename
-        SAFE_STRCPY(g_req_file, filename, sizeof(g_req_file));
-        g_req_idx      = uIdx;
-        g_req_precache = VLDP_TRUE;
+        SAFE_STRCPY(g_req.file, filename, sizeof(g_req.file));
+        g_req.idx      = uIdx;
+        g_req.precache = VLDP_TRUE;
         bResult        = vldp_cmd(VLDP_REQ_OPEN);
     }
 
     return bResult;
 }
 
+// asks VLDP to open a file ahead of time; returns immediately, and VLDP gets
+// around to it when it isn't busy with anything else
+VLDP_BOOL vldp_preopen(const char *filename)
+{
+    VLDP_BOOL bResult = VLDP_FALSE;
+
+    if (p_initialized) {
+        SAFE_STRCPY(g_req.file, filename, sizeof(g_req.file));
+        bResult = vldp_cmd(VLDP_REQ_PREOPEN);
+    }
+
+    return bResult;
+}
+
 int vldp_open_and_block(const char *filename)
 {
     int result = 0;
@@ -214,7 +234,7 @@ VLDP_BOOL vldp_precache(const char *filename)
     VLDP_BOOL bResult = VLDP_FALSE;
 
     if (p_initialized) {
-        SAFE_STRCPY(g_req_file, filename, sizeof(g_req_file));
+        SAFE_STRCPY(g_req.file, filename, sizeof(g_req.file));
         bResult = vldp_cmd(VLDP_REQ_PRECACHE);
     }
     // else return false
@@ -229,8 +249,8 @@ int vldp_search(Uint32 frame, Uint32 min_seek_ms)
     int result = 0;
 
     if (p_initialized) {
-        g_req_frame       = frame;
-        g_req_min_seek_ms = min_seek_ms;
+        g_req.frame       = frame;
+        g_req.min_seek_ms = min_seek_ms;
         result            = vldp_cmd(VLDP_REQ_SEARCH);
     }
     return result;
@@ -242,8 +262,8 @@ int vldp_search_and_block(Uint32 frame, Uint32 min_seek_ms)
     int result = 0;
 
     if (p_initialized) {
-        g_req_frame       = frame;
-        g_req_min_seek_ms = min_seek_ms;
+        g_req.frame       = frame;
+        g_req.min_seek_ms = min_seek_ms;
         vldp_cmd(VLDP_REQ_SEARCH);
         result = vldp_wait_for_status(STAT_PAUSED);
     }
@@ -255,7 +275,7 @@ int vldp_play(Uint32 timer)
     int result = 0;
 
     if (p_initialized) {
-        g_req_timer = timer;
+        g_req.timer = timer;
         vldp_cmd(VLDP_REQ_PLAY);
         result = vldp_wait_for_status(STAT_PLAYING); // play could get an error
                                                      // if we're at EOF
@@ -270,8 +290,8 @@ int vldp_skip(Uint32 frame)
     // we can only skip if the mpeg is already playing (esp. since we don't
     // accept a timer as an argument)
     if (p_initialized && (g_out_info.status == STAT_PLAYING)) {
-        g_req_frame       = frame;
-        g_req_min_seek_ms = 0; // just for safety purposes, we want to ensure
+        g_req.frame       = frame;
+        g_req.min_seek_ms = 0; // just for safety purposes, we want to ensure
                                // that there is no minimum skip delay
         result = vldp_cmd(VLDP_REQ_SKIP);
 #ifdef VLDP_DEBUG
@@ -321,8 +341,8 @@ VLDP_BOOL vldp_speedchange(unsigned int uSkipPerFrame, unsigned int uStallPerFra
     VLDP_BOOL result = VLDP_FALSE;
 
     if (p_initialized) {
-        g_req_skip_per_frame  = uSkipPerFrame;
-        g_req_stall_per_frame = uStallPerFrame;
+        g_req.skip_per_frame  = uSkipPerFrame;
+        g_req.stall_per_frame = uStallPerFrame;
         result                = vldp_cmd(VLDP_REQ_SPEEDCHANGE);
     }
     return result;
@@ -361,6 +381,7 @@ const struct vldp_out_info *vldp_init(const struct vldp_in_info *in_info)
     g_out_info.shutdown         = vldp_shutdown;
     g_out_info.open             = vldp_open;
     g_out_info.open_precached   = vldp_open_precached;
+    g_out_info.preopen          = vldp_preopen;
     g_out_info.open_and_block   = vldp_open_and_block;
     g_out_info.precache         = vldp_precache;
     g_out_info.play             = vldp_play;
@@ -374,6 +395,21 @@ const struct vldp_out_info *vldp_init(const struct vldp_in_info *in_info)
     g_out_info.lock             = vldp_lock;
     g_out_info.unlock           = vldp_unlock;
 
+    g_out_info.uFramesDecoded = g_out_info.uFramesDropped = 0;
+
+    g_cmd_mutex   = SDL_CreateMutex();
+    g_cmd_cond    = SDL_CreateCond();
+    g_ack_cond    = SDL_CreateCond();
+    g_status_cond = SDL_CreateCond();
+    if (!g_cmd_mutex || !g_cmd_cond || !g_ack_cond || !g_status_cond) {
+        fprintf(stderr, "VLDP ERROR : could not create the command channel\n");
+        return NULL;
+    }
+
+    // nothing issued or acknowledged yet
+    SDL_AtomicSet(&g_req_seq, 0);
+    g_ack_seq = 0;
+
     private_thread = SDL_CreateThread(idle_handler, "vldp", (void *)NULL); // start our internal
                                                            // thread
 
@@ -88,6 +88,12 @@ struct vldp_in_info {
                                // render_blank_frame before every search
     int blank_during_skips;    // if this is non-zero, VLDP will call
                                // render_blank_frame before every skip
+    int unthrottled;           // if this is non-zero, uMsTimer may run much
+                               // faster than real time so don't oversleep
+                               // while waiting on it
+    unsigned int decode_threads; // how many threads to decode on ahead of
+                                 // playback (0 or 1 decodes on the VLDP
+                                 // thread itself)
     unsigned int uMsTimer;     // the timer that VLDP will use for everything
                                // (replaces SDL_GetTicks()). Calling thread is
                                // responsible for updating this timer!!
@@ -130,6 +136,14 @@ struct vldp_out_info {
     //  'open'.
     VLDP_BOOL (*open_precached)(uint32_t uIdx, const char *filename);
 
+    // Asks VLDP to open the indicated file (and load its frame offsets) ahead
+    //  of time, whenever it has a moment to spare, so that a later 'open' of
+    //  the same file doesn't have to wait for the disk.  VLDP keeps a couple
+    //  of these open at once, dropping the least recently used.
+    // Returns VLDP_TRUE if the request was received (not whether the file
+    //  could be opened).
+    VLDP_BOOL (*preopen)(const char *filename);
+
     // plays the mpeg that has been previously open.  'timer' is the value
     // relative to uMsTimer that
     // we should use for the beginning of the first frame that will be displayed
@@ -197,6 +211,10 @@ struct vldp_out_info {
                                 // are on
     unsigned int uLastCachedIndex; // the index of the file that was last
                                    // precached (if any)
+    unsigned int uFramesDecoded; // how many frames have been decoded (for
+                                 // benchmarking)
+    unsigned int uFramesDropped; // how many decoded frames were too late to be
+                                 // displayed (for benchmarking)
 
 };
 
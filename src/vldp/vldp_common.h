@@ -43,38 +43,48 @@
 #define VLDP_REQ_UNLOCK 0xB0
 #define VLDP_REQ_SPEEDCHANGE 0xC0
 #define VLDP_REQ_PRECACHE 0xD0
-
-// these are defined to emphasize the importance of the same value being
-// initialized in more than one place
-#define CMDORCOUNT_INITIAL 0
-#define ACK_COUNT_INITIAL 0
+#define VLDP_REQ_PREOPEN 0xE0
 
 // how big all our character arrays will be
 // (needs to be able to accomodate huge paths)
 #define STRSIZE 320
 
-extern Uint32 g_req_frame;       // which frame to seek to
-extern Uint32 g_req_min_seek_ms; // minimum # of milliseconds that this seek can
-                                 // take
-extern Uint32 g_req_timer;
-extern uint32_t g_req_idx;       // multipurpose index
-extern VLDP_BOOL g_req_precache;
-extern char g_req_file[];        // which file to open
-extern Uint8 g_req_cmdORcount;   // the current command count OR'd with the
-                                 // current command of parent thread
-                                 // made 8-bit to ensure that it's atomic
-extern unsigned int g_ack_count; // how many times we've acknowledged a command
+// A command from the parent thread along with its arguments.
+// The parent fills it in, then publishes it by bumping g_req_seq under
+// g_cmd_mutex and signalling g_cmd_cond.  The private thread acknowledges it by
+// setting g_ack_seq to the same number and signalling g_ack_cond.  Only one
+// command is outstanding at a time: the parent waits for each acknowledgement.
+struct vldp_req_s {
+    int cmd;                     // VLDP_REQ_*
+    char file[STRSIZE];          // which file to open
+    Uint32 timer;                // timer value to be used for mpeg playback
+    Uint32 frame;                // which frame to seek to
+    Uint32 min_seek_ms;          // minimum # of milliseconds that this seek
+                                 // can take
+    VLDP_BOOL precache;          // whether 'idx' has any meaning
+    uint32_t idx;                // multipurpose index (used by precaching)
+    unsigned int skip_per_frame; // how many frames to skip per frame (for
+                                 // playing at 2X for example)
+    unsigned int stall_per_frame; // how many frames to stall per frame (for
+                                  // playing at 1/2X for example)
+};
+
+extern struct vldp_req_s g_req;
+extern SDL_atomic_t g_req_seq; // number of the latest command
+extern Uint32 g_ack_seq;       // number of the latest acknowledged command
+                               // (guarded by g_cmd_mutex)
+
+extern SDL_mutex *g_cmd_mutex;  // guards g_req_seq changes, g_ack_seq and
+                                // g_out_info.status changes
+extern SDL_cond *g_cmd_cond;    // a new command was issued
+extern SDL_cond *g_ack_cond;    // a command was acknowledged
+extern SDL_cond *g_status_cond; // g_out_info.status changed
 
 extern struct vldp_out_info g_out_info; // contains info that the parent thread
                                         // should have access to
 extern const struct vldp_in_info *g_in_info; // contains info from parent thread
                                              // that VLDP should have access to
 
-extern unsigned int g_req_skip_per_frame;  // how many frames to skip per frame
-                                           // (for playing at 2X for example)
-extern unsigned int g_req_stall_per_frame; // how many frames to stall per frame
-                                           // (for playing at 1/2X for example)
-
 int idle_handler(void *);
 
 // how ms to wait for responses from the private thread before we give up and
@@ -34,7 +34,9 @@
 #include "vldp_internal.h"
 #include "vldp_common.h"
 #include "mpegscan.h"
+#include "gop_decoder.h"
 #include "../video/video.h"
+#include "../timer/tracer.h"
 
 #include <inttypes.h>
 
@@ -43,8 +45,7 @@
 // NOTICE : these variables should only be used by the private thread
 // !!!!!!!!!!!!
 
-Uint8 s_old_req_cmdORcount = CMDORCOUNT_INITIAL; // the last value of the
-                                                 // command byte we received
+Uint32 s_old_req_seq = 0; // the number of the last command we received
 int s_paused         = 0; // whether the video is to be paused
 int s_step_forward   = 0; // whether to step 1 frame forward
 int s_blanked        = 0; // whether the mpeg video is to be blanked
@@ -92,13 +93,28 @@ struct precache_entry_s s_sPreCacheEntries[MAX_PRECACHE_FILES]; // struct array
                                                                 // holding
                                                                 // precache data
 
-#define MAX_LDP_FRAMES 512000
+// Multi-file framefiles tend to jump back and forth between a handful of
+// segments, so the most recently used frame offset tables are kept in RAM and
+// don't have to be read back from their .DAT files every time.
+#define OFFSET_CACHE_SIZE 8
+struct offset_cache_entry_s s_sOffsetCache[OFFSET_CACHE_SIZE];
+uint32_t s_uOffsetCacheUseCount = 0; // bumped every time an entry is used
+
+// The parent thread asks for the mpegs next to the current one to be opened
+// ahead of time, so that switching to one of them doesn't wait on the disk.
+// Requests are queued up and carried out whenever we have nothing better to do
+// (while idle, paused, or between spans when the decoding threads are busy).
+#define PREOPEN_SLOTS 2
+struct preopen_entry_s s_sPreopened[PREOPEN_SLOTS];
+uint32_t s_uPreopenUseCount = 0; // bumped every time an entry is used
+static char s_szPreopenQueue[PREOPEN_SLOTS][STRSIZE]; // files waiting to be
+                                                      // opened
+static unsigned int s_uPreopenQueued = 0; // how many are in s_szPreopenQueue
 
 static FILE *g_mpeg_handle     = NULL; // mpeg file we currently have open
 static mpeg2dec_t *g_mpeg_data = NULL; // structure for libmpeg2's state
-static Uint32 g_frame_position[MAX_LDP_FRAMES] = {0}; // the file position of
-                                                      // each I frame
-static Uint32 g_totalframes = 0; // total # of frames in the current mpeg
+static FrameIndex g_frame_index; // the file position of each I frame of the
+                                 // current mpeg
 
 #define BUFFER_SIZE 262144
 static Uint8 g_buffer[BUFFER_SIZE]; // buffer to hold mpeg2 file as we read it
@@ -108,6 +124,15 @@ static Uint8 g_buffer[BUFFER_SIZE]; // buffer to hold mpeg2 file as we read it
 static Uint8 g_header_buf[HEADER_BUF_SIZE];
 static uint32_t g_header_buf_size = 0; // size of the header buffer
 
+// decodes ahead on other threads (if more than one decoding thread was asked
+// for)
+static GOPDecoder g_gop_decoder;
+
+// where in the file libmpeg2 was last reset to decode from, or NO_POS once it
+// has decoded past that point.  The decoding threads can only take over from
+// such a point.
+static Uint32 s_uCleanStartPos = GOPDecoder::NO_POS;
+
 // how many frames we will stall after beginning playback (should be 1, because
 // presumably before we start playing, the disc has been paused showing the same
 // frame, and we want the frame to display 1 more frame before moving to the
@@ -123,8 +148,17 @@ int idle_handler(void *surface)
 {
     int done = 0;
 
+    TRACE_THREAD_NAME("vldp");
+
     g_mpeg_data = mpeg2_init();
 
+    if (g_in_info->decode_threads > 1) {
+        if (!g_gop_decoder.Start(g_in_info->decode_threads)) {
+            fprintf(stderr, "VLDP : Could not start the decoding threads, "
+                            "decoding on this one\n");
+        }
+    }
+
     // unless we are drawing video to the screen, we just sit here
     // and listen for orders from the parent thread
     while (!done) {
@@ -132,7 +166,7 @@ int idle_handler(void *surface)
         // (so we don't go to sleep on skips)
         while (ivldp_got_new_command() && !done) {
             // examine the actual command (strip off the count)
-            switch (g_req_cmdORcount & 0xF0) {
+            switch (g_req.cmd) {
             case VLDP_REQ_QUIT:
                 done = 1;
                 break;
@@ -142,6 +176,9 @@ int idle_handler(void *surface)
             case VLDP_REQ_PRECACHE:
                 idle_handler_precache();
                 break;
+            case VLDP_REQ_PREOPEN:
+                ivldp_queue_preopen();
+                break;
             case VLDP_REQ_PLAY:
                 idle_handler_play();
                 break;
@@ -155,7 +192,7 @@ int idle_handler(void *surface)
                                  // this is an error
             case VLDP_REQ_STOP:  // stop command while we're already idle? this
                                  // is an error
-                g_out_info.status = STAT_ERROR;
+                ivldp_set_status(STAT_ERROR);
                 ivldp_ack_command();
                 break;
             case VLDP_REQ_LOCK:
@@ -174,14 +211,13 @@ int idle_handler(void *surface)
                                          // overlay gets drawn even if there is
                                          // no video being played
 
-        /* we need to delay here because otherwise, this idle loop will execute
-         * at 100% cpu speed and really slow things down It shouldn't hurt us
-         * when we get a command that requires immediate attention (such as
-         * skip) because of the inner while loop above (while
-         * ivldp_got_new_command)
-         * NOTE : we want to delay for about 1 frame (or field) here
+        // nothing else to do, so get the next mpeg ready
+        if (!ivldp_got_new_command()) ivldp_service_preopen();
+
+        /* sleep until the next command, but wake up after about 1 frame (or
+         * field) regardless so the blank frame above keeps getting drawn
          */
-        SDL_Delay(16); // 1 field is 16.666ms assuming 60 hz
+        ivldp_wait_for_command(16); // 1 field is 16.666ms assuming 60 hz
 
     } // end while we have not received a quit command
 
@@ -195,7 +231,8 @@ int idle_handler(void *surface)
     }
     */
 
-    g_out_info.status = STAT_ERROR;
+    ivldp_set_status(STAT_ERROR);
+    g_gop_decoder.Stop();
     mpeg2_close(g_mpeg_data);              // shutdown libmpeg2
 
     // de-allocate any files that have been precached
@@ -204,6 +241,20 @@ int idle_handler(void *surface)
         free(s_sPreCacheEntries[s_uPreCacheIdxCount].ptrBuf);
     }
 
+    // and any cached frame offset tables
+    for (unsigned int i = 0; i < OFFSET_CACHE_SIZE; i++) {
+        delete s_sOffsetCache[i].pIndex;
+        s_sOffsetCache[i].pIndex = NULL;
+    }
+
+    // and any mpegs that were opened ahead of time
+    for (unsigned int i = 0; i < PREOPEN_SLOTS; i++) {
+        if (s_sPreopened[i].handle) {
+            fclose(s_sPreopened[i].handle);
+            s_sPreopened[i].handle = NULL;
+        }
+    }
+
     ivldp_ack_command(); // acknowledge quit command
 
     return 0;
@@ -212,14 +263,7 @@ int idle_handler(void *surface)
 // returns 1 if there is a new command waiting for us or 0 otherwise
 int ivldp_got_new_command()
 {
-    int result = 0;
-
-    // if they are no longer equal
-    if (g_req_cmdORcount != s_old_req_cmdORcount) {
-        result = 1;
-    }
-
-    return result;
+    return ((Uint32)SDL_AtomicGet(&g_req_seq) != s_old_req_seq);
 }
 
 // acknowledges a command sent by the parent thread
@@ -227,8 +271,30 @@ int ivldp_got_new_command()
 // it creates too much latency
 void ivldp_ack_command()
 {
-    s_old_req_cmdORcount = g_req_cmdORcount;
-    g_ack_count++; // here is where we acknowledge
+    SDL_LockMutex(g_cmd_mutex);
+    s_old_req_seq = (Uint32)SDL_AtomicGet(&g_req_seq);
+    g_ack_seq     = s_old_req_seq; // here is where we acknowledge
+    SDL_CondSignal(g_ack_cond);
+    SDL_UnlockMutex(g_cmd_mutex);
+}
+
+// sleeps until the parent thread issues a command, or for uMs at most
+void ivldp_wait_for_command(Uint32 uMs)
+{
+    SDL_LockMutex(g_cmd_mutex);
+    if (!ivldp_got_new_command()) {
+        SDL_CondWaitTimeout(g_cmd_cond, g_cmd_mutex, uMs);
+    }
+    SDL_UnlockMutex(g_cmd_mutex);
+}
+
+// changes the status and wakes the parent thread if it is waiting for it
+void ivldp_set_status(int status)
+{
+    SDL_LockMutex(g_cmd_mutex);
+    g_out_info.status = status;
+    SDL_CondSignal(g_status_cond);
+    SDL_UnlockMutex(g_cmd_mutex);
 }
 
 void ivldp_lock_handler()
@@ -239,13 +305,21 @@ void ivldp_lock_handler()
     ivldp_ack_command();
     {
         VLDP_BOOL bLocked = VLDP_TRUE;
+        Uint32 uIgnoredSeq = s_old_req_seq; // a command we have complained about
 
         // the user should unlock immediately after locking, so we need not
         // check for other commands
         while (bLocked == VLDP_TRUE) {
-            SDL_Delay(1);
-            if (ivldp_got_new_command()) {
-                switch (g_req_cmdORcount & 0xF0) {
+            // (a command we won't take stays pending, so sleep until it changes)
+            SDL_LockMutex(g_cmd_mutex);
+            if ((Uint32)SDL_AtomicGet(&g_req_seq) == uIgnoredSeq) {
+                SDL_CondWaitTimeout(g_cmd_cond, g_cmd_mutex, 16);
+            }
+            SDL_UnlockMutex(g_cmd_mutex);
+
+            Uint32 uSeq = (Uint32)SDL_AtomicGet(&g_req_seq);
+            if (ivldp_got_new_command() && (uSeq != uIgnoredSeq)) {
+                switch (g_req.cmd) {
                 case VLDP_REQ_UNLOCK:
 #ifdef VLDP_DEBUG
                     fprintf(stderr, "DBG: VLDP REQ UNLOCK RECEIVED!!!\n");
@@ -253,10 +327,14 @@ void ivldp_lock_handler()
                     ivldp_ack_command();
                     bLocked = VLDP_FALSE;
                     break;
+                case VLDP_REQ_PREOPEN: // harmless, it waits for later anyway
+                    ivldp_queue_preopen();
+                    break;
                 default:
                     fprintf(stderr, "WARNING : lock handler received a command "
                                     "%x that wasn't to unlock it\n",
-                            g_req_cmdORcount);
+                            g_req.cmd);
+                    uIgnoredSeq = uSeq;
                     break;
                 }
             }
@@ -271,7 +349,7 @@ void paused_handler()
     // the moment we render the still frame, we need to reset the FPS timer so
     // we don't try to catch-up
     if (g_out_info.status != STAT_PAUSED) {
-        g_out_info.status = STAT_PAUSED;
+        ivldp_set_status(STAT_PAUSED);
 
         // reset these vars because otherwise draw_frame will loop
         // redundantly for no good reason
@@ -289,7 +367,7 @@ void paused_handler()
     // if we have a new command coming in
     if (ivldp_got_new_command()) {
         // strip off the count and examine the command
-        switch (g_req_cmdORcount & 0xF0) {
+        switch (g_req.cmd) {
         case VLDP_REQ_PLAY:
             ivldp_respond_req_play();
             break;
@@ -311,6 +389,9 @@ void paused_handler()
             ivldp_ack_command();
             s_step_forward = 1;
             break;
+        case VLDP_REQ_PREOPEN:
+            ivldp_queue_preopen();
+            break;
         case VLDP_REQ_LOCK:
             ivldp_lock_handler();
             break;
@@ -318,11 +399,17 @@ void paused_handler()
                  // know how to handle, just ignore it
             fprintf(stderr, "WARNING : pause handler received command %x that "
                             "it is ignoring\n",
-                    g_req_cmdORcount);
+                    g_req.cmd);
             ivldp_ack_command(); // acknowledge the command
             break;
         } // end switch
     }     // end if we have a new command coming in
+
+    // we're just showing a still frame, so there is time to get the next mpeg
+    // ready
+    else {
+        ivldp_service_preopen();
+    }
 }
 
 // the handler we call if we're playing
@@ -332,7 +419,7 @@ void play_handler()
     // if we've received a new incoming command
     if (ivldp_got_new_command()) {
         // strip off count and examine command
-        switch (g_req_cmdORcount & 0xF0) {
+        switch (g_req.cmd) {
         case VLDP_REQ_NONE: // no incoming command
             break;
         case VLDP_REQ_PAUSE:
@@ -342,6 +429,10 @@ void play_handler()
         case VLDP_REQ_SPEEDCHANGE:
             ivldp_respond_req_speedchange();
             break;
+        case VLDP_REQ_PREOPEN:
+            ivldp_queue_preopen(); // don't open anything in the middle of
+                                   // playback, it can wait
+            break;
         case VLDP_REQ_STOP:
         case VLDP_REQ_QUIT:
         case VLDP_REQ_OPEN:
@@ -408,6 +499,7 @@ void ivldp_set_framerate(Uint8 frame_rate_code)
 // decode_mpeg2 function taken from mpeg2dec.c and optimized a bit
 static void decode_mpeg2(uint8_t *current, uint8_t *end)
 {
+    TRACE_SCOPE("decode_mpeg2");
     const mpeg2_info_t *info;
     mpeg2_state_t state;
 
@@ -422,13 +514,23 @@ static void decode_mpeg2(uint8_t *current, uint8_t *end)
             return;
         case STATE_SEQUENCE:
             break;
+        case STATE_PICTURE:
+            // Nothing refers to a B frame, so the ones a search is skipping
+            // over don't need decoding.  libmpeg2 still hands them to
+            // draw_frame(), so the skip count stays right.
+            mpeg2_skip(g_mpeg_data, (s_frames_to_skip > 0) &&
+                                        ((info->current_picture->flags &
+                                          PIC_MASK_CODING_TYPE) ==
+                                         PIC_FLAG_CODING_TYPE_B));
+            break;
         case STATE_SLICE:
         case STATE_END:
         case STATE_INVALID_END:
             /* draw current picture */
             /* might free frame buffer */
             if (info->display_fbuf) {
-                draw_frame(info);
+                draw_frame(info->display_fbuf->buf, info->sequence->width,
+                           info->sequence->chroma_width);
             }
             break;
         default:
@@ -488,17 +590,17 @@ void idle_handler_open()
     int sAspect = 0;
     int dCurAspectRatio = 0;
     char req_file[STRSIZE] = {0};
-    uint32_t req_idx  = g_req_idx;
-    VLDP_BOOL req_precache = g_req_precache;
+    uint32_t req_idx  = g_req.idx;
+    VLDP_BOOL req_precache = g_req.precache;
     VLDP_BOOL bSuccess     = VLDP_FALSE;
 
     // after we ack the command, this string could become clobbered at any time
-    SAFE_STRCPY(req_file, g_req_file, sizeof(req_file));
+    SAFE_STRCPY(req_file, g_req.file, sizeof(req_file));
 
     // NOTE : it is very important that we change our status to BUSY before
     // acknowledging the command, because our previous status could be
     // STAT_ERROR, which causes problems with the *_and_block commands.
-    g_out_info.status = STAT_BUSY; // make us busy while opening the file
+    ivldp_set_status(STAT_BUSY); // make us busy while opening the file
     ivldp_ack_command();           // acknowledge open command
 
     // reset libmpeg2 so it is prepared to begin reading from a new m2v file
@@ -575,14 +677,15 @@ void idle_handler_open()
                                               // faster seeking
 
                 io_seek(0); // seek back to beginning of file
+                s_uCleanStartPos = 0;
 
-                g_out_info.status = STAT_STOPPED; // now that the file is open,
-                                                  // we're ready to play
+                ivldp_set_status(STAT_STOPPED); // now that the file is open,
+                                                // we're ready to play
             } else {
                 io_close();
                 fprintf(stderr,
                         "VLDP PARSE ERROR : Is the video stream damaged?\n");
-                g_out_info.status = STAT_ERROR; // change from BUSY to ERROR
+                ivldp_set_status(STAT_ERROR); // change from BUSY to ERROR
             }
         } // end if a proper mpeg header was found
 
@@ -591,12 +694,12 @@ void idle_handler_open()
             io_close();
             fprintf(stderr, "VLDP ERROR : Did not find expected header.  Is "
                             "this mpeg stream demultiplexed??\n");
-            g_out_info.status = STAT_ERROR;
+            ivldp_set_status(STAT_ERROR);
         }
     } // end if file exists
     else {
         fprintf(stderr, "VLDP ERROR : Could not open file!\n");
-        g_out_info.status = STAT_ERROR;
+        ivldp_set_status(STAT_ERROR);
     }
 #ifdef VLDP_DEBUG
     printf("idle_handler_open returning ...\n");
@@ -608,13 +711,13 @@ void idle_handler_precache()
 {
     char req_file[STRSIZE] = {0};
 
-    SAFE_STRCPY(req_file, g_req_file,
+    SAFE_STRCPY(req_file, g_req.file,
                 sizeof(req_file)); // after we ack the command, this string
                                    // could become clobbered at any time
 
     // always set the status before acknowledging the command so previous status
     // doesn't get through
-    g_out_info.status = STAT_BUSY; // make us busy while opening the file
+    ivldp_set_status(STAT_BUSY); // make us busy while opening the file
     ivldp_ack_command();
 
     // if we still have room in our array to precache ...
@@ -679,22 +782,22 @@ void idle_handler_precache()
                 // index is correct for that operation)
                 ++s_uPreCacheIdxCount;
 
-                g_out_info.status = STAT_STOPPED; // success
+                ivldp_set_status(STAT_STOPPED); // success
             }
             // else malloc failed
             else {
-                g_out_info.status = STAT_ERROR;
+                ivldp_set_status(STAT_ERROR);
             }
             fclose(F);
         }
         // else we couldn't open the file
         else {
-            g_out_info.status = STAT_ERROR;
+            ivldp_set_status(STAT_ERROR);
         }
     }
     // else we're out of room, so return an error
     else {
-        g_out_info.status = STAT_ERROR;
+        ivldp_set_status(STAT_ERROR);
     }
 }
 
@@ -714,18 +817,18 @@ void idle_handler_play()
 // responds to play request
 void ivldp_respond_req_play()
 {
-    s_timer = g_req_timer;
+    s_timer = g_req.timer;
 #ifdef VLDP_DEBUG
-    fprintf(stderr, "ivldp_respond_req_play() : g_req_timer is %u, and "
+    fprintf(stderr, "ivldp_respond_req_play() : g_req.timer is %u, and "
                     "uMstimer is %u\n",
-            g_req_timer, g_in_info->uMsTimer);   // REMOVE ME
+            g_req.timer, g_in_info->uMsTimer);   // REMOVE ME
 #endif                                           // VLDP_DEBUG
     s_uFramesShownSinceTimer = PLAY_FRAME_STALL; // we want to render the
                                                  // currently shown frame for 1
                                                  // frame before moving on
-    g_out_info.status = STAT_PLAYING; // we strive for instant response (and
-                                      // catch-up to maintain timing)
-    ivldp_ack_command();              // acknowledge the play command
+    ivldp_set_status(STAT_PLAYING); // we strive for instant response (and
+                                    // catch-up to maintain timing)
+    ivldp_ack_command();            // acknowledge the play command
     s_paused  = 0;                    // we to not want to pause on 1 frame
     s_blanked = 0;                    // we want to see the video
     // skip no frames, just play from current position
@@ -738,7 +841,7 @@ void ivldp_respond_req_play()
 void ivldp_respond_req_pause_or_step()
 {
     // if they've also requested a step forward
-    if ((g_req_cmdORcount & 0xF0) == VLDP_REQ_STEP_FORWARD) {
+    if (g_req.cmd == VLDP_REQ_STEP_FORWARD) {
         s_step_forward = 1;
     }
     // NOTE : by design, our status should not change until paused_handler is
@@ -757,16 +860,131 @@ void ivldp_respond_req_pause_or_step()
 //  is a speed change command
 void ivldp_respond_req_speedchange()
 {
-    s_skip_per_frame  = g_req_skip_per_frame;
-    s_stall_per_frame = g_req_stall_per_frame;
+    s_skip_per_frame  = g_req.skip_per_frame;
+    s_stall_per_frame = g_req.stall_per_frame;
     ivldp_ack_command();
 }
 
+// called when rendering has gone past the end of the mpeg
+static void ivldp_render_eof()
+{
+    ivldp_set_status(STAT_STOPPED); // it's a toss-up between this and
+                                    // STAT_PAUSED
+
+    // reset libmpeg2 so it is prepared to begin reading from the
+    // beginning of the file
+    mpeg2_reset(g_mpeg_data, 1);
+    io_seek(0);                   // seek to the beginning of the file
+    g_out_info.current_frame = 0; // set frame # to beginning of file
+                                  // where it belongs
+    s_uCleanStartPos = 0;
+}
+
+// returns 1 if a new command means we need to stop rendering
+static int ivldp_render_interrupted()
+{
+    int result = 0;
+
+    // if a new command is coming in, check to see if we need to stop
+    if (ivldp_got_new_command()) {
+        // check to see if we need to suddenly abort the rendering process
+        switch (g_req.cmd) {
+        case VLDP_REQ_QUIT:
+        case VLDP_REQ_OPEN:
+        case VLDP_REQ_SEARCH:
+        case VLDP_REQ_STOP:
+            ivldp_set_status(STAT_BUSY);
+            result = 1;
+            break;
+        case VLDP_REQ_SKIP:
+            // do not change the playing status because skips are supposed
+            // to be instant
+            result = 1;
+            break;
+        } // end switch
+    }     // end if they got a new command
+
+    return result;
+}
+
+// reads in a span (and the sequence header and lead-in that go before it) for
+// the decoding threads
+static VLDP_BOOL ivldp_queue_span(const GOPDecoder::span_pos_s &span)
+{
+    uint32_t uFrom = (span.uLeadStart != GOPDecoder::NO_POS) ? span.uLeadStart : span.uStart;
+    uint32_t uBytes = span.uEnd - uFrom;
+
+    // starting anywhere but the beginning is like a search
+    uint32_t uHeaderBytes = (uFrom != 0) ? g_header_buf_size : 0;
+
+    std::vector<Uint8> vData(uHeaderBytes + uBytes);
+    memcpy(&vData[0], g_header_buf, uHeaderBytes);
+
+    if (!io_seek(uFrom) || (io_read(&vData[uHeaderBytes], uBytes) != uBytes)) {
+        return VLDP_FALSE;
+    }
+
+    g_gop_decoder.Queue(vData, uHeaderBytes, span.uStart - uFrom);
+    return VLDP_TRUE;
+}
+
+// Renders from s_uCleanStartPos with the decoding threads working ahead.
+// draw_frame() gets the very same frames that decode_mpeg2() would have given
+// it, in the same order, so frame counting and timing work just as they do
+// there.
+static void ivldp_render_threaded()
+{
+    TRACE_SCOPE("ivldp_render_threaded");
+    GOPDecoder::span_cursor_s cursor;
+    GOPDecoder::span_pos_s span;
+    bool bMoreSpans      = true;
+    int render_finished  = 0;
+
+    GOPDecoder::InitCursor(cursor, &g_frame_index, io_length(), s_uCleanStartPos);
+    s_uCleanStartPos = GOPDecoder::NO_POS;
+
+    while (!render_finished) {
+        bool bQueued = false;
+
+        // keep every thread busy, with one more span ready to go
+        while (bMoreSpans &&
+               (g_gop_decoder.GetQueuedCount() <= g_gop_decoder.GetThreadCount())) {
+            bMoreSpans = GOPDecoder::NextSpan(cursor, span) && ivldp_queue_span(span);
+            bQueued    = true;
+        }
+
+        // the threads have a whole span to decode before we need them again,
+        // so this is a good time to get the next mpeg ready
+        if (bQueued && !ivldp_got_new_command()) ivldp_service_preopen();
+
+        const GOPDecoder::frame_s *pFrame = g_gop_decoder.GetFrame();
+
+        if (pFrame) {
+            draw_frame(pFrame->buf, pFrame->width, pFrame->chroma_width);
+        } else {
+            ivldp_render_eof();
+            render_finished = 1;
+        }
+
+        if (ivldp_render_interrupted()) {
+            // libmpeg2 never saw what the threads decoded, so leave it where
+            // it can pick up from (searches and skips reset it anyway)
+            mpeg2_reset(g_mpeg_data, 1);
+            io_seek(0);
+            s_uCleanStartPos = 0;
+            render_finished = 1;
+        }
+    }
+
+    g_gop_decoder.Reset();
+}
+
 // displays 1 or more frames to the screen, according to the state variables.
 // This function can be used to do both still frames and moving video.  Play and
 // search both use this function.
 void ivldp_render()
 {
+    TRACE_SCOPE("ivldp_render");
     Uint8 *end          = NULL;
     int render_finished = 0;
 
@@ -793,9 +1011,19 @@ void ivldp_render()
         render_finished = 1;
         fprintf(stderr, "VLDP RENDER ERROR : we tried to render an mpeg but "
                         "none was open!\n");
-        g_out_info.status = STAT_ERROR;
+        ivldp_set_status(STAT_ERROR);
     }
 
+    // the threads can only start from where libmpeg2 was reset to
+    // (and fields would have to be kept together, which spans don't do)
+    if (!render_finished && g_gop_decoder.IsStarted() &&
+        (s_uCleanStartPos != GOPDecoder::NO_POS) && !g_out_info.uses_fields) {
+        ivldp_render_threaded();
+        render_finished = 1;
+    }
+
+    s_uCleanStartPos = GOPDecoder::NO_POS; // libmpeg2 is about to move on
+
     // while we're not finished playing and pausing
     while (!render_finished) {
         // end = g_buffer + fread (g_buffer, 1, BUFFER_SIZE, g_mpeg_handle);
@@ -811,37 +1039,12 @@ void ivldp_render()
         // if we've read to the end of the mpeg2 file, then we can't play
         // anymore, so we pause on last frame
         if (end != (g_buffer + BUFFER_SIZE)) {
-            g_out_info.status = STAT_STOPPED; // it's a toss-up between this and
-                                              // STAT_PAUSED
+            ivldp_render_eof();
             render_finished = 1;
-
-            // reset libmpeg2 so it is prepared to begin reading from the
-            // beginning of the file
-            mpeg2_reset(g_mpeg_data, 1);
-            io_seek(0);                   // seek to the beginning of the file
-            g_out_info.current_frame = 0; // set frame # to beginning of file
-                                          // where it belongs
         }
 
-        // if a new command is coming in, check to see if we need to stop
-        if (ivldp_got_new_command()) {
-            // check to see if we need to suddenly abort the rendering process
-            switch (g_req_cmdORcount & 0xF0) {
-            case VLDP_REQ_QUIT:
-            case VLDP_REQ_OPEN:
-            case VLDP_REQ_SEARCH:
-            case VLDP_REQ_STOP:
-                g_out_info.status = STAT_BUSY;
-                render_finished   = 1;
-                break;
-            case VLDP_REQ_SKIP:
-                // do not change the playing status because skips are supposed
-                // to be instant
-                render_finished = 1;
-                break;
-            } // end switch
-        }     // end if they got a new command
-    }         // end while
+        if (ivldp_render_interrupted()) render_finished = 1;
+    } // end while
 
 #ifdef VLDP_BENCHMARK
     fprintf(F, "Benchmarking result:\n");
@@ -866,10 +1069,11 @@ void ivldp_render()
 // and not adjust any timers)
 void idle_handler_search(int skip)
 {
+    TRACE_SCOPE("idle_handler_search");
     Uint32 proposed_pos = 0;
-    Uint32 req_frame    = g_req_frame; // after we acknowledge the command,
-                                       // g_req_frame could become clobbered
-    Uint32 min_seek_ms = g_req_min_seek_ms; // g_req_min_seek_ms can be
+    Uint32 req_frame    = g_req.frame; // after we acknowledge the command,
+                                       // g_req.frame could become clobbered
+    Uint32 min_seek_ms = g_req.min_seek_ms; // g_req.min_seek_ms can be
                                             // clobbered at any time after we
                                             // acknowledge command
 
@@ -882,7 +1086,7 @@ void idle_handler_search(int skip)
     // status must be changed before acknowledging command, because previous
     // status could be STAT_ERROR, which causes problems with *_and_block vldp
     // API commands.
-    if (!skip) g_out_info.status = STAT_BUSY;
+    if (!skip) ivldp_set_status(STAT_BUSY);
     // else we're skipping
     // (our status is already STAT_PLAYING so we don't need to set it)
     else {
@@ -986,9 +1190,10 @@ void idle_handler_search(int skip)
     actual_frame = uAdjustedReqFrame;
 
     // do a bounds check
-    if (uAdjustedReqFrame < g_totalframes) {
-        proposed_pos = g_frame_position[uAdjustedReqFrame]; // get the proposed
-                                                            // position
+    if (uAdjustedReqFrame < g_frame_index.GetFrameCount()) {
+        proposed_pos = g_frame_index.GetPosition(uAdjustedReqFrame); // get the
+                                                                     // proposed
+                                                                     // position
 
 #ifdef VLDP_DEBUG
         printf("Initial proposed position is : %x\n", proposed_pos);
@@ -1004,7 +1209,7 @@ void idle_handler_search(int skip)
             while ((proposed_pos == 0xFFFFFFFF) && (actual_frame > 0)) {
                 s_frames_to_skip++;
                 actual_frame--;
-                proposed_pos = g_frame_position[actual_frame];
+                proposed_pos = g_frame_index.GetPosition(actual_frame);
             }
             skipped_I++;
 
@@ -1032,6 +1237,7 @@ void idle_handler_search(int skip)
         io_seek(proposed_pos);
         // go to the place in the stream where the I frame begins
         // fseek(g_mpeg_handle, proposed_pos, SEEK_SET);
+        s_uCleanStartPos = proposed_pos;
 
         // if we're seeking, we can change the frame right now ...
         if (!skip) {
@@ -1054,8 +1260,64 @@ void idle_handler_search(int skip)
         fprintf(stderr, "SEARCH ERROR : frame %u was requested, but it is out "
                         "of bounds\n",
                 req_frame);
-        g_out_info.status = STAT_ERROR;
+        ivldp_set_status(STAT_ERROR);
+    }
+}
+
+// returns the offset cache entry for 'datafilename' or NULL if there isn't one
+static struct offset_cache_entry_s *ivldp_offset_cache_find(const char *datafilename,
+                                                            uint32_t mpeg_size)
+{
+    for (unsigned int i = 0; i < OFFSET_CACHE_SIZE; i++) {
+        struct offset_cache_entry_s *entry = &s_sOffsetCache[i];
+
+        // the size check catches an m2v that has been replaced while we were
+        // running
+        if (entry->pIndex && (entry->uMpegSize == mpeg_size) &&
+            (strcmp(entry->datafilename, datafilename) == 0)) {
+            entry->uLastUsed = ++s_uOffsetCacheUseCount;
+            return entry;
+        }
     }
+
+    return NULL;
+}
+
+// looks for the frame offsets of 'datafilename' in the offset cache, and
+// copies them into g_frame_index if they are there
+static VLDP_BOOL ivldp_offset_cache_lookup(const char *datafilename, uint32_t mpeg_size)
+{
+    struct offset_cache_entry_s *entry = ivldp_offset_cache_find(datafilename, mpeg_size);
+
+    if (entry) {
+        g_frame_index          = *entry->pIndex;
+        g_out_info.uses_fields = entry->uses_fields;
+        return VLDP_TRUE;
+    }
+
+    return VLDP_FALSE;
+}
+
+// stores the offsets that are in 'index' in the offset cache, replacing the
+// least recently used entry
+static void ivldp_offset_cache_store(const char *datafilename, uint32_t mpeg_size,
+                                     const FrameIndex &index, Uint8 uses_fields)
+{
+    struct offset_cache_entry_s *entry = &s_sOffsetCache[0];
+
+    for (unsigned int i = 1; (i < OFFSET_CACHE_SIZE) && entry->pIndex; i++) {
+        if (!s_sOffsetCache[i].pIndex ||
+            (s_sOffsetCache[i].uLastUsed < entry->uLastUsed)) {
+            entry = &s_sOffsetCache[i];
+        }
+    }
+
+    delete entry->pIndex;
+    entry->pIndex = new FrameIndex(index);
+    SAFE_STRCPY(entry->datafilename, datafilename, sizeof(entry->datafilename));
+    entry->uMpegSize   = mpeg_size;
+    entry->uses_fields = uses_fields;
+    entry->uLastUsed   = ++s_uOffsetCacheUseCount;
 }
 
 // parses an mpeg video stream to get its frame offsets, or if the parsing had
@@ -1076,6 +1338,11 @@ VLDP_BOOL ivldp_get_mpeg_frame_offsets(char *mpeg_name)
     SAFE_STRCPY(datafilename, mpeg_name, sizeof(datafilename));
     strcpy(&datafilename[strlen(mpeg_name) - 3], "dat");
 
+    // if we've had this file open recently, we don't need to touch the disk
+    if (ivldp_offset_cache_lookup(datafilename, mpeg_size)) {
+        return VLDP_TRUE;
+    }
+
     // loop until we get a good datafile or until we get an error
     while (!mpeg_datafile_good && result) {
         data_file = fopen(datafilename, "rb"); // check to see if datafile
@@ -1126,7 +1393,8 @@ VLDP_BOOL ivldp_get_mpeg_frame_offsets(char *mpeg_name)
     // if we didn't exit the loop because of an error, then we need to read the
     // datafile
     if (result && data_file) {
-        g_totalframes = 0;
+        Uint32 uPos = 0;
+        g_frame_index.Clear();
 
 #ifdef VLDP_DEBUG
 //		unlink("frame_report.txt");
@@ -1134,30 +1402,23 @@ VLDP_BOOL ivldp_get_mpeg_frame_offsets(char *mpeg_name)
 
         // read all the frame positions
         // if we don't read 4 bytes, it means we've hit the EOF and we're done
-        while (fread(&g_frame_position[g_totalframes], 4, 1, data_file) == 1) {
+        while (fread(&uPos, 4, 1, data_file) == 1) {
 #ifdef VLDP_DEBUG
 // FILE *tmp_F = fopen("frame_report.txt", "ab");
-// fprintf(tmp_F, "Frame %d has offset of %x\n", g_totalframes,
-//         g_frame_position[g_totalframes]);
+// fprintf(tmp_F, "Frame %d has offset of %x\n",
+//         g_frame_index.GetFrameCount(), uPos);
 // fclose(tmp_F);
 #endif
-            g_totalframes++;
-
-            // safety check, it is possible to make mpegs with too many frames
-            // to fit onto one CAV laserdisc
-            // (in fact I did this, and it caused a lot of problems in the debug
-            // stages hehe)
-            if (g_totalframes >= MAX_LDP_FRAMES) {
-                fprintf(stderr, "ERROR : Current mpeg has a huge number of frames, "
-                                "VLDP will ignore any frame above %u\n",
-                                MAX_LDP_FRAMES);
-                break;
-            }
+            g_frame_index.Add(uPos);
         }
 #ifdef VLDP_DEBUG
-        printf("*** g_totalframes is %u\n", g_totalframes);
-        printf("And frame 0's offset is %x\n", g_frame_position[0]);
+        printf("*** total frames is %u\n", g_frame_index.GetFrameCount());
+        printf("And frame 0's offset is %x\n", g_frame_index.GetPosition(0));
+        printf("The frame index takes %u bytes\n",
+               (unsigned int)g_frame_index.GetMemoryUsage());
 #endif
+        ivldp_offset_cache_store(datafilename, mpeg_size, g_frame_index,
+                                 g_out_info.uses_fields);
     }
 
     // close any files that are still open
@@ -1168,6 +1429,127 @@ VLDP_BOOL ivldp_get_mpeg_frame_offsets(char *mpeg_name)
     return result;
 }
 
+// queues up the file of a VLDP_REQ_PREOPEN command and acknowledges it
+// (the file gets opened later by ivldp_service_preopen)
+void ivldp_queue_preopen()
+{
+    char req_file[STRSIZE] = {0};
+
+    // after we ack the command, this string could become clobbered at any time
+    SAFE_STRCPY(req_file, g_req.file, sizeof(req_file));
+    ivldp_ack_command();
+
+    // if the queue is full, the oldest request is the least interesting one
+    if (s_uPreopenQueued == PREOPEN_SLOTS) {
+        memmove(s_szPreopenQueue[0], s_szPreopenQueue[1],
+                (PREOPEN_SLOTS - 1) * sizeof(s_szPreopenQueue[0]));
+        --s_uPreopenQueued;
+    }
+
+    SAFE_STRCPY(s_szPreopenQueue[s_uPreopenQueued], req_file, STRSIZE);
+    ++s_uPreopenQueued;
+}
+
+// Opens the next queued file (if any), and reads its frame offsets into the
+// offset cache if it has a good .DAT file.  Anything that would take a while
+// (such as parsing an mpeg that has no .DAT file yet) is left to the real open.
+void ivldp_service_preopen()
+{
+    char req_file[STRSIZE]   = {0};
+    char datafilename[320]   = {0};
+    struct preopen_entry_s *entry = &s_sPreopened[0];
+    FILE *F                  = NULL;
+    uint32_t mpeg_size       = 0;
+    struct stat filestats;
+
+    if (s_uPreopenQueued == 0) {
+        return;
+    }
+
+    SAFE_STRCPY(req_file, s_szPreopenQueue[0], sizeof(req_file));
+    --s_uPreopenQueued;
+    memmove(s_szPreopenQueue[0], s_szPreopenQueue[1],
+            s_uPreopenQueued * sizeof(s_szPreopenQueue[0]));
+
+    // if it's already open, it just becomes the most recently used
+    for (unsigned int i = 0; i < PREOPEN_SLOTS; i++) {
+        if (s_sPreopened[i].handle && (strcmp(s_sPreopened[i].file, req_file) == 0)) {
+            s_sPreopened[i].uLastUsed = ++s_uPreopenUseCount;
+            return;
+        }
+    }
+
+    TRACE_SCOPE("ivldp_service_preopen");
+
+    F = fopen(req_file, "rb");
+    if (!F) {
+        return; // the real open will complain about it
+    }
+
+    fstat(fileno(F), &filestats);
+    mpeg_size = (uint32_t)filestats.st_size;
+
+    SAFE_STRCPY(datafilename, req_file, sizeof(datafilename));
+    strcpy(&datafilename[strlen(req_file) - 3], "dat");
+
+    if (!ivldp_offset_cache_find(datafilename, mpeg_size)) {
+        FILE *data_file = fopen(datafilename, "rb");
+
+        if (data_file) {
+            struct dat_header header;
+
+            // same checks as ivldp_get_mpeg_frame_offsets, which will deal with
+            // a bad .DAT file when the mpeg is really opened
+            if ((fread(&header, sizeof(header), 1, data_file) == 1) &&
+                (header.length == mpeg_size) && (header.version == DAT_VERSION) &&
+                (header.finished == 1)) {
+                FrameIndex index;
+                Uint32 uPos = 0;
+
+                while (fread(&uPos, 4, 1, data_file) == 1) {
+                    index.Add(uPos);
+                }
+                ivldp_offset_cache_store(datafilename, mpeg_size, index,
+                                         header.uses_fields);
+            }
+            fclose(data_file);
+        }
+    }
+
+    // replace an empty entry or else the least recently used one
+    for (unsigned int i = 1; (i < PREOPEN_SLOTS) && entry->handle; i++) {
+        if (!s_sPreopened[i].handle ||
+            (s_sPreopened[i].uLastUsed < entry->uLastUsed)) {
+            entry = &s_sPreopened[i];
+        }
+    }
+
+    if (entry->handle) {
+        fclose(entry->handle);
+    }
+    entry->handle = F;
+    SAFE_STRCPY(entry->file, req_file, sizeof(entry->file));
+    entry->uLastUsed = ++s_uPreopenUseCount;
+}
+
+// hands over the handle of 'cpszFilename' if it was opened ahead of time,
+// rewound to the beginning, or returns NULL if it wasn't
+FILE *ivldp_take_preopened(const char *cpszFilename)
+{
+    for (unsigned int i = 0; i < PREOPEN_SLOTS; i++) {
+        struct preopen_entry_s *entry = &s_sPreopened[i];
+
+        if (entry->handle && (strcmp(entry->file, cpszFilename) == 0)) {
+            FILE *F       = entry->handle;
+            entry->handle = NULL;
+            rewind(F);
+            return F;
+        }
+    }
+
+    return NULL;
+}
+
 VLDP_BOOL ivldp_parse_mpeg_frame_offsets(char *datafilename, Uint32 mpeg_size)
 {
     VLDP_BOOL result = VLDP_TRUE;
@@ -1263,7 +1645,9 @@ VLDP_BOOL io_open(const char *cpszFilename)
 
     // make sure everything is closed
     if ((!s_bPreCacheEnabled) && (!g_mpeg_handle)) {
-        g_mpeg_handle = fopen(cpszFilename, "rb");
+        // no need to go to the disk if it was opened ahead of time
+        g_mpeg_handle = ivldp_take_preopened(cpszFilename);
+        if (!g_mpeg_handle) g_mpeg_handle = fopen(cpszFilename, "rb");
         if (g_mpeg_handle) bResult = VLDP_TRUE;
     }
     return bResult;
@@ -1375,12 +1759,15 @@ uint32_t io_length()
     return uResult;
 }
 
-void draw_frame(const mpeg2_info_t *info)
+void draw_frame(uint8_t *const *buf, int width, int chroma_width)
 {
+    TRACE_SCOPE("draw_frame");
     Sint32 correct_elapsed_ms = 0;
     Sint32 actual_elapsed_ms  = 0;
     unsigned int uStallFrames = 0;
 
+    ++g_out_info.uFramesDecoded;
+
     if (!(s_frames_to_skip | s_skip_all)) {
         do {
             VLDP_BOOL bFrameNotShownDueToCmd = VLDP_FALSE;
@@ -1395,20 +1782,19 @@ void draw_frame(const mpeg2_info_t *info)
 
             if (actual_elapsed_ms < (correct_elapsed_ms + (Sint32)g_out_info.u2milDivFpks)) {
                 int bPrepared = g_in_info->prepare_frame(
-                        info->display_fbuf->buf[0],
-                        info->display_fbuf->buf[1],
-                        info->display_fbuf->buf[2],
-                        info->sequence->width,
-                        info->sequence->chroma_width,
-                        info->sequence->chroma_width
+                        buf[0], buf[1], buf[2],
+                        width, chroma_width, chroma_width
                     );
                 if (bPrepared) {
 #ifndef VLDP_BENCHMARK
                     while (((Sint32)(g_in_info->uMsTimer - s_timer) < correct_elapsed_ms) &&
                            (!bFrameNotShownDueToCmd)) {
-                        SDL_Delay(1);
+                        // a 1 ms sleep would hold an unthrottled emulator back
+                        // (a new command cuts the sleep short)
+                        if (g_in_info->unthrottled) SDL_Delay(0);
+                        else ivldp_wait_for_command(1);
                         if (ivldp_got_new_command()) {
-                            switch (g_req_cmdORcount & 0xF0) {
+                            switch (g_req.cmd) {
                             case VLDP_REQ_PAUSE:
                             case VLDP_REQ_STEP_FORWARD:
                                 ivldp_respond_req_pause_or_step();
@@ -1416,6 +1802,9 @@ void draw_frame(const mpeg2_info_t *info)
                             case VLDP_REQ_SPEEDCHANGE:
                                 ivldp_respond_req_speedchange();
                                 break;
+                            case VLDP_REQ_PREOPEN:
+                                ivldp_queue_preopen();
+                                break;
                             case VLDP_REQ_NONE:
                                 break;
                             default:
@@ -1430,6 +1819,10 @@ void draw_frame(const mpeg2_info_t *info)
                     }
                 }
             }
+            // else we're too far behind to show this frame
+            else {
+                ++g_out_info.uFramesDropped;
+            }
 
             if (!bFrameNotShownDueToCmd) {
                 ++s_uFramesShownSinceTimer;
@@ -26,6 +26,7 @@
 #define VLDP_INTERNAL_H
 
 #include "vldp.h" // for the VLDP_BOOL definition and SDL.h
+#include "frame_index.h"
 
 #include <mpeg2.h>
 
@@ -46,10 +47,29 @@ struct precache_entry_s {
     uint32_t uPos;    // our current position within the stream
 };
 
+// a frame offset table (from a .DAT file) that is kept around after its mpeg
+// has been closed
+struct offset_cache_entry_s {
+    char datafilename[320]; // which .DAT file this came from
+    uint32_t uMpegSize;     // length of the m2v stream it was made for
+    Uint8 uses_fields;
+    FrameIndex *pIndex;     // NULL if this entry is unused
+    uint32_t uLastUsed;     // for picking which entry to replace
+};
+
+// an mpeg that was opened ahead of time (see VLDP_REQ_PREOPEN)
+struct preopen_entry_s {
+    char file[320];     // which file this is
+    FILE *handle;       // NULL if this entry is unused
+    uint32_t uLastUsed; // for picking which entry to replace
+};
+
 int idle_handler(void *surface);
 void blank_video();
 int ivldp_got_new_command();
 void ivldp_ack_command();
+void ivldp_wait_for_command(Uint32 uMs);
+void ivldp_set_status(int status);
 void ivldp_lock_handler();
 void paused_handler();
 void play_handler();
@@ -57,6 +77,8 @@ void ivldp_set_framerate(Uint8 frame_rate_code);
 void vldp_process_sequence_header();
 void idle_handler_open();
 void idle_handler_precache();
+void ivldp_queue_preopen();
+void ivldp_service_preopen();
 void idle_handler_play();
 void ivldp_respond_req_play();
 void ivldp_respond_req_pause_or_step();
@@ -67,6 +89,8 @@ VLDP_BOOL ivldp_get_mpeg_frame_offsets(char *mpeg_name);
 VLDP_BOOL ivldp_parse_mpeg_frame_offsets(char *datafilename, Uint32 mpeg_size);
 void ivldp_update_progress_indicator(SDL_Surface *indicator, double percentage_completed);
 
+FILE *ivldp_take_preopened(const char *cpszFilename);
+
 VLDP_BOOL io_open(const char *cpszFilename);
 VLDP_BOOL io_open_precached(uint32_t uIdx);
 unsigned int io_read(void *buf, unsigned int uBytesToRead);
@@ -75,11 +99,12 @@ void io_close();
 VLDP_BOOL io_is_open();
 uint32_t io_length();
 
-void draw_frame(const mpeg2_info_t *info);
+// draws the Y, U and V planes of a decoded frame
+void draw_frame(uint8_t *const *buf, int width, int chroma_width);
 
 ///////////////////////////////////////
 
-extern Uint8 s_old_req_cmdORcount; // the last value of the command byte we
+extern Uint32 s_old_req_seq;       // the number of the last command we
                                    // received
 extern int s_paused;               // whether the video is to be paused
 extern int s_blanked;              // whether the mpeg video is to be blanked